@@ -14,18 +14,82 @@
  */
 
 #include "fetch_result.h"
+#include <algorithm>
 #include "media_log.h"
 
 using namespace std;
 
+namespace OHOS {
+namespace Media {
 namespace {
-    const int ARG_INT32 = 0;
-    const int ARG_INT64 = 1;
-    const int ARG_STRING = 2;
+    template<typename T>
+    struct FileAssetColumn {
+        const std::string &name;
+        void (*set)(FileAsset &fileAsset, T value);
+    };
+
+    // Every column GetObject decodes, grouped by type so a row is read without any lookup by name
+    const vector<FileAssetColumn<int32_t>> INT32_COLUMNS {
+        { MEDIA_DATA_DB_ID, [](FileAsset &asset, int32_t value) { asset.SetId(value); } },
+        { MEDIA_DATA_DB_MEDIA_TYPE, [](FileAsset &asset, int32_t value) {
+            asset.SetMediaType(static_cast<MediaType>(value)); } },
+        { MEDIA_DATA_DB_PARENT_ID, [](FileAsset &asset, int32_t value) { asset.SetParent(value); } },
+        { MEDIA_DATA_DB_WIDTH, [](FileAsset &asset, int32_t value) { asset.SetWidth(value); } },
+        { MEDIA_DATA_DB_HEIGHT, [](FileAsset &asset, int32_t value) { asset.SetHeight(value); } },
+        { MEDIA_DATA_DB_DURATION, [](FileAsset &asset, int32_t value) { asset.SetDuration(value); } },
+        { MEDIA_DATA_DB_ORIENTATION, [](FileAsset &asset, int32_t value) { asset.SetOrientation(value); } },
+        { MEDIA_DATA_DB_BUCKET_ID, [](FileAsset &asset, int32_t value) { asset.SetAlbumId(value); } },
+        { MEDIA_DATA_DB_IS_PENDING, [](FileAsset &asset, int32_t value) { asset.SetPending(value != 0); } },
+        { MEDIA_DATA_DB_IS_FAV, [](FileAsset &asset, int32_t value) { asset.SetFavorite(value != 0); } },
+    };
+
+    const vector<FileAssetColumn<int64_t>> INT64_COLUMNS {
+        { MEDIA_DATA_DB_SIZE, [](FileAsset &asset, int64_t value) { asset.SetSize(value); } },
+        { MEDIA_DATA_DB_DATE_ADDED, [](FileAsset &asset, int64_t value) { asset.SetDateAdded(value); } },
+        { MEDIA_DATA_DB_DATE_MODIFIED, [](FileAsset &asset, int64_t value) { asset.SetDateModified(value); } },
+        { MEDIA_DATA_DB_DATE_TAKEN, [](FileAsset &asset, int64_t value) { asset.SetDateTaken(value); } },
+        { MEDIA_DATA_DB_TIME_PENDING, [](FileAsset &asset, int64_t value) { asset.SetTimePending(value); } },
+        { MEDIA_DATA_DB_DATE_TRASHED, [](FileAsset &asset, int64_t value) { asset.SetDateTrashed(value); } },
+    };
+
+    const vector<FileAssetColumn<const string &>> STRING_COLUMNS {
+        { MEDIA_DATA_DB_NAME, [](FileAsset &asset, const string &value) { asset.SetDisplayName(value); } },
+        { MEDIA_DATA_DB_RELATIVE_PATH, [](FileAsset &asset, const string &value) {
+            asset.SetRelativePath(value); } },
+        { MEDIA_DATA_DB_FILE_PATH, [](FileAsset &asset, const string &value) { asset.SetPath(value); } },
+        { MEDIA_DATA_DB_MIME_TYPE, [](FileAsset &asset, const string &value) { asset.SetMimeType(value); } },
+        { MEDIA_DATA_DB_TITLE, [](FileAsset &asset, const string &value) { asset.SetTitle(value); } },
+        { MEDIA_DATA_DB_ARTIST, [](FileAsset &asset, const string &value) { asset.SetArtist(value); } },
+        { MEDIA_DATA_DB_ALBUM, [](FileAsset &asset, const string &value) { asset.SetAlbum(value); } },
+        { MEDIA_DATA_DB_BUCKET_NAME, [](FileAsset &asset, const string &value) { asset.SetAlbumName(value); } },
+        { MEDIA_DATA_DB_SELF_ID, [](FileAsset &asset, const string &value) { asset.SetSelfId(value); } },
+    };
+
+    template<typename T>
+    vector<int32_t> ResolveColumns(DataShare::DataShareResultSet &resultset, const vector<FileAssetColumn<T>> &columns)
+    {
+        vector<int32_t> indexes;
+        indexes.reserve(columns.size());
+        for (const auto &column : columns) {
+            int32_t index = -1;
+            if (resultset.GetColumnIndex(column.name, index) != NativeRdb::E_OK) {
+                MEDIA_DEBUG_LOG("Column %{private}s not in the result set", column.name.c_str());
+                index = -1;
+            }
+            indexes.push_back(index);
+        }
+        return indexes;
+    }
+
+    template<typename T>
+    void AppendColumnNames(vector<string> &names, const vector<FileAssetColumn<T>> &columns)
+    {
+        for (const auto &column : columns) {
+            names.push_back(column.name);
+        }
+    }
 }
 
-namespace OHOS {
-namespace Media {
 FetchResult::FetchResult(const shared_ptr<DataShare::DataShareResultSet>& resultset)
 {
     count_ = 0;
@@ -109,6 +173,33 @@ unique_ptr<FileAsset> FetchResult::GetLastObject()
     return GetObject();
 }
 
+// Reads the rows [offset, offset + count) clipped to the result set, moving the cursor forward only
+vector<unique_ptr<FileAsset>> FetchResult::GetObjectRange(int32_t offset, int32_t count)
+{
+    vector<unique_ptr<FileAsset>> fileAssets;
+    if ((offset < 0) || (count <= 0) || (offset >= count_) || (resultset_ == nullptr)) {
+        MEDIA_ERR_LOG("range not proper or rs is null");
+        return fileAssets;
+    }
+
+    if (resultset_->GoToRow(offset) != 0) {
+        MEDIA_ERR_LOG("failed to go to row at range offset");
+        return fileAssets;
+    }
+
+    int32_t rowCount = min(count, count_ - offset);
+    fileAssets.reserve(rowCount);
+    fileAssets.push_back(GetObject());
+    for (int32_t i = 1; i < rowCount; i++) {
+        if (resultset_->GoToNextRow() != 0) {
+            MEDIA_ERR_LOG("failed to go to next row in range");
+            break;
+        }
+        fileAssets.push_back(GetObject());
+    }
+    return fileAssets;
+}
+
 bool FetchResult::IsAtLastRow()
 {
     if (resultset_ == nullptr) {
@@ -121,62 +212,40 @@ bool FetchResult::IsAtLastRow()
     return retVal;
 }
 
-variant<int32_t, int64_t, string> ReturnDefaultOnError(string errMsg, ResultSetDataType dataType)
+const vector<string> &FetchResult::GetFileAssetColumns()
 {
-    MEDIA_ERR_LOG("%{private}s", errMsg.c_str());
-    if ((dataType) == TYPE_STRING)
-        return "";
-    else
-        return 0;
+    static const vector<string> fileAssetColumns = [] {
+        vector<string> names;
+        names.reserve(INT32_COLUMNS.size() + INT64_COLUMNS.size() + STRING_COLUMNS.size());
+        AppendColumnNames(names, INT32_COLUMNS);
+        AppendColumnNames(names, INT64_COLUMNS);
+        AppendColumnNames(names, STRING_COLUMNS);
+        return names;
+    }();
+    return fileAssetColumns;
 }
 
-variant<int32_t, int64_t, string> FetchResult::GetRowValFromColumnn(string columnName, ResultSetDataType dataType)
+shared_ptr<DataShare::DataShareResultSet> FetchResult::GetResultSet() const
 {
-    int index;
-    variant<int32_t, int64_t, string> cellValue;
-    int integerVal = 0;
-    string stringVal = "";
-    int64_t longVal = 0;
-    int status;
-
-    if (resultset_ == nullptr) {
-        ReturnDefaultOnError("Resultset is null", dataType);
-    }
-
-    status = resultset_->GetColumnIndex(columnName, index);
-    if (status != NativeRdb::E_OK) {
-        ReturnDefaultOnError("failed to obtain the index", dataType);
-    }
+    return resultset_;
+}
 
-    switch (dataType) {
-        case TYPE_STRING:
-            status = resultset_->GetString(index, stringVal);
-            if (status != NativeRdb::E_OK) {
-                ReturnDefaultOnError("failed to obtain string value from resultset", dataType);
-            }
-            cellValue = stringVal;
-            break;
-        case TYPE_INT32:
-            status = resultset_->GetInt(index, integerVal);
-            if (status != NativeRdb::E_OK) {
-                ReturnDefaultOnError("failed to obtain int value from resultset", dataType);
-            }
-            cellValue = integerVal;
-            break;
-        case TYPE_INT64:
-            status = resultset_->GetLong(index, longVal);
-            if (status != NativeRdb::E_OK) {
-                ReturnDefaultOnError("failed to obtain long value from resultset", dataType);
-            }
+void FetchResult::SetResultSet(const shared_ptr<DataShare::DataShareResultSet> &resultset)
+{
+    resultset_ = resultset;
+    columnIndexes_ = ColumnIndexes();
+}
 
-            cellValue = longVal;
-            break;
-        default:
-            MEDIA_ERR_LOG("not match  dataType %{public}d!!!!!", dataType);
-            break;
+// Resolved once per result set, decoding a row then only reads cells by position
+const FetchResult::ColumnIndexes &FetchResult::GetColumnIndexes()
+{
+    if (!columnIndexes_.isResolved) {
+        columnIndexes_.isResolved = true;
+        columnIndexes_.int32Columns = ResolveColumns(*resultset_, INT32_COLUMNS);
+        columnIndexes_.int64Columns = ResolveColumns(*resultset_, INT64_COLUMNS);
+        columnIndexes_.stringColumns = ResolveColumns(*resultset_, STRING_COLUMNS);
     }
-
-    return cellValue;
+    return columnIndexes_;
 }
 
 static string GetFileMediaTypeUri(MediaType mediaType, const string& networkId)
@@ -198,57 +267,37 @@ static string GetFileMediaTypeUri(MediaType mediaType, const string& networkId)
 unique_ptr<FileAsset> FetchResult::GetObject()
 {
     unique_ptr<FileAsset> fileAsset = make_unique<FileAsset>();
+    if (resultset_ == nullptr) {
+        MEDIA_ERR_LOG("Resultset is null");
+        return fileAsset;
+    }
 
-    fileAsset->SetId(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_ID, TYPE_INT32)));
-
-    fileAsset->SetMediaType(static_cast<Media::MediaType>(get<ARG_INT32>(
-        GetRowValFromColumnn(MEDIA_DATA_DB_MEDIA_TYPE, TYPE_INT32))));
-
-    fileAsset->SetDisplayName(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_NAME, TYPE_STRING)));
-
-    fileAsset->SetRelativePath(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_RELATIVE_PATH, TYPE_STRING)));
-
-    fileAsset->SetParent(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_PARENT_ID, TYPE_INT32)));
-
-    fileAsset->SetSize(get<ARG_INT64>(GetRowValFromColumnn(MEDIA_DATA_DB_SIZE, TYPE_INT64)));
-
-    fileAsset->SetDateAdded(get<ARG_INT64>(GetRowValFromColumnn(MEDIA_DATA_DB_DATE_ADDED, TYPE_INT64)));
-
-    fileAsset->SetDateModified(get<ARG_INT64>(GetRowValFromColumnn(MEDIA_DATA_DB_DATE_MODIFIED, TYPE_INT64)));
-
-    fileAsset->SetDateTaken(get<ARG_INT64>(GetRowValFromColumnn(MEDIA_DATA_DB_DATE_TAKEN, TYPE_INT64)));
-
-    fileAsset->SetPath(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_FILE_PATH, TYPE_STRING)));
-
-    fileAsset->SetMimeType(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_MIME_TYPE, TYPE_STRING)));
-
-    fileAsset->SetTitle(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_TITLE, TYPE_STRING)));
-
-    fileAsset->SetArtist(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_ARTIST, TYPE_STRING)));
-
-    fileAsset->SetAlbum(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_ALBUM, TYPE_STRING)));
-
-    fileAsset->SetWidth(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_WIDTH, TYPE_INT32)));
-
-    fileAsset->SetHeight(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_HEIGHT, TYPE_INT32)));
-
-    fileAsset->SetDuration(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_DURATION, TYPE_INT32)));
-
-    fileAsset->SetOrientation(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_ORIENTATION, TYPE_INT32)));
-
-    fileAsset->SetAlbumId(get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_BUCKET_ID, TYPE_INT32)));
-
-    fileAsset->SetAlbumName(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_BUCKET_NAME, TYPE_STRING)));
-
-    fileAsset->SetTimePending(get<ARG_INT64>(GetRowValFromColumnn(MEDIA_DATA_DB_TIME_PENDING, TYPE_INT64)));
-
-    fileAsset->SetPending((get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_IS_PENDING, TYPE_INT32)) != 0));
-
-    fileAsset->SetFavorite((get<ARG_INT32>(GetRowValFromColumnn(MEDIA_DATA_DB_IS_FAV, TYPE_INT32)) != 0));
-
-    fileAsset->SetDateTrashed(get<ARG_INT64>(GetRowValFromColumnn(MEDIA_DATA_DB_DATE_TRASHED, TYPE_INT64)));
-
-    fileAsset->SetSelfId(get<ARG_STRING>(GetRowValFromColumnn(MEDIA_DATA_DB_SELF_ID, TYPE_STRING)));
+    // Cells that are missing or fail to read are skipped, their fields keep the FileAsset defaults
+    const ColumnIndexes &indexes = GetColumnIndexes();
+    for (size_t i = 0; i < INT32_COLUMNS.size(); i++) {
+        int32_t value = 0;
+        if ((indexes.int32Columns[i] < 0) ||
+            (resultset_->GetInt(indexes.int32Columns[i], value) != NativeRdb::E_OK)) {
+            continue;
+        }
+        INT32_COLUMNS[i].set(*fileAsset, value);
+    }
+    for (size_t i = 0; i < INT64_COLUMNS.size(); i++) {
+        int64_t value = 0;
+        if ((indexes.int64Columns[i] < 0) ||
+            (resultset_->GetLong(indexes.int64Columns[i], value) != NativeRdb::E_OK)) {
+            continue;
+        }
+        INT64_COLUMNS[i].set(*fileAsset, value);
+    }
+    for (size_t i = 0; i < STRING_COLUMNS.size(); i++) {
+        string value;
+        if ((indexes.stringColumns[i] < 0) ||
+            (resultset_->GetString(indexes.stringColumns[i], value) != NativeRdb::E_OK)) {
+            continue;
+        }
+        STRING_COLUMNS[i].set(*fileAsset, value);
+    }
 
     fileAsset->SetUri(GetFileMediaTypeUri(fileAsset->GetMediaType(), networkId_)
         + "/" + to_string(fileAsset->GetId()));
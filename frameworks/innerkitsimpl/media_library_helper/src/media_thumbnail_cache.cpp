@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "media_thumbnail_cache.h"
+#include "bytrace.h"
+#include "media_log.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+// A single entry may take at most this part of the budget, larger ones are not cached
+static constexpr size_t THUMBNAIL_CACHE_ENTRY_DIVISOR = 4;
+
+static unique_ptr<PixelMap> CopyPixelMap(PixelMap &source)
+{
+    InitializationOptions opts = {
+        .size = {
+            .width = source.GetWidth(),
+            .height = source.GetHeight()
+        },
+        .pixelFormat = source.GetPixelFormat(),
+        .alphaType = source.GetAlphaType()
+    };
+    return PixelMap::Create(source, opts);
+}
+
+MediaThumbnailCache *MediaThumbnailCache::GetInstance()
+{
+    static MediaThumbnailCache thumbnailCache;
+    return &thumbnailCache;
+}
+
+unique_ptr<PixelMap> MediaThumbnailCache::Get(const string &key, const Size &size)
+{
+    shared_ptr<PixelMap> pixelMap;
+    {
+        lock_guard<mutex> lock(lock_);
+        auto iter = index_.find(make_tuple(key, size.width, size.height));
+        if (iter != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            pixelMap = iter->second->pixelMap;
+        }
+    }
+    if (pixelMap == nullptr) {
+        misses_++;
+        return nullptr;
+    }
+
+    // Copy outside the lock, the cached PixelMap is only ever read
+    StartTrace(BYTRACE_TAG_OHOS, "MediaThumbnailCache::Get CopyPixelMap");
+    unique_ptr<PixelMap> copy = CopyPixelMap(*pixelMap);
+    FinishTrace(BYTRACE_TAG_OHOS);
+    if (copy == nullptr) {
+        MEDIA_ERR_LOG("Failed to copy cached thumbnail");
+        misses_++;
+        return nullptr;
+    }
+    hits_++;
+    return copy;
+}
+
+void MediaThumbnailCache::Put(const string &key, const Size &size, const string &uri, PixelMap &pixelMap)
+{
+    int32_t byteCount = pixelMap.GetByteCount();
+    if ((key.empty()) || (byteCount <= 0) ||
+        (static_cast<size_t>(byteCount) > capacity_ / THUMBNAIL_CACHE_ENTRY_DIVISOR)) {
+        return;
+    }
+    shared_ptr<PixelMap> copy = CopyPixelMap(pixelMap);
+    if (copy == nullptr) {
+        MEDIA_ERR_LOG("Failed to copy thumbnail for the cache");
+        return;
+    }
+
+    lock_guard<mutex> lock(lock_);
+    if (!uri.empty()) {
+        for (auto iter = entries_.begin(); iter != entries_.end();) {
+            if ((iter->uri == uri) && (get<0>(iter->entryKey) != key)) {
+                iter = Erase(iter);
+                invalidations_++;
+            } else {
+                iter++;
+            }
+        }
+    }
+
+    EntryKey entryKey = make_tuple(key, size.width, size.height);
+    auto indexIter = index_.find(entryKey);
+    if (indexIter != index_.end()) {
+        Erase(indexIter->second);
+    }
+    entries_.push_front({ entryKey, uri, copy, static_cast<size_t>(byteCount) });
+    index_[entryKey] = entries_.begin();
+    bytes_ += static_cast<size_t>(byteCount);
+
+    while (bytes_ > capacity_) {
+        Erase(prev(entries_.end()));
+        evictions_++;
+    }
+}
+
+list<MediaThumbnailCache::Entry>::iterator MediaThumbnailCache::Erase(list<Entry>::iterator iter)
+{
+    bytes_ -= iter->bytes;
+    index_.erase(iter->entryKey);
+    return entries_.erase(iter);
+}
+
+void MediaThumbnailCache::Clear()
+{
+    lock_guard<mutex> lock(lock_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+ThumbnailCacheCounters MediaThumbnailCache::GetCounters()
+{
+    ThumbnailCacheCounters counters;
+    counters.hits = hits_.load();
+    counters.misses = misses_.load();
+    counters.evictions = evictions_.load();
+    counters.invalidations = invalidations_.load();
+    lock_guard<mutex> lock(lock_);
+    counters.bytes = bytes_;
+    counters.entries = entries_.size();
+    return counters;
+}
+
+void MediaThumbnailCache::ResetCounters()
+{
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+    invalidations_ = 0;
+}
+} // namespace Media
+} // namespace OHOS
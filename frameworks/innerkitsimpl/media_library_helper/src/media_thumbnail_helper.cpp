@@ -21,6 +21,7 @@
 #include "media_data_ability_const.h"
 #include "media_lib_service_const.h"
 #include "media_log.h"
+#include "media_thumbnail_cache.h"
 #include "rdb_errno.h"
 #include "rdb_predicates.h"
 
@@ -83,6 +84,12 @@ std::unique_ptr<PixelMap> MediaThumbnailHelper::GetThumbnail(std::string key, Si
 {
     StartTrace(BYTRACE_TAG_OHOS, "GetThumbnail");
 
+    unique_ptr<PixelMap> pixelMap = MediaThumbnailCache::GetInstance()->Get(key, size);
+    if (pixelMap != nullptr) {
+        FinishTrace(BYTRACE_TAG_OHOS);
+        return pixelMap;
+    }
+
     vector<uint8_t> image;
     if (!GetImage(key, image)) {
         if (!uri.substr(0, MEDIALIBRARY_MEDIA_PREFIX.length()).compare(MEDIALIBRARY_MEDIA_PREFIX)) {
@@ -103,11 +110,11 @@ std::unique_ptr<PixelMap> MediaThumbnailHelper::GetThumbnail(std::string key, Si
         }
     }
 
-    unique_ptr<PixelMap> pixelMap;
     if (!ResizeImage(image, size, pixelMap)) {
         MEDIA_ERR_LOG("resize image failed!");
         return nullptr;
     }
+    MediaThumbnailCache::GetInstance()->Put(key, size, uri, *pixelMap);
 
     FinishTrace(BYTRACE_TAG_OHOS);
 
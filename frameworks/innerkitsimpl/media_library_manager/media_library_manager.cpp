@@ -54,7 +54,7 @@ static void UpdateFetchOptionSelection(std::string &selection, const std::string
 unique_ptr<FetchResult> MediaLibraryManager::GetFileAssets(const MediaFetchOptions &fetchOps)
 {
     unique_ptr<FetchResult> fetchFileResult = nullptr;
-    vector<string> columns;
+    vector<string> columns = FetchResult::GetFileAssetColumns();
     DataShare::DataSharePredicates predicates;
     MediaFetchOptions fetchOptions = const_cast<MediaFetchOptions &>(fetchOps);
 
@@ -139,7 +139,10 @@ vector<unique_ptr<AlbumAsset>> MediaLibraryManager::GetAlbums(const MediaFetchOp
         predicates.SetOrder(fetchOptions.order);
     }
 
-    vector<string> columns;
+    vector<string> columns = {
+        MEDIA_DATA_DB_ID, MEDIA_DATA_DB_ALBUM_NAME, MEDIA_DATA_DB_FILE_PATH, MEDIA_DATA_DB_RELATIVE_PATH,
+        MEDIA_DATA_DB_DATE_MODIFIED
+    };
     Uri uri(MEDIALIBRARY_DATA_URI);
     auto resultSet = sAbilityHelper_->Query(
         uri, predicates, columns);
@@ -365,7 +368,7 @@ unique_ptr<FetchResult> MediaLibraryManager::GetAlbumFileAssets(const int32_t al
         predicates.SetWhereArgs(fetchOptions.selectionArgs);
         predicates.SetOrder(fetchOptions.order);
 
-        vector<string> columns;
+        vector<string> columns = FetchResult::GetFileAssetColumns();
         Uri uri(MEDIALIBRARY_DATA_URI);
 
         auto resultSet =
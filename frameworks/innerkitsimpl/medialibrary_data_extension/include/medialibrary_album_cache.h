@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_MEDIALIBRARY_ALBUM_CACHE_H
+#define OHOS_MEDIALIBRARY_ALBUM_CACHE_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "rdb_store.h"
+#include "values_bucket.h"
+
+namespace OHOS {
+namespace Media {
+struct AlbumCacheEntry {
+    int32_t id = 0;
+    std::string path;
+    std::string name;
+    std::string title;
+    int64_t dateModified = 0;
+};
+
+enum class AlbumCacheResult {
+    FOUND,
+    NOT_FOUND,
+    // The cache does not track this store or could not be loaded, ask the database
+    UNAVAILABLE
+};
+
+// Process wide path -> album cache of the Files table. Readers work on an immutable snapshot taken
+// without locking; writers serialize on a mutex, copy the snapshot, change it and publish the copy.
+// The cache mirrors every album row of the store given to Init, so a miss is authoritative. Writes
+// it cannot follow (arbitrary predicates, renames of whole subtrees) invalidate it instead, and the
+// next lookup reloads the albums with a single query.
+// Between BeginBatch and EndBatch the writers change one private copy in place and lookups report
+// UNAVAILABLE, so a scan creating many albums copies the snapshot once instead of once per album.
+class MediaLibraryAlbumCache {
+public:
+    static MediaLibraryAlbumCache *GetInstance();
+
+    void Init(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    void Reset();
+
+    // A null store means the store given to Init
+    AlbumCacheResult GetAlbum(const std::string &path, AlbumCacheEntry &entry,
+        const std::shared_ptr<NativeRdb::RdbStore> &rdbStore = nullptr);
+    AlbumCacheResult GetAlbum(int32_t id, AlbumCacheEntry &entry,
+        const std::shared_ptr<NativeRdb::RdbStore> &rdbStore = nullptr);
+    AlbumCacheResult GetLastAncestor(const std::string &path, const std::string &rootPath, AlbumCacheEntry &entry,
+        const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+
+    void Insert(const AlbumCacheEntry &entry, const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    void Insert(int64_t id, const NativeRdb::ValuesBucket &values, const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    void Erase(const std::string &path, const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    void Erase(int32_t id, const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    void UpdateDateModified(const std::string &path, int64_t dateModified,
+        const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    void Invalidate(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    // Batches nest, the changes are published when the outermost one ends
+    void BeginBatch();
+    void EndBatch();
+
+private:
+    struct Snapshot {
+        std::unordered_map<std::string, AlbumCacheEntry> albums;
+        std::unordered_map<int32_t, std::string> pathById;
+    };
+    using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+    MediaLibraryAlbumCache() = default;
+    ~MediaLibraryAlbumCache() = default;
+
+    SnapshotPtr Acquire(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    SnapshotPtr Load();
+    bool IsTracked(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore) const;
+    template<typename Func>
+    void Modify(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore, Func func);
+
+    std::mutex writeLock_;
+    std::shared_ptr<NativeRdb::RdbStore> rdbStore_;
+    SnapshotPtr snapshot_;
+    std::atomic<int32_t> batchDepth_ {0};
+    // The copy the writers change while a batch is open, null when the cache was invalidated meanwhile
+    std::shared_ptr<Snapshot> batchSnapshot_;
+};
+} // namespace Media
+} // namespace OHOS
+#endif // OHOS_MEDIALIBRARY_ALBUM_CACHE_H
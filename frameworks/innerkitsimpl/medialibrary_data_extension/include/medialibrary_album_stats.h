@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_MEDIALIBRARY_ALBUM_STATS_H
+#define OHOS_MEDIALIBRARY_ALBUM_STATS_H
+
+#include <string>
+#include <vector>
+
+namespace OHOS {
+namespace Media {
+// Schema of the AlbumStats table. The triggers follow every write to Files and SmartAlbumMap, whichever
+// path makes it (data share, scanner, sync), so no operation has to maintain the statistics itself.
+class MediaLibraryAlbumStats {
+public:
+    // Table, indexes and triggers for an empty database
+    static const std::vector<std::string> &GetCreateSqls();
+    // Everything GetCreateSqls creates, with the statistics recomputed from the current contents
+    static const std::vector<std::string> &GetRebuildSqls();
+    // The triggers dropped and created again, for a database whose triggers predate the current ones
+    static const std::vector<std::string> &GetRecreateTriggerSqls();
+};
+} // namespace Media
+} // namespace OHOS
+#endif // OHOS_MEDIALIBRARY_ALBUM_STATS_H
@@ -16,6 +16,8 @@
 #ifndef OHOS_MEDIALIBRARY_DATA_MANAGER_H
 #define OHOS_MEDIALIBRARY_DATA_MANAGER_H
 
+#include <functional>
+#include <mutex>
 #include <string>
 
 #include "ability.h"
@@ -47,6 +49,7 @@
 #include "want.h"
 #include "hilog/log.h"
 #include "medialibrary_thumbnail.h"
+#include "medialibrary_uri_router.h"
 #include "distributed_kv_data_manager.h"
 #include "timer.h"
 #include "datashare_predicates.h"
@@ -58,16 +61,6 @@ namespace Media {
 // kvstore constants
     const DistributedKv::AppId KVSTORE_APPID { "com.ohos.medialibrary.MediaLibraryDataA" };
     const DistributedKv::StoreId KVSTORE_STOREID { "ringtone" };
-    enum TableType {
-        TYPE_DATA,
-        TYPE_SMARTALBUM,
-        TYPE_SMARTALBUM_MAP,
-        TYPE_ALBUM_TABLE,
-        TYPE_SMARTALBUMASSETS_TABLE,
-        TYPE_ACTIVE_DEVICE,
-        TYPE_ALL_DEVICE,
-        TYPE_ASSETSMAP_TABLE
-    };
     class MediaLibraryInitCallback;
     class MediaLibraryDeviceStateCallback;
     class MediaLibraryRdbStoreObserver;
@@ -78,10 +71,14 @@ namespace Media {
         static std::shared_ptr<MediaLibraryDataManager> GetInstance();
 
         EXPORT int32_t InitMediaLibraryRdbStore();
+        // Serve a store the caller opened, instead of the one of the ability context
+        EXPORT int32_t InitMediaLibraryRdbStore(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
         EXPORT void InitialiseKvStore();
         EXPORT int32_t Insert(const Uri &uri, const DataShare::DataShareValuesBucket &value);
         EXPORT int32_t Delete(const Uri &uri, const DataShare::DataSharePredicates &predicates);
         EXPORT int32_t BatchInsert(const Uri &uri, const std::vector<DataShare::DataShareValuesBucket> &values);
+        EXPORT int32_t BatchUpsert(const std::vector<DataShare::DataShareValuesBucket> &values,
+            std::vector<int64_t> &rowIds);
         EXPORT int32_t Update(const Uri &uri, const DataShare::DataShareValuesBucket &value,
                        const DataShare::DataSharePredicates &predicates);
         EXPORT std::shared_ptr<DataShare::ResultSetBridge> Query(const Uri &uri,
@@ -89,8 +86,9 @@ namespace Media {
             const DataShare::DataSharePredicates &predicates);
         EXPORT int32_t OpenFile(const Uri &uri, const std::string &mode);
         EXPORT std::string GetType(const Uri &uri);
-
-        std::shared_ptr<NativeRdb::RdbStore> rdbStore_;
+        EXPORT static int32_t ExecuteInTransaction(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
+            const std::function<int32_t()> &writes);
+        EXPORT std::shared_ptr<NativeRdb::RdbStore> GetRdbStore() const;
 
         void InitMediaLibraryMgr(const std::shared_ptr<OHOS::AbilityRuntime::Context> &context);
         void ClearMediaLibraryMgr();
@@ -103,7 +101,6 @@ namespace Media {
         bool SubscribeRdbStoreObserver();
         bool UnSubscribeRdbStoreObserver();
         bool QuerySync(const std::string &deviceId, const std::string &tableName);
-        bool QuerySync();
 		
         bool CheckFileNameValid(const DataShareValuesBucket &value);
         sptr<AppExecFwk::IBundleMgr> GetSysBundleManager();
@@ -112,6 +109,8 @@ namespace Media {
         std::string GetClientBundle(int uid);
 
         int32_t PreCheckInsert(const std::string &uri, const DataShare::DataShareValuesBucket &value);
+        int32_t ExecuteBatchInTransaction(const std::vector<DataShare::DataShareValuesBucket> &values,
+            bool isUpsert, std::vector<int64_t> &rowIds);
 
         static const std::string PERMISSION_NAME_READ_MEDIA;
         static const std::string PERMISSION_NAME_WRITE_MEDIA;
@@ -122,10 +121,14 @@ namespace Media {
         std::shared_ptr<MediaLibraryInitCallback> deviceInitCallback_;
         std::shared_ptr<MediaLibraryRdbStoreObserver> rdbStoreObs_;
         bool isRdbStoreInitialized;
+        std::shared_ptr<NativeRdb::RdbStore> rdbStore_;
         std::shared_ptr<OHOS::AbilityRuntime::Context> context_ = nullptr;
         std::string bundleName_;
         OHOS::sptr<AppExecFwk::IBundleMgr> bundleMgr_;
         static std::mutex mutex_;
+        // Every write to the store goes under this lock, so a plain Insert, Update or Delete never lands in the
+        // transaction of another thread. Recursive, a write path may open a transaction of its own
+        static std::recursive_mutex writerLock_;
         static std::shared_ptr<MediaLibraryDataManager> instance_;
 };
 
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_MEDIALIBRARY_PULL_CACHE_H
+#define OHOS_MEDIALIBRARY_PULL_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace OHOS {
+namespace Media {
+struct PullCacheCounters {
+    // Refresh calls answered by a pull younger than the max age
+    uint64_t fresh = 0;
+    // Refresh calls answered from the local copy while a pull is queued or running
+    uint64_t stale = 0;
+    // Pulls issued
+    uint64_t pulled = 0;
+    // Refresh calls that found a pull of the same device and table already queued or running
+    uint64_t coalesced = 0;
+    // Issued pulls that reported failure
+    uint64_t failed = 0;
+};
+
+// Last pull of every remote device and table. Queries on a remote device never wait for the pull:
+// they read the local copy of the distributed table at once, and a stale copy gets a pull queued
+// for the worker threads. A device has at most deviceConcurrency pulls running at the same time,
+// the rest wait in the queue while pulls of other devices go ahead.
+class MediaLibraryPullCache {
+public:
+    // Pulls one table from one device, blocking, MediaLibraryDataManager::QuerySync in the service
+    using PullFunc = std::function<bool(const std::string &deviceId, const std::string &tableName)>;
+
+    static constexpr std::chrono::milliseconds DEFAULT_MAX_AGE {30000};
+    static constexpr size_t DEFAULT_DEVICE_CONCURRENCY = 1;
+    static constexpr size_t DEFAULT_WORKERS = 2;
+
+    static MediaLibraryPullCache *GetInstance();
+
+    void Start(PullFunc pullFunc, std::chrono::milliseconds maxAge = DEFAULT_MAX_AGE,
+        size_t deviceConcurrency = DEFAULT_DEVICE_CONCURRENCY, size_t workers = DEFAULT_WORKERS);
+    // Drops the queued pulls and waits for the running ones
+    void Stop();
+
+    // True when the local copy is fresh, otherwise a pull is queued unless one already is
+    bool Refresh(const std::string &deviceId, const std::string &tableName);
+    // Forgets the pulls of a device, the next query on it pulls again
+    void Invalidate(const std::string &deviceId);
+
+    PullCacheCounters GetCounters() const;
+    void ResetCounters();
+
+    MediaLibraryPullCache() = default;
+    ~MediaLibraryPullCache();
+
+private:
+    using PullKey = std::pair<std::string, std::string>;
+    struct PullEntry {
+        bool synced = false;
+        bool pending = false;
+        std::chrono::steady_clock::time_point lastSync;
+    };
+
+    void Run();
+    bool TakeNext(PullKey &key);
+
+    std::mutex lock_;
+    std::condition_variable pullCv_;
+    std::map<PullKey, PullEntry> entries_;
+    std::deque<PullKey> queue_;
+    // Running pulls per device
+    std::map<std::string, size_t> devicePulls_;
+    std::chrono::milliseconds maxAge_ {DEFAULT_MAX_AGE};
+    size_t deviceConcurrency_ = DEFAULT_DEVICE_CONCURRENCY;
+    PullFunc pullFunc_;
+    bool running_ = false;
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> fresh_ {0};
+    std::atomic<uint64_t> stale_ {0};
+    std::atomic<uint64_t> pulled_ {0};
+    std::atomic<uint64_t> coalesced_ {0};
+    std::atomic<uint64_t> failed_ {0};
+};
+} // namespace Media
+} // namespace OHOS
+#endif // OHOS_MEDIALIBRARY_PULL_CACHE_H
@@ -17,6 +17,7 @@
 #define OHOS_MEDIALIBRARY_SMARTALBUMMAP_DB_H
 
 #include <string>
+#include <vector>
 #include "media_data_ability_const.h"
 #include "rdb_errno.h"
 #include "rdb_helper.h"
@@ -35,6 +36,8 @@ public:
     MediaLibrarySmartAlbumMapDb() = default;
     ~MediaLibrarySmartAlbumMapDb() = default;
     int32_t DeleteSmartAlbumMapInfo(const int32_t albumId, const int32_t assetId, const shared_ptr<RdbStore> &rdbStore);
+    int32_t DeleteSmartAlbumMapInfos(const int32_t albumId, const std::vector<int32_t> &assetIds,
+        const shared_ptr<RdbStore> &rdbStore);
     int32_t DeleteAllSmartAlbumMapInfo(const int32_t albumId, const shared_ptr<RdbStore> &rdbStore);
     int32_t DeleteAllAssetsMapInfo(const int32_t assetId, const shared_ptr<RdbStore> &rdbStore);
     int32_t UpdateSmartAlbumMapInfo(const ValuesBucket &values, const shared_ptr<RdbStore> &rdbStore);
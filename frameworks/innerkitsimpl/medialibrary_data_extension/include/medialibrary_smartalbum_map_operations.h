@@ -18,6 +18,7 @@
 
 #include <string>
 #include <variant>
+#include <vector>
 #include <grp.h>
 #include <securec.h>
 #include <unistd.h>
@@ -35,6 +36,11 @@ public:
     int32_t HandleSmartAlbumMapOperations(const std::string &uri,
                                           const NativeRdb::ValuesBucket &values,
                                           const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
+    // Adds or removes the map rows of many assets of one album in a single transaction, returns the rows changed.
+    // One failed row rolls back the whole batch and DATA_ABILITY_FAIL is returned.
+    int32_t HandleBatchSmartAlbumMapOperations(const std::string &oprn,
+                                               const std::vector<NativeRdb::ValuesBucket> &values,
+                                               const std::shared_ptr<NativeRdb::RdbStore> &rdbStore);
 };
 } // namespace Media
 } // namespace OHOS
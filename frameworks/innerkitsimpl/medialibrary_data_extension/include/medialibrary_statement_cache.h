@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_MEDIALIBRARY_STATEMENT_CACHE_H
+#define OHOS_MEDIALIBRARY_STATEMENT_CACHE_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "abs_shared_result_set.h"
+#include "rdb_store.h"
+
+namespace OHOS {
+namespace Media {
+// Fixed-shape lookups, every one takes a single bound argument
+enum class StatementId : uint8_t {
+    // file_id, size, date_modified, display_name by path
+    FILE_MODIFIED_INFO,
+    // file_id by path
+    ID_BY_PATH,
+    // data by file_id
+    PATH_BY_ID,
+    // file_id, title by file_id
+    ALBUM_BY_ID,
+    // file_id, data, thumbnail, lcd, media_type by file_id
+    THUMBNAIL_INFO,
+    COUNT
+};
+
+struct StatementCounters {
+    // Queries run
+    uint64_t calls = 0;
+    // Queries that returned no result set or failed to execute
+    uint64_t failed = 0;
+    // Rows returned
+    uint64_t rows = 0;
+    // Time of QuerySql and of filling the result set, microseconds
+    uint64_t totalTime = 0;
+    uint64_t maxTime = 0;
+};
+
+// SQL text of the hot lookups, built once per statement and table with its argument left as a ? placeholder.
+// Only the text is cached: every lookup still calls RdbStore::QuerySql, which prepares the statement and
+// binds the argument, instead of concatenating the argument into a new statement text.
+// Each query is executed before it is returned, its time is counted per statement.
+class MediaLibraryStatementCache {
+public:
+    static MediaLibraryStatementCache *GetInstance();
+
+    // Runs the statement on table, MEDIALIBRARY_TABLE when empty, with its ? bound to arg
+    std::shared_ptr<NativeRdb::AbsSharedResultSet> Query(const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
+        StatementId id, const std::string &arg, const std::string &table = "");
+
+    static const char *GetName(StatementId id);
+    StatementCounters GetCounters(StatementId id) const;
+    void ResetCounters();
+
+    MediaLibraryStatementCache() = default;
+    ~MediaLibraryStatementCache() = default;
+
+private:
+    struct StatementStats {
+        std::atomic<uint64_t> calls {0};
+        std::atomic<uint64_t> failed {0};
+        std::atomic<uint64_t> rows {0};
+        std::atomic<uint64_t> totalTime {0};
+        std::atomic<uint64_t> maxTime {0};
+    };
+
+    const std::string &GetSql(StatementId id, const std::string &table);
+    void Count(StatementId id, uint64_t time, int32_t rows, bool failed);
+
+    std::mutex sqlLock_;
+    std::map<std::pair<StatementId, std::string>, std::string> sqls_;
+    StatementStats stats_[static_cast<size_t>(StatementId::COUNT)];
+};
+} // namespace Media
+} // namespace OHOS
+#endif // OHOS_MEDIALIBRARY_STATEMENT_CACHE_H
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_MEDIALIBRARY_SYNC_SCHEDULER_H
+#define OHOS_MEDIALIBRARY_SYNC_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+namespace OHOS {
+namespace Media {
+struct SyncPushCounters {
+    // MarkDirty calls
+    uint64_t requested = 0;
+    // Pushes issued, one per dirty table and window
+    uint64_t pushed = 0;
+    // Requests absorbed by a push already pending for the same table
+    uint64_t coalesced = 0;
+    // Issued pushes that reported failure
+    uint64_t failed = 0;
+};
+
+// Coalesces distributed pushes of the tables written by the data manager. The first write to a
+// clean table opens a window, every table marked dirty until the window closes is pushed once
+// when it does, so a burst of updates costs one push per table instead of one per update.
+class MediaLibrarySyncScheduler {
+public:
+    // Pushes one table to the other devices, MediaLibrarySyncTable::SyncPushTable in the service
+    using PushFunc = std::function<bool(const std::string &tableName)>;
+
+    static constexpr std::chrono::milliseconds DEFAULT_WINDOW {500};
+
+    static MediaLibrarySyncScheduler *GetInstance();
+
+    void Start(PushFunc pushFunc, std::chrono::milliseconds window = DEFAULT_WINDOW);
+    // Pushes what is still pending before returning
+    void Stop();
+
+    // Ignored when the scheduler is not started, there is no store to push from
+    void MarkDirty(const std::string &tableName);
+    // Pushes the pending tables without waiting for the window to close
+    void Flush();
+
+    SyncPushCounters GetCounters() const;
+    void ResetCounters();
+
+    MediaLibrarySyncScheduler() = default;
+    ~MediaLibrarySyncScheduler();
+
+private:
+    void Run();
+    void Push(const std::set<std::string> &tables);
+
+    std::mutex lock_;
+    std::condition_variable dirtyCv_;
+    std::set<std::string> dirtyTables_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::chrono::milliseconds window_ {DEFAULT_WINDOW};
+    PushFunc pushFunc_;
+    bool running_ = false;
+    std::thread worker_;
+
+    // Keeps the worker and Flush from pushing at the same time
+    std::mutex pushLock_;
+
+    std::atomic<uint64_t> requested_ {0};
+    std::atomic<uint64_t> pushed_ {0};
+    std::atomic<uint64_t> coalesced_ {0};
+    std::atomic<uint64_t> failed_ {0};
+};
+} // namespace Media
+} // namespace OHOS
+#endif // OHOS_MEDIALIBRARY_SYNC_SCHEDULER_H
@@ -16,6 +16,14 @@
 #ifndef MEDIA_THUMBNAIL_H
 #define MEDIA_THUMBNAIL_H
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <utility>
+
 #include "media_thumbnail_helper.h"
 #include "rdb_helper.h"
 #include "rdb_store.h"
@@ -57,6 +65,40 @@ struct ThumbnailRdbData {
     int mediaType;
 };
 
+// Shared state of CreateThumbnails: the generator workers pull infos by index and hand the
+// compressed thumbnails to the writer through the bounded pending queue
+struct ThumbnailPipeline {
+    std::atomic<size_t> nextIndex {0};
+    size_t activeWorkers = 0;
+    std::deque<ThumbnailData> pending;
+    std::mutex lock;
+    std::condition_variable notFull;
+    std::condition_variable notEmpty;
+};
+
+enum class ThumbnailRendition {
+    THUMBNAIL,
+    LCD
+};
+
+struct ThumbnailFlightCounters {
+    // Generations run
+    uint64_t generated = 0;
+    // Requests that waited for a generation of the same row and rendition instead of running their own
+    uint64_t coalesced = 0;
+};
+
+// A generation in progress for a row. Requesters of the same rendition arriving meanwhile wait for its
+// result, those of the other rendition wait for it to finish before they start their own, since an LCD
+// generation writes the thumbnail of the row too.
+struct ThumbnailFlight {
+    ThumbnailRendition rendition = ThumbnailRendition::THUMBNAIL;
+    bool done = false;
+    bool ret = false;
+    std::string key;
+    std::condition_variable finished;
+};
+
 class MediaLibraryThumbnail : public MediaThumbnailHelper {
 public:
     EXPORT MediaLibraryThumbnail();
@@ -66,21 +108,40 @@ public:
 
     EXPORT bool CreateLcd(ThumbRdbOpt &opts, std::string &key);
 
+    EXPORT bool CreateRenditions(ThumbRdbOpt &opts, std::string &thumbnailKey, std::string &lcdKey);
+
     EXPORT void CreateThumbnails(ThumbRdbOpt &opts);
 
     EXPORT std::shared_ptr<DataShare::ResultSetBridge> GetThumbnailKey(ThumbRdbOpt &opts, Size &size);
     EXPORT std::unique_ptr<PixelMap> GetThumbnailByRdb(ThumbRdbOpt &opts, Size &size, const std::string &uri);
 
+    EXPORT ThumbnailFlightCounters GetFlightCounters() const;
+
 private:
+    friend class MediaThumbnailTest;
+    // Runs in the requester that owns a new flight, before it generates. Lets tests hold a flight open.
+    void SetFlightHook(const std::function<void()> &hook);
+
+    using ThumbnailFlightKey = std::pair<std::string, std::string>;
+    using GenerateFunc = bool (MediaLibraryThumbnail::*)(ThumbRdbOpt &opts, std::string &key);
+
+    // Single flight
+    bool GenerateOnce(ThumbRdbOpt &opts, ThumbnailRendition rendition, std::string &key, GenerateFunc generate);
+    bool GenerateThumbnail(ThumbRdbOpt &opts, std::string &key);
+    bool GenerateLcd(ThumbRdbOpt &opts, std::string &key);
+
     // utils
-    bool LoadImageFile(std::string &path, std::shared_ptr<PixelMap> &pixelMap);
+    bool LoadImageFile(std::string &path, std::shared_ptr<PixelMap> &pixelMap, const Size &desiredSize);
     bool LoadVideoFile(std::string &path, std::shared_ptr<PixelMap> &pixelMap);
-    bool LoadAudioFile(std::string &path, std::shared_ptr<PixelMap> &pixelMap);
+    bool LoadAudioFile(std::string &path, std::shared_ptr<PixelMap> &pixelMap, const Size &desiredSize);
     bool GenKey(std::vector<uint8_t> &data, std::string &key);
+    bool GenFileKey(const std::string &path, std::string &key);
+    bool GenSourceKey(ThumbnailData &data, std::string &key);
     bool CompressImage(std::shared_ptr<PixelMap> &pixelMap, Size &size, std::vector<uint8_t> &data);
 
     // KV Store
     bool SaveImage(std::string &key, std::vector<uint8_t> &image);
+    bool DeleteImage(const std::string &key);
 
     // RDB Store
     std::shared_ptr<DataShare::ResultSetBridge> QueryThumbnailSet(ThumbRdbOpt &opts);
@@ -88,9 +149,15 @@ private:
         ThumbnailData &data, int &errorCode);
     bool QueryThumbnailInfos(ThumbRdbOpt &opts, std::vector<ThumbnailRdbData> &infos, int &errorCode);
     bool UpdateThumbnailInfo(ThumbRdbOpt &opts, ThumbnailData &data, int &errorCode);
+    bool SaveThumbnailBatch(ThumbRdbOpt &opts, std::vector<ThumbnailData> &batch);
+
+    // Pipeline
+    void GenerateThumbnailWorker(ThumbnailPipeline &pipeline, const std::vector<ThumbnailRdbData> &infos);
+    bool PrepareThumbnailData(ThumbnailData &data);
+    void WriteThumbnails(ThumbRdbOpt &opts, ThumbnailPipeline &pipeline);
 
     // Steps
-    bool LoadSourceImage(ThumbnailData &data);
+    bool LoadSourceImage(ThumbnailData &data, const Size &desiredSize);
     bool GenThumbnailKey(ThumbnailData &data);
     bool GenLcdKey(ThumbnailData &data);
     bool CreateThumbnailData(ThumbnailData &data);
@@ -105,6 +172,12 @@ private:
 
     bool CreateThumbnail(ThumbRdbOpt &opts, ThumbnailData &data, std::string &key);
     int32_t SetSource(std::shared_ptr<AVMetadataHelper> avMetadataHelper, const std::string &path);
+
+    std::mutex flightLock_;
+    std::map<ThumbnailFlightKey, std::shared_ptr<ThumbnailFlight>> flights_;
+    std::function<void()> flightHook_;
+    std::atomic<uint64_t> generatedCount_ {0};
+    std::atomic<uint64_t> coalescedCount_ {0};
 };
 } // namespace Media
 } // namespace  OHOS
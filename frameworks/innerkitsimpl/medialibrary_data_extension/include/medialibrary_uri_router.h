@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef OHOS_MEDIALIBRARY_URI_ROUTER_H
+#define OHOS_MEDIALIBRARY_URI_ROUTER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace OHOS {
+namespace Media {
+enum TableType {
+    TYPE_DATA,
+    TYPE_SMARTALBUM,
+    TYPE_SMARTALBUM_MAP,
+    TYPE_ALBUM_TABLE,
+    TYPE_SMARTALBUMASSETS_TABLE,
+    TYPE_ACTIVE_DEVICE,
+    TYPE_ALL_DEVICE,
+    TYPE_ASSETSMAP_TABLE
+};
+
+// Path segment naming the operation handler, datashare:///media/<group>/<operation>
+enum class UriOprnGroup : uint8_t {
+    NONE,
+    FILE,
+    ALBUM,
+    SMARTALBUM,
+    SMARTALBUMMAP,
+    KVSTORE,
+    QUERY,
+    BOARDCAST,
+    // Names an operation but no group of the above, refused by the operation handlers
+    UNKNOWN
+};
+
+struct MediaLibraryUri {
+    // Authority of datashare://<networkId>/media/..., empty on the local device
+    std::string networkId;
+    // The uri without the thumbnail query string
+    std::string uri;
+    // The uri without its last segment
+    std::string parent;
+    // Last segment of the parent, the table of datashare:///media/<table>/<row>
+    std::string table;
+    // Last segment, the operation of an operation uri or the row of a row uri
+    std::string operation;
+    UriOprnGroup group = UriOprnGroup::NONE;
+    // Views and device lists queried by their own uri, TYPE_DATA for everything else
+    TableType tableType = TYPE_DATA;
+    // ?operation=thumbnail&width=<w>&height=<h>
+    bool isThumbnail = false;
+    int32_t width = 0;
+    int32_t height = 0;
+
+    bool IsOprnUri() const
+    {
+        return (group != UriOprnGroup::NONE) && (group != UriOprnGroup::BOARDCAST);
+    }
+};
+
+// Splits a data ability uri once into everything Insert, Update, Delete and Query dispatch on,
+// looking the segments up in sorted tables built at load time instead of searching the uri
+// for every keyword in turn.
+class MediaLibraryUriRouter {
+public:
+    static MediaLibraryUri Parse(const std::string &uri);
+
+private:
+    static void ParseThumbnail(std::string_view query, MediaLibraryUri &route);
+};
+} // namespace Media
+} // namespace OHOS
+#endif // OHOS_MEDIALIBRARY_URI_ROUTER_H
@@ -204,7 +204,7 @@ int MediaDataShareExtAbility::BatchInsert(const Uri &uri, const std::vector<Data
         return ret;
     }
 
-    //ret = MediaLibraryDataManager::GetInstance()->BatchInsert(uri, values);
+    ret = MediaLibraryDataManager::GetInstance()->BatchInsert(uri, values);
     HILOG_INFO("%{public}s end.", __func__);
     return ret;
 }
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_album_cache.h"
+
+#include "bytrace.h"
+#include "media_data_ability_const.h"
+#include "media_log.h"
+#include "rdb_errno.h"
+
+using namespace std;
+using namespace OHOS::NativeRdb;
+
+namespace OHOS {
+namespace Media {
+namespace {
+string NormalizePath(const string &path)
+{
+    string normalized = path;
+    while (normalized.length() > 1 && normalized.back() == '/') {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+} // namespace
+
+MediaLibraryAlbumCache *MediaLibraryAlbumCache::GetInstance()
+{
+    static MediaLibraryAlbumCache albumCache;
+    return &albumCache;
+}
+
+void MediaLibraryAlbumCache::Init(const shared_ptr<RdbStore> &rdbStore)
+{
+    lock_guard<mutex> lock(writeLock_);
+    atomic_store(&rdbStore_, rdbStore);
+    atomic_store(&snapshot_, Load());
+    batchSnapshot_ = nullptr;
+}
+
+void MediaLibraryAlbumCache::Reset()
+{
+    lock_guard<mutex> lock(writeLock_);
+    atomic_store(&rdbStore_, shared_ptr<RdbStore>());
+    atomic_store(&snapshot_, SnapshotPtr());
+    batchSnapshot_ = nullptr;
+}
+
+bool MediaLibraryAlbumCache::IsTracked(const shared_ptr<RdbStore> &rdbStore) const
+{
+    auto trackedStore = atomic_load(&rdbStore_);
+    return (trackedStore != nullptr) && ((rdbStore == nullptr) || (rdbStore == trackedStore));
+}
+
+// Called with writeLock_ held
+MediaLibraryAlbumCache::SnapshotPtr MediaLibraryAlbumCache::Load()
+{
+    if (rdbStore_ == nullptr) {
+        return nullptr;
+    }
+
+    StartTrace(BYTRACE_TAG_OHOS, "MediaLibraryAlbumCache::Load");
+    string sql = "SELECT " + MEDIA_DATA_DB_ID + "," + MEDIA_DATA_DB_FILE_PATH + "," + MEDIA_DATA_DB_NAME + "," +
+        MEDIA_DATA_DB_TITLE + "," + MEDIA_DATA_DB_DATE_MODIFIED + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+        MEDIA_DATA_DB_MEDIA_TYPE + " = ?";
+    vector<string> selectionArgs = { to_string(MEDIA_TYPE_ALBUM) };
+    unique_ptr<ResultSet> resultSet = rdbStore_->QuerySql(sql, selectionArgs);
+    if (resultSet == nullptr) {
+        MEDIA_ERR_LOG("Failed to load the album cache");
+        FinishTrace(BYTRACE_TAG_OHOS);
+        return nullptr;
+    }
+
+    auto snapshot = make_shared<Snapshot>();
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        AlbumCacheEntry entry;
+        // Columns in SELECT order
+        resultSet->GetInt(0, entry.id);
+        resultSet->GetString(1, entry.path);
+        resultSet->GetString(2, entry.name);
+        resultSet->GetString(3, entry.title);
+        resultSet->GetLong(4, entry.dateModified);
+        entry.path = NormalizePath(entry.path);
+        snapshot->pathById[entry.id] = entry.path;
+        snapshot->albums[entry.path] = move(entry);
+    }
+    MEDIA_INFO_LOG("Album cache loaded %{public}d albums", static_cast<int32_t>(snapshot->albums.size()));
+    FinishTrace(BYTRACE_TAG_OHOS);
+    return snapshot;
+}
+
+MediaLibraryAlbumCache::SnapshotPtr MediaLibraryAlbumCache::Acquire(const shared_ptr<RdbStore> &rdbStore)
+{
+    if (!IsTracked(rdbStore) || (batchDepth_ > 0)) {
+        return nullptr;
+    }
+
+    SnapshotPtr snapshot = atomic_load(&snapshot_);
+    if (snapshot != nullptr) {
+        return snapshot;
+    }
+
+    lock_guard<mutex> lock(writeLock_);
+    snapshot = atomic_load(&snapshot_);
+    if (snapshot == nullptr) {
+        snapshot = Load();
+        atomic_store(&snapshot_, snapshot);
+    }
+    return snapshot;
+}
+
+AlbumCacheResult MediaLibraryAlbumCache::GetAlbum(const string &path, AlbumCacheEntry &entry,
+    const shared_ptr<RdbStore> &rdbStore)
+{
+    SnapshotPtr snapshot = Acquire(rdbStore);
+    if (snapshot == nullptr) {
+        return AlbumCacheResult::UNAVAILABLE;
+    }
+
+    auto iter = snapshot->albums.find(NormalizePath(path));
+    if (iter == snapshot->albums.end()) {
+        return AlbumCacheResult::NOT_FOUND;
+    }
+    entry = iter->second;
+    return AlbumCacheResult::FOUND;
+}
+
+AlbumCacheResult MediaLibraryAlbumCache::GetAlbum(int32_t id, AlbumCacheEntry &entry,
+    const shared_ptr<RdbStore> &rdbStore)
+{
+    SnapshotPtr snapshot = Acquire(rdbStore);
+    if (snapshot == nullptr) {
+        return AlbumCacheResult::UNAVAILABLE;
+    }
+
+    auto pathIter = snapshot->pathById.find(id);
+    if (pathIter == snapshot->pathById.end()) {
+        return AlbumCacheResult::NOT_FOUND;
+    }
+    auto iter = snapshot->albums.find(pathIter->second);
+    if (iter == snapshot->albums.end()) {
+        return AlbumCacheResult::NOT_FOUND;
+    }
+    entry = iter->second;
+    return AlbumCacheResult::FOUND;
+}
+
+// Deepest album below rootPath that is path itself or one of its ancestors
+AlbumCacheResult MediaLibraryAlbumCache::GetLastAncestor(const string &path, const string &rootPath,
+    AlbumCacheEntry &entry, const shared_ptr<RdbStore> &rdbStore)
+{
+    SnapshotPtr snapshot = Acquire(rdbStore);
+    if (snapshot == nullptr) {
+        return AlbumCacheResult::UNAVAILABLE;
+    }
+
+    string ancestor = NormalizePath(path);
+    while (ancestor.length() > rootPath.length()) {
+        auto iter = snapshot->albums.find(ancestor);
+        if (iter != snapshot->albums.end()) {
+            entry = iter->second;
+            return AlbumCacheResult::FOUND;
+        }
+        size_t slashIndex = ancestor.rfind('/');
+        if (slashIndex == string::npos) {
+            break;
+        }
+        ancestor.erase(slashIndex);
+    }
+    return AlbumCacheResult::NOT_FOUND;
+}
+
+template<typename Func>
+void MediaLibraryAlbumCache::Modify(const shared_ptr<RdbStore> &rdbStore, Func func)
+{
+    if (!IsTracked(rdbStore)) {
+        return;
+    }
+
+    lock_guard<mutex> lock(writeLock_);
+    if (batchDepth_ > 0) {
+        if (batchSnapshot_ != nullptr) {
+            func(*batchSnapshot_);
+        }
+        return;
+    }
+    SnapshotPtr snapshot = atomic_load(&snapshot_);
+    if (snapshot == nullptr) {
+        // Invalidated, the next lookup reloads from the database anyway
+        return;
+    }
+    auto copy = make_shared<Snapshot>(*snapshot);
+    func(*copy);
+    atomic_store(&snapshot_, SnapshotPtr(move(copy)));
+}
+
+void MediaLibraryAlbumCache::Insert(const AlbumCacheEntry &entry, const shared_ptr<RdbStore> &rdbStore)
+{
+    if (entry.id <= 0 || entry.path.empty()) {
+        return;
+    }
+
+    Modify(rdbStore, [&entry](Snapshot &snapshot) {
+        AlbumCacheEntry album = entry;
+        album.path = NormalizePath(album.path);
+        auto oldPath = snapshot.pathById.find(album.id);
+        if (oldPath != snapshot.pathById.end() && oldPath->second != album.path) {
+            snapshot.albums.erase(oldPath->second);
+        }
+        snapshot.pathById[album.id] = album.path;
+        snapshot.albums[album.path] = move(album);
+    });
+}
+
+void MediaLibraryAlbumCache::Insert(int64_t id, const ValuesBucket &values, const shared_ptr<RdbStore> &rdbStore)
+{
+    AlbumCacheEntry entry;
+    entry.id = static_cast<int32_t>(id);
+    ValueObject valueObject;
+    if (values.GetObject(MEDIA_DATA_DB_FILE_PATH, valueObject)) {
+        valueObject.GetString(entry.path);
+    }
+    if (values.GetObject(MEDIA_DATA_DB_NAME, valueObject)) {
+        valueObject.GetString(entry.name);
+    }
+    if (values.GetObject(MEDIA_DATA_DB_TITLE, valueObject)) {
+        valueObject.GetString(entry.title);
+    }
+    if (values.GetObject(MEDIA_DATA_DB_DATE_MODIFIED, valueObject)) {
+        valueObject.GetLong(entry.dateModified);
+    }
+    Insert(entry, rdbStore);
+}
+
+// Drops the album at path together with every album below it
+void MediaLibraryAlbumCache::Erase(const string &path, const shared_ptr<RdbStore> &rdbStore)
+{
+    string albumPath = NormalizePath(path);
+    if (albumPath.empty()) {
+        return;
+    }
+
+    Modify(rdbStore, [&albumPath](Snapshot &snapshot) {
+        string childPrefix = albumPath + "/";
+        for (auto iter = snapshot.albums.begin(); iter != snapshot.albums.end();) {
+            if (iter->first == albumPath || iter->first.compare(0, childPrefix.length(), childPrefix) == 0) {
+                snapshot.pathById.erase(iter->second.id);
+                iter = snapshot.albums.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    });
+}
+
+void MediaLibraryAlbumCache::Erase(int32_t id, const shared_ptr<RdbStore> &rdbStore)
+{
+    Modify(rdbStore, [id](Snapshot &snapshot) {
+        auto pathIter = snapshot.pathById.find(id);
+        if (pathIter != snapshot.pathById.end()) {
+            snapshot.albums.erase(pathIter->second);
+            snapshot.pathById.erase(pathIter);
+        }
+    });
+}
+
+void MediaLibraryAlbumCache::UpdateDateModified(const string &path, int64_t dateModified,
+    const shared_ptr<RdbStore> &rdbStore)
+{
+    string albumPath = NormalizePath(path);
+    Modify(rdbStore, [&albumPath, dateModified](Snapshot &snapshot) {
+        auto iter = snapshot.albums.find(albumPath);
+        if (iter != snapshot.albums.end()) {
+            iter->second.dateModified = dateModified;
+        }
+    });
+}
+
+void MediaLibraryAlbumCache::Invalidate(const shared_ptr<RdbStore> &rdbStore)
+{
+    if (!IsTracked(rdbStore)) {
+        return;
+    }
+
+    lock_guard<mutex> lock(writeLock_);
+    atomic_store(&snapshot_, SnapshotPtr());
+    batchSnapshot_ = nullptr;
+}
+
+void MediaLibraryAlbumCache::BeginBatch()
+{
+    lock_guard<mutex> lock(writeLock_);
+    if (batchDepth_++ > 0) {
+        return;
+    }
+    SnapshotPtr snapshot = atomic_load(&snapshot_);
+    batchSnapshot_ = (snapshot != nullptr) ? make_shared<Snapshot>(*snapshot) : nullptr;
+}
+
+void MediaLibraryAlbumCache::EndBatch()
+{
+    lock_guard<mutex> lock(writeLock_);
+    if ((batchDepth_ == 0) || (--batchDepth_ > 0)) {
+        return;
+    }
+    atomic_store(&snapshot_, SnapshotPtr(move(batchSnapshot_)));
+    batchSnapshot_ = nullptr;
+}
+} // namespace Media
+} // namespace OHOS
@@ -15,6 +15,7 @@
 
 #include "medialibrary_album_db.h"
 #include "media_log.h"
+#include "medialibrary_album_cache.h"
 
 using namespace std;
 using namespace OHOS::NativeRdb;
@@ -28,6 +29,7 @@ int64_t MediaLibraryAlbumDb::InsertAlbumInfo(const ValuesBucket &values, const s
     int64_t outRowId(0);
     int32_t insertResult = rdbStore->Insert(outRowId, MEDIALIBRARY_TABLE, values);
     CHECK_AND_RETURN_RET_LOG(insertResult == NativeRdb::E_OK, ALBUM_OPERATION_ERR, "Insert failed");
+    MediaLibraryAlbumCache::GetInstance()->Insert(outRowId, values, rdbStore);
 
     return outRowId;
 }
@@ -51,6 +53,8 @@ int32_t MediaLibraryAlbumDb::UpdateAlbumInfo(const ValuesBucket &values, const s
 
     int32_t updateResult = rdbStore->Update(updatedRows, MEDIALIBRARY_TABLE, values, ALBUM_DB_COND, whereArgs);
     CHECK_AND_RETURN_RET_LOG(updateResult == NativeRdb::E_OK, ALBUM_OPERATION_ERR, "Update failed");
+    // A renamed album moves its whole subtree, let the cache reload rather than patch every child
+    MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore);
 
     return (updatedRows > 0) ? DATA_ABILITY_SUCCESS : DATA_ABILITY_FAIL;
 }
@@ -64,6 +68,7 @@ int32_t MediaLibraryAlbumDb::DeleteAlbumInfo(const int32_t albumId, const shared
 
     int32_t deleteResult = rdbStore->Delete(deletedRows, MEDIALIBRARY_TABLE, ALBUM_DB_COND, whereArgs);
     CHECK_AND_RETURN_RET_LOG(deleteResult == NativeRdb::E_OK, ALBUM_OPERATION_ERR, "Delete failed");
+    MediaLibraryAlbumCache::GetInstance()->Erase(albumId, rdbStore);
 
     return (deletedRows > 0) ? DATA_ABILITY_SUCCESS : DATA_ABILITY_FAIL;
 }
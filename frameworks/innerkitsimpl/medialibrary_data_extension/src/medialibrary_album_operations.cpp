@@ -16,6 +16,7 @@
 #include "medialibrary_album_operations.h"
 #include "media_file_utils.h"
 #include "media_log.h"
+#include "medialibrary_album_cache.h"
 #include "medialibrary_data_manager_utils.h"
 
 using namespace std;
@@ -101,6 +102,7 @@ int32_t UpdateAlbumInfoUtil(const ValuesBucket &valuesBucket,
         if (deleteResult != NativeRdb::E_OK) {
             MEDIA_ERR_LOG("Delete rows failed");
         }
+        MediaLibraryAlbumCache::GetInstance()->Erase(albumPath, rdbStore);
         return DATA_ABILITY_SUCCESS;
     }
 
@@ -128,6 +130,7 @@ int32_t UpdateAlbumInfoUtil(const ValuesBucket &valuesBucket,
 
         auto ret = rdbStore->ExecuteSql(modifyAlbumInternalsStmt);
         CHECK_AND_PRINT_LOG(ret == 0, "Album update sql failed");
+        MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore);
     }
 
     return retVal;
@@ -148,6 +151,7 @@ int32_t DeleteAlbumInfoUtil(const ValuesBucket &valuesBucket, int32_t albumId, c
         if (deleteResult != NativeRdb::E_OK) {
             MEDIA_ERR_LOG("Delete rows failed");
         }
+        MediaLibraryAlbumCache::GetInstance()->Erase(albumPath, rdbStore);
     }
 
     return retVal;
@@ -0,0 +1,322 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_album_stats.h"
+
+#include "media_data_ability_const.h"
+#include "media_lib_service_const.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+namespace {
+const string BUCKET = to_string(ALBUM_STATS_TYPE_BUCKET);
+const string SMART = to_string(ALBUM_STATS_TYPE_SMART);
+const string SMART_MEDIA_TYPE = to_string(MEDIA_TYPE_SMARTALBUM);
+
+string Column(const string &row, const string &column)
+{
+    return row + "." + column;
+}
+
+// 1 when the file row is not trashed, 0 otherwise
+string VisibleCount(const string &row)
+{
+    return "(CASE WHEN " + Column(row, MEDIA_DATA_DB_DATE_TRASHED) + " = 0 THEN 1 ELSE 0 END)";
+}
+
+string VisibleSize(const string &row)
+{
+    return "(CASE WHEN " + Column(row, MEDIA_DATA_DB_DATE_TRASHED) + " = 0 THEN IFNULL(" +
+        Column(row, MEDIA_DATA_DB_SIZE) + ", 0) ELSE 0 END)";
+}
+
+// The file row replaces the current cover of the statistics row being updated
+string IsNewCover(const string &row)
+{
+    string dateAdded = "IFNULL(" + Column(row, MEDIA_DATA_DB_DATE_ADDED) + ", 0)";
+    return "(" + Column(row, MEDIA_DATA_DB_DATE_TRASHED) + " = 0 AND (" + dateAdded + " > " +
+        Column(ALBUM_STATS_TABLE, ALBUM_STATS_DB_LATEST_DATE_ADDED) + " OR (" + dateAdded + " = " +
+        Column(ALBUM_STATS_TABLE, ALBUM_STATS_DB_LATEST_DATE_ADDED) + " AND " + Column(row, MEDIA_DATA_DB_ID) +
+        " > " + Column(ALBUM_STATS_TABLE, MEDIA_DATA_DB_COVER_ID) + ")))";
+}
+
+string SetCover(const string &row)
+{
+    return ALBUM_STATS_DB_LATEST_DATE_ADDED + " = IFNULL(" + Column(row, MEDIA_DATA_DB_DATE_ADDED) + ", 0), " +
+        MEDIA_DATA_DB_COVER_ID + " = " + Column(row, MEDIA_DATA_DB_ID);
+}
+
+// Same members as the Album view: everything below a bucket except albums and plain files
+string IsBucketMember(const string &row)
+{
+    return Column(row, MEDIA_DATA_DB_BUCKET_ID) + " IS NOT NULL AND " + Column(row, MEDIA_DATA_DB_MEDIA_TYPE) +
+        " <> " + to_string(MEDIA_TYPE_ALBUM) + " AND " + Column(row, MEDIA_DATA_DB_MEDIA_TYPE) + " <> " +
+        to_string(MEDIA_TYPE_FILE);
+}
+
+string BucketKey(const string &row)
+{
+    return ALBUM_STATS_DB_TYPE + " = " + BUCKET + " AND " + ALBUM_STATS_DB_ALBUM_ID + " = " +
+        Column(row, MEDIA_DATA_DB_BUCKET_ID) + " AND " + MEDIA_DATA_DB_MEDIA_TYPE + " = " +
+        Column(row, MEDIA_DATA_DB_MEDIA_TYPE);
+}
+
+string SmartKey(const string &albumId)
+{
+    return ALBUM_STATS_DB_TYPE + " = " + SMART + " AND " + ALBUM_STATS_DB_ALBUM_ID + " = " + albumId + " AND " +
+        MEDIA_DATA_DB_MEDIA_TYPE + " = " + SMART_MEDIA_TYPE;
+}
+
+// Smart albums holding the asset
+string SmartAlbumsOf(const string &assetId)
+{
+    return ALBUM_STATS_DB_TYPE + " = " + SMART + " AND " + ALBUM_STATS_DB_ALBUM_ID + " IN (SELECT " +
+        SMARTALBUMMAP_DB_ALBUM_ID + " FROM " + SMARTALBUM_MAP_TABLE + " WHERE " + SMARTALBUMMAP_DB_ASSET_ID + " = " +
+        assetId + ")";
+}
+
+// How many times the asset is mapped into the smart album being updated
+string SmartMapCount(const string &assetId)
+{
+    return "(SELECT COUNT(*) FROM " + SMARTALBUM_MAP_TABLE + " WHERE " + SMARTALBUMMAP_DB_ALBUM_ID + " = " +
+        Column(ALBUM_STATS_TABLE, ALBUM_STATS_DB_ALBUM_ID) + " AND " + SMARTALBUMMAP_DB_ASSET_ID + " = " + assetId +
+        ")";
+}
+
+string AssetColumn(const string &assetId, const string &expr)
+{
+    return "(SELECT " + expr + " FROM " + MEDIALIBRARY_TABLE + " WHERE " + MEDIA_DATA_DB_ID + " = " + assetId +
+        " AND " + MEDIA_DATA_DB_DATE_TRASHED + " = 0)";
+}
+
+// Recomputes the cover of the matching rows, one index seek on idx_files_bucket per bucket row
+string RefreshBucketCover(const string &where)
+{
+    string latest = " FROM " + MEDIALIBRARY_TABLE + " WHERE " + MEDIA_DATA_DB_BUCKET_ID + " = " +
+        Column(ALBUM_STATS_TABLE, ALBUM_STATS_DB_ALBUM_ID) + " AND " + MEDIA_DATA_DB_MEDIA_TYPE + " = " +
+        Column(ALBUM_STATS_TABLE, MEDIA_DATA_DB_MEDIA_TYPE) + " AND " + MEDIA_DATA_DB_DATE_TRASHED + " = 0" +
+        " ORDER BY " + MEDIA_DATA_DB_DATE_ADDED + " DESC, " + MEDIA_DATA_DB_ID + " DESC LIMIT 1";
+    return "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_LATEST_DATE_ADDED + " = IFNULL((SELECT IFNULL(" +
+        MEDIA_DATA_DB_DATE_ADDED + ", 0)" + latest + "), 0), " + MEDIA_DATA_DB_COVER_ID + " = IFNULL((SELECT " +
+        MEDIA_DATA_DB_ID + latest + "), 0) WHERE " + where + ";";
+}
+
+string RefreshSmartCover(const string &where)
+{
+    const string map = "m";
+    const string file = "f";
+    string latest = " FROM " + SMARTALBUM_MAP_TABLE + " " + map + ", " + MEDIALIBRARY_TABLE + " " + file +
+        " WHERE " + Column(map, SMARTALBUMMAP_DB_ALBUM_ID) + " = " +
+        Column(ALBUM_STATS_TABLE, ALBUM_STATS_DB_ALBUM_ID) + " AND " + Column(file, MEDIA_DATA_DB_ID) + " = " +
+        Column(map, SMARTALBUMMAP_DB_ASSET_ID) + " AND " + Column(file, MEDIA_DATA_DB_DATE_TRASHED) + " = 0" +
+        " ORDER BY " + Column(file, MEDIA_DATA_DB_DATE_ADDED) + " DESC, " + Column(file, MEDIA_DATA_DB_ID) +
+        " DESC LIMIT 1";
+    return "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_LATEST_DATE_ADDED + " = IFNULL((SELECT IFNULL(" +
+        Column(file, MEDIA_DATA_DB_DATE_ADDED) + ", 0)" + latest + "), 0), " + MEDIA_DATA_DB_COVER_ID +
+        " = IFNULL((SELECT " + Column(file, MEDIA_DATA_DB_ID) + latest + "), 0) WHERE " + where + ";";
+}
+
+string DropEmpty(const string &key)
+{
+    return "DELETE FROM " + ALBUM_STATS_TABLE + " WHERE " + key + " AND " + ALBUM_STATS_DB_TOTAL + " <= 0;";
+}
+
+string AddToBucket(const string &row)
+{
+    return "INSERT OR IGNORE INTO " + ALBUM_STATS_TABLE + " (" + ALBUM_STATS_DB_TYPE + ", " +
+        ALBUM_STATS_DB_ALBUM_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE + ") SELECT " + BUCKET + ", " +
+        Column(row, MEDIA_DATA_DB_BUCKET_ID) + ", " + Column(row, MEDIA_DATA_DB_MEDIA_TYPE) + " WHERE " +
+        IsBucketMember(row) + "; " +
+        "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_TOTAL + " = " + ALBUM_STATS_DB_TOTAL + " + 1, " +
+        MEDIA_DATA_DB_COUNT + " = " + MEDIA_DATA_DB_COUNT + " + " + VisibleCount(row) + ", " +
+        MEDIA_DATA_DB_SIZE + " = " + MEDIA_DATA_DB_SIZE + " + " + VisibleSize(row) + ", " +
+        ALBUM_STATS_DB_LATEST_DATE_ADDED + " = CASE WHEN " + IsNewCover(row) + " THEN IFNULL(" +
+        Column(row, MEDIA_DATA_DB_DATE_ADDED) + ", 0) ELSE " + ALBUM_STATS_DB_LATEST_DATE_ADDED + " END, " +
+        MEDIA_DATA_DB_COVER_ID + " = CASE WHEN " + IsNewCover(row) + " THEN " + Column(row, MEDIA_DATA_DB_ID) +
+        " ELSE " + MEDIA_DATA_DB_COVER_ID + " END WHERE " + BucketKey(row) + ";";
+}
+
+string RemoveFromBucket(const string &row)
+{
+    return "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_TOTAL + " = " + ALBUM_STATS_DB_TOTAL + " - 1, " +
+        MEDIA_DATA_DB_COUNT + " = " + MEDIA_DATA_DB_COUNT + " - " + VisibleCount(row) + ", " +
+        MEDIA_DATA_DB_SIZE + " = " + MEDIA_DATA_DB_SIZE + " - " + VisibleSize(row) + " WHERE " + BucketKey(row) +
+        "; " + RefreshBucketCover(BucketKey(row) + " AND " + MEDIA_DATA_DB_COVER_ID + " = " +
+        Column(row, MEDIA_DATA_DB_ID)) + " " + DropEmpty(BucketKey(row));
+}
+
+string AddToSmartAlbum(const string &row)
+{
+    string albumId = Column(row, SMARTALBUMMAP_DB_ALBUM_ID);
+    string assetId = Column(row, SMARTALBUMMAP_DB_ASSET_ID);
+    return "INSERT OR IGNORE INTO " + ALBUM_STATS_TABLE + " (" + ALBUM_STATS_DB_TYPE + ", " +
+        ALBUM_STATS_DB_ALBUM_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE + ") VALUES (" + SMART + ", " + albumId + ", " +
+        SMART_MEDIA_TYPE + "); " +
+        "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_TOTAL + " = " + ALBUM_STATS_DB_TOTAL + " + 1, " +
+        MEDIA_DATA_DB_COUNT + " = " + MEDIA_DATA_DB_COUNT + " + " + AssetColumn(assetId, "COUNT(*)") + ", " +
+        MEDIA_DATA_DB_SIZE + " = " + MEDIA_DATA_DB_SIZE + " + IFNULL(" +
+        AssetColumn(assetId, "IFNULL(" + MEDIA_DATA_DB_SIZE + ", 0)") + ", 0) WHERE " + SmartKey(albumId) + "; " +
+        "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_LATEST_DATE_ADDED + " = IFNULL(" +
+        AssetColumn(assetId, "IFNULL(" + MEDIA_DATA_DB_DATE_ADDED + ", 0)") + ", 0), " + MEDIA_DATA_DB_COVER_ID +
+        " = " + assetId + " WHERE " + SmartKey(albumId) + " AND EXISTS (SELECT 1 FROM " + MEDIALIBRARY_TABLE +
+        " WHERE " + MEDIA_DATA_DB_ID + " = " + assetId + " AND " + IsNewCover(MEDIALIBRARY_TABLE) + ");";
+}
+
+string RemoveFromSmartAlbum(const string &row)
+{
+    string albumId = Column(row, SMARTALBUMMAP_DB_ALBUM_ID);
+    string assetId = Column(row, SMARTALBUMMAP_DB_ASSET_ID);
+    return "UPDATE " + ALBUM_STATS_TABLE + " SET " + ALBUM_STATS_DB_TOTAL + " = " + ALBUM_STATS_DB_TOTAL + " - 1, " +
+        MEDIA_DATA_DB_COUNT + " = " + MEDIA_DATA_DB_COUNT + " - " + AssetColumn(assetId, "COUNT(*)") + ", " +
+        MEDIA_DATA_DB_SIZE + " = " + MEDIA_DATA_DB_SIZE + " - IFNULL(" +
+        AssetColumn(assetId, "IFNULL(" + MEDIA_DATA_DB_SIZE + ", 0)") + ", 0) WHERE " + SmartKey(albumId) + "; " +
+        RefreshSmartCover(SmartKey(albumId) + " AND " + MEDIA_DATA_DB_COVER_ID + " = " + assetId) + " " +
+        DropEmpty(SmartKey(albumId));
+}
+
+// A file changed or left Files: move its contribution in every smart album it is mapped into
+string UpdateSmartAlbumsOfFile(const string &oldRow, const string &newRow)
+{
+    string assetId = Column(oldRow, MEDIA_DATA_DB_ID);
+    string newCount = newRow.empty() ? "0" : VisibleCount(newRow);
+    string newSize = newRow.empty() ? "0" : VisibleSize(newRow);
+    string sql = "UPDATE " + ALBUM_STATS_TABLE + " SET " +
+        MEDIA_DATA_DB_COUNT + " = " + MEDIA_DATA_DB_COUNT + " + " + SmartMapCount(assetId) + " * (" + newCount +
+        " - " + VisibleCount(oldRow) + "), " +
+        MEDIA_DATA_DB_SIZE + " = " + MEDIA_DATA_DB_SIZE + " + " + SmartMapCount(assetId) + " * (" + newSize +
+        " - " + VisibleSize(oldRow) + ") WHERE " + SmartAlbumsOf(assetId) + "; " +
+        RefreshSmartCover(SmartAlbumsOf(assetId) + " AND " + MEDIA_DATA_DB_COVER_ID + " = " + assetId);
+    if (!newRow.empty()) {
+        sql += " UPDATE " + ALBUM_STATS_TABLE + " SET " + SetCover(newRow) + " WHERE " + SmartAlbumsOf(assetId) +
+            " AND " + IsNewCover(newRow) + ";";
+    }
+    return sql;
+}
+
+string CreateTrigger(const string &name, const string &event, const string &body, const string &when = "")
+{
+    return "CREATE TRIGGER IF NOT EXISTS " + name + " AFTER " + event + " FOR EACH ROW " +
+        (when.empty() ? "" : "WHEN " + when + " ") + "BEGIN " + body + " END";
+}
+
+// An UPDATE OF trigger fires whenever the column is in the SET list, and the scanner and sync write
+// every column of a row. The WHEN clause keeps the statistics untouched unless a value really changed.
+string AnyChanged(const vector<string> &columns)
+{
+    string when;
+    for (const auto &column : columns) {
+        when += (when.empty() ? "" : " OR ") + Column("old", column) + " IS NOT " + Column("new", column);
+    }
+    return when;
+}
+
+string UpdateOf(const vector<string> &columns, const string &table)
+{
+    string updateOf;
+    for (const auto &column : columns) {
+        updateOf += (updateOf.empty() ? "" : ", ") + column;
+    }
+    return "UPDATE OF " + updateOf + " ON " + table;
+}
+
+const vector<string> FILES_STATS_COLUMNS { MEDIA_DATA_DB_BUCKET_ID, MEDIA_DATA_DB_MEDIA_TYPE,
+    MEDIA_DATA_DB_DATE_TRASHED, MEDIA_DATA_DB_SIZE, MEDIA_DATA_DB_DATE_ADDED };
+const vector<string> MAP_STATS_COLUMNS { SMARTALBUMMAP_DB_ALBUM_ID, SMARTALBUMMAP_DB_ASSET_ID };
+
+const vector<string> ALBUM_STATS_TRIGGER_NAMES { "album_stats_files_insert", "album_stats_files_delete",
+    "album_stats_files_update", "album_stats_map_insert", "album_stats_map_delete", "album_stats_map_update" };
+
+const vector<string> ALBUM_STATS_TRIGGERS {
+    CreateTrigger("album_stats_files_insert", "INSERT ON " + MEDIALIBRARY_TABLE, AddToBucket("new")),
+    CreateTrigger("album_stats_files_delete", "DELETE ON " + MEDIALIBRARY_TABLE,
+        RemoveFromBucket("old") + " " + UpdateSmartAlbumsOfFile("old", "")),
+    CreateTrigger("album_stats_files_update", UpdateOf(FILES_STATS_COLUMNS, MEDIALIBRARY_TABLE),
+        RemoveFromBucket("old") + " " + AddToBucket("new") + " " + UpdateSmartAlbumsOfFile("old", "new"),
+        AnyChanged(FILES_STATS_COLUMNS)),
+    CreateTrigger("album_stats_map_insert", "INSERT ON " + SMARTALBUM_MAP_TABLE, AddToSmartAlbum("new")),
+    CreateTrigger("album_stats_map_delete", "DELETE ON " + SMARTALBUM_MAP_TABLE, RemoveFromSmartAlbum("old")),
+    CreateTrigger("album_stats_map_update", UpdateOf(MAP_STATS_COLUMNS, SMARTALBUM_MAP_TABLE),
+        RemoveFromSmartAlbum("old") + " " + AddToSmartAlbum("new"), AnyChanged(MAP_STATS_COLUMNS)),
+};
+
+const string FILL_BUCKET_STATS = "INSERT INTO " + ALBUM_STATS_TABLE + " (" + ALBUM_STATS_DB_TYPE + ", " +
+    ALBUM_STATS_DB_ALBUM_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE + ", " + MEDIA_DATA_DB_COUNT + ", " +
+    ALBUM_STATS_DB_TOTAL + ", " + MEDIA_DATA_DB_SIZE + ") SELECT " + BUCKET + ", " + MEDIA_DATA_DB_BUCKET_ID + ", " +
+    MEDIA_DATA_DB_MEDIA_TYPE + ", SUM" + VisibleCount(MEDIALIBRARY_TABLE) + ", COUNT(*), SUM" +
+    VisibleSize(MEDIALIBRARY_TABLE) + " FROM " + MEDIALIBRARY_TABLE + " WHERE " + IsBucketMember(MEDIALIBRARY_TABLE) +
+    " GROUP BY " + MEDIA_DATA_DB_BUCKET_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE;
+const string FILL_SMART_STATS = "INSERT INTO " + ALBUM_STATS_TABLE + " (" + ALBUM_STATS_DB_TYPE + ", " +
+    ALBUM_STATS_DB_ALBUM_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE + ", " + MEDIA_DATA_DB_COUNT + ", " +
+    ALBUM_STATS_DB_TOTAL + ", " + MEDIA_DATA_DB_SIZE + ") SELECT " + SMART + ", " +
+    Column(SMARTALBUM_MAP_TABLE, SMARTALBUMMAP_DB_ALBUM_ID) + ", " + SMART_MEDIA_TYPE + ", IFNULL(SUM" +
+    VisibleCount(MEDIALIBRARY_TABLE) + ", 0), COUNT(*), IFNULL(SUM" + VisibleSize(MEDIALIBRARY_TABLE) + ", 0) FROM " +
+    SMARTALBUM_MAP_TABLE + " LEFT JOIN " + MEDIALIBRARY_TABLE + " ON " + Column(MEDIALIBRARY_TABLE, MEDIA_DATA_DB_ID) +
+    " = " + Column(SMARTALBUM_MAP_TABLE, SMARTALBUMMAP_DB_ASSET_ID) + " WHERE " +
+    Column(SMARTALBUM_MAP_TABLE, SMARTALBUMMAP_DB_ALBUM_ID) + " IS NOT NULL GROUP BY " +
+    Column(SMARTALBUM_MAP_TABLE, SMARTALBUMMAP_DB_ALBUM_ID);
+
+vector<string> CreateSqls()
+{
+    vector<string> sqls { CREATE_ALBUM_STATS_TABLE, CREATE_SMARTALBUMMAP_ALBUM_INDEX,
+        CREATE_SMARTALBUMMAP_ASSET_INDEX };
+    sqls.insert(sqls.end(), ALBUM_STATS_TRIGGERS.begin(), ALBUM_STATS_TRIGGERS.end());
+    return sqls;
+}
+
+vector<string> RebuildSqls()
+{
+    vector<string> sqls { CREATE_ALBUM_STATS_TABLE, CREATE_SMARTALBUMMAP_ALBUM_INDEX,
+        CREATE_SMARTALBUMMAP_ASSET_INDEX, "DELETE FROM " + ALBUM_STATS_TABLE, FILL_BUCKET_STATS, FILL_SMART_STATS };
+    // RefreshBucketCover and RefreshSmartCover are trigger statements, drop the terminating semicolon
+    string refreshBucket = RefreshBucketCover(ALBUM_STATS_DB_TYPE + " = " + BUCKET);
+    string refreshSmart = RefreshSmartCover(ALBUM_STATS_DB_TYPE + " = " + SMART);
+    sqls.push_back(refreshBucket.substr(0, refreshBucket.length() - 1));
+    sqls.push_back(refreshSmart.substr(0, refreshSmart.length() - 1));
+    sqls.insert(sqls.end(), ALBUM_STATS_TRIGGERS.begin(), ALBUM_STATS_TRIGGERS.end());
+    return sqls;
+}
+
+vector<string> RecreateTriggerSqls()
+{
+    vector<string> sqls;
+    for (const auto &name : ALBUM_STATS_TRIGGER_NAMES) {
+        sqls.push_back("DROP TRIGGER IF EXISTS " + name);
+    }
+    sqls.insert(sqls.end(), ALBUM_STATS_TRIGGERS.begin(), ALBUM_STATS_TRIGGERS.end());
+    return sqls;
+}
+} // namespace
+
+const vector<string> &MediaLibraryAlbumStats::GetCreateSqls()
+{
+    static const vector<string> sqls = CreateSqls();
+    return sqls;
+}
+
+const vector<string> &MediaLibraryAlbumStats::GetRebuildSqls()
+{
+    static const vector<string> sqls = RebuildSqls();
+    return sqls;
+}
+
+const vector<string> &MediaLibraryAlbumStats::GetRecreateTriggerSqls()
+{
+    static const vector<string> sqls = RecreateTriggerSqls();
+    return sqls;
+}
+} // namespace Media
+} // namespace OHOS
@@ -15,6 +15,7 @@
 
 #include "medialibrary_data_manager.h"
 
+#include <map>
 #include <unordered_set>
 
 #include "accesstoken_kit.h"
@@ -23,6 +24,10 @@
 #include "file_ex.h"
 #include "ipc_singleton.h"
 #include "media_file_utils.h"
+#include "medialibrary_album_cache.h"
+#include "medialibrary_album_stats.h"
+#include "medialibrary_pull_cache.h"
+#include "medialibrary_sync_scheduler.h"
 #include "medialibrary_sync_table.h"
 #include "ipc_skeleton.h"
 #include "sa_mgr_client.h"
@@ -60,10 +65,96 @@ const std::unordered_set<std::string> SYSTEM_BUNDLE_FREE_CHECK {
     "com.ohos.screenshot"
 };
 std::mutex bundleMgrMutex;
+
+const std::vector<std::string> FILES_INDEXES {
+    CREATE_FILES_DATA_INDEX,
+    CREATE_FILES_PARENT_INDEX,
+    CREATE_FILES_BUCKET_INDEX,
+    CREATE_FILES_MEDIA_TYPE_INDEX,
+    CREATE_FILES_RELATIVE_PATH_INDEX,
+    CREATE_FILES_DATE_TRASHED_INDEX,
+    CREATE_FILES_DATE_ADDED_INDEX,
+    CREATE_FILES_DATE_MODIFIED_INDEX
+};
+
+bool IsAlbumValues(const ValuesBucket &values)
+{
+    ValueObject valueObject;
+    int32_t mediaType = MEDIA_TYPE_FILE;
+    return values.GetObject(MEDIA_DATA_DB_MEDIA_TYPE, valueObject) &&
+        (valueObject.GetInt(mediaType) == NativeRdb::E_OK) && (mediaType == MEDIA_TYPE_ALBUM);
+}
+
+// Columns the album cache keeps, an update touching them through arbitrary predicates invalidates it
+bool ChangesAlbumCache(const ValuesBucket &values)
+{
+    return values.HasColumn(MEDIA_DATA_DB_FILE_PATH) || values.HasColumn(MEDIA_DATA_DB_NAME) ||
+        values.HasColumn(MEDIA_DATA_DB_TITLE) || values.HasColumn(MEDIA_DATA_DB_MEDIA_TYPE);
+}
+
+int32_t ExecuteSqls(RdbStore &store, const std::vector<std::string> &sqls)
+{
+    for (const auto &sql : sqls) {
+        int32_t errCode = store.ExecuteSql(sql);
+        if (errCode != NativeRdb::E_OK) {
+            MEDIA_ERR_LOG("Execute sql failed %{public}d, sql: %{private}s", errCode, sql.c_str());
+            return errCode;
+        }
+    }
+    return NativeRdb::E_OK;
+}
+
+int32_t UpgradeFilesIndex(RdbStore &store)
+{
+    return ExecuteSqls(store, FILES_INDEXES);
+}
+
+// The Album view is recreated on top of AlbumStats by UpgradeAlbumStats
+int32_t UpgradeAlbumCover(RdbStore &store)
+{
+    return ExecuteSqls(store, { "DROP VIEW IF EXISTS " + ABLUM_VIEW_NAME });
+}
+
+int32_t UpgradeAlbumStats(RdbStore &store)
+{
+    int32_t errCode = ExecuteSqls(store, MediaLibraryAlbumStats::GetRebuildSqls());
+    if (errCode != NativeRdb::E_OK) {
+        return errCode;
+    }
+    return ExecuteSqls(store, { "DROP VIEW IF EXISTS " + ABLUM_VIEW_NAME, CREATE_ABLUM_VIEW,
+        "DROP VIEW IF EXISTS " + SMARTABLUMASSETS_VIEW_NAME, CREATE_SMARTABLUMASSETS_VIEW });
+}
+
+int32_t UpgradeAlbumStatsTriggers(RdbStore &store)
+{
+    return ExecuteSqls(store, MediaLibraryAlbumStats::GetRecreateTriggerSqls());
+}
+
+#ifdef RDB_UPGRADE_MOCK
+int32_t UpgradeMockColumn(RdbStore &store)
+{
+    const std::string ALTER_MOCK_COLUMN = "ALTER TABLE " + MEDIALIBRARY_TABLE +
+                                          " ADD COLUMN upgrade_test_column INT DEFAULT 0";
+    return store.ExecuteSql(ALTER_MOCK_COLUMN);
+}
+#endif
+
+// Upgrade step per target version, applied in order from oldVersion + 1 up to newVersion
+using RdbUpgradeFunc = int32_t (*)(RdbStore &store);
+const std::map<int32_t, RdbUpgradeFunc> RDB_UPGRADE_STEPS {
+    { MEDIA_RDB_VERSION_FILES_INDEX, UpgradeFilesIndex },
+    { MEDIA_RDB_VERSION_ALBUM_COVER, UpgradeAlbumCover },
+    { MEDIA_RDB_VERSION_ALBUM_STATS, UpgradeAlbumStats },
+    { MEDIA_RDB_VERSION_ALBUM_STATS_TRIGGERS, UpgradeAlbumStatsTriggers },
+#ifdef RDB_UPGRADE_MOCK
+    { MEDIA_RDB_VERSION_UPGRADE_MOCK, UpgradeMockColumn },
+#endif
+};
 }
 
 std::shared_ptr<MediaLibraryDataManager> MediaLibraryDataManager::instance_ = nullptr;
 std::mutex MediaLibraryDataManager::mutex_;
+std::recursive_mutex MediaLibraryDataManager::writerLock_;
 
 std::shared_ptr<MediaLibraryDataManager> MediaLibraryDataManager::GetInstance()
 {
@@ -97,6 +188,17 @@ void MediaLibraryDataManager::InitMediaLibraryMgr(const std::shared_ptr<OHOS::Ab
     context_ = context;
     InitMediaLibraryRdbStore();
     MEDIA_INFO_LOG("bundleName = %{private}s", bundleName_.c_str());
+    if (rdbStore_ != nullptr) {
+        MediaLibrarySyncScheduler::GetInstance()->Start([rdbStore = rdbStore_, bundleName = bundleName_](
+            const string &tableName) {
+            MediaLibrarySyncTable syncTable;
+            vector<string> devices;
+            return syncTable.SyncPushTable(rdbStore, bundleName, tableName, devices);
+        });
+        MediaLibraryPullCache::GetInstance()->Start([this](const string &deviceId, const string &tableName) {
+            return QuerySync(deviceId, tableName);
+        });
+    }
     MediaLibraryDevice::GetInstance()->SetAbilityContext(move(context));
     SubscribeRdbStoreObserver();
     InitDeviceData();
@@ -111,14 +213,19 @@ void MediaLibraryDataManager::InitMediaLibraryMgr(const std::shared_ptr<OHOS::Ab
     }
     InitialiseKvStore();
 
-    // scan the media dir
+    // watch the media dir before scanning it, so changes made during the scan are not missed
     std::string srcPath = "/storage/media/local/files";
+    MediaScannerObj::GetMediaScannerInstance()->StartWatching(srcPath);
     MediaScannerObj::GetMediaScannerInstance()->ScanDir(srcPath, nullptr);
 }
 
 void MediaLibraryDataManager::ClearMediaLibraryMgr()
 {
     MEDIA_INFO_LOG("MediaLibraryDataManager::OnStop");
+    MediaScannerObj::GetMediaScannerInstance()->StopWatching();
+    MediaLibraryAlbumCache::GetInstance()->Reset();
+    MediaLibraryPullCache::GetInstance()->Stop();
+    MediaLibrarySyncScheduler::GetInstance()->Stop();
     rdbStore_ = nullptr;
     isRdbStoreInitialized = false;
     if (kvStorePtr_ != nullptr) {
@@ -168,6 +275,9 @@ int32_t MediaLibraryDataCallBack::OnCreate(RdbStore &store)
     if (error_code == NativeRdb::E_OK) {
         error_code = store.ExecuteSql(CREATE_CATEGORY_SMARTALBUMMAP_TABLE);
     }
+    if (error_code == NativeRdb::E_OK) {
+        error_code = ExecuteSqls(store, MediaLibraryAlbumStats::GetCreateSqls());
+    }
     if (error_code == NativeRdb::E_OK) {
         error_code = store.ExecuteSql(CREATE_IMAGE_VIEW);
     }
@@ -186,6 +296,9 @@ int32_t MediaLibraryDataCallBack::OnCreate(RdbStore &store)
     if (error_code == NativeRdb::E_OK) {
         error_code= store.ExecuteSql(CREATE_ASSETMAP_VIEW);
     }
+    if (error_code == NativeRdb::E_OK) {
+        error_code = ExecuteSqls(store, FILES_INDEXES);
+    }
     if (error_code == NativeRdb::E_OK) {
         isDistributedTables = true;
     }
@@ -194,16 +307,18 @@ int32_t MediaLibraryDataCallBack::OnCreate(RdbStore &store)
 
 int32_t MediaLibraryDataCallBack::OnUpgrade(RdbStore &store, int32_t oldVersion, int32_t newVersion)
 {
-#ifdef RDB_UPGRADE_MOCK
-    const std::string ALTER_MOCK_COLUMN = "ALTER TABLE " + MEDIALIBRARY_TABLE +
-                                          " ADD COLUMN upgrade_test_column INT DEFAULT 0";
     MEDIA_INFO_LOG("OnUpgrade |Rdb Verison %{private}d => %{private}d", oldVersion, newVersion);
-    int32_t error_code = NativeRdb::E_ERROR;
-    error_code = store.ExecuteSql(ALTER_MOCK_COLUMN);
-    if (error_code != NativeRdb::E_OK) {
-        MEDIA_INFO_LOG("Upgrade rdb error %{private}d", error_code);
+    for (int32_t version = oldVersion + 1; version <= newVersion; version++) {
+        auto step = RDB_UPGRADE_STEPS.find(version);
+        if (step == RDB_UPGRADE_STEPS.end()) {
+            continue;
+        }
+        int32_t error_code = step->second(store);
+        if (error_code != NativeRdb::E_OK) {
+            MEDIA_ERR_LOG("Upgrade rdb to version %{private}d error %{private}d", version, error_code);
+            return error_code;
+        }
     }
-#endif
     return NativeRdb::E_OK;
 }
 
@@ -228,37 +343,53 @@ int32_t MediaLibraryDataManager::InitMediaLibraryRdbStore()
     config.SetName(MEDIA_DATA_ABILITY_DB_NAME);
     config.SetRelativePath(relativePath);
     config.SetEncryptLevel(ENCRYPTION_LEVEL);
+    // In WAL the store serves Query from its pool of read connections while its single write
+    // connection holds a scanner batch or a sync, instead of queueing queries behind the commit
+    config.SetJournalMode(JournalMode::MODE_WAL);
 
     MediaLibraryDataCallBack rdbDataCallBack;
 
-    rdbStore_ = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION, rdbDataCallBack, errCode);
-    if (rdbStore_ == nullptr) {
+    shared_ptr<RdbStore> rdbStore = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION, rdbDataCallBack, errCode);
+    if (rdbStore == nullptr) {
         MEDIA_ERR_LOG("InitMediaRdbStore GetRdbStore is failed ");
         return errCode;
     }
 
     if (rdbDataCallBack.GetDistributedTables()) {
-        auto ret = rdbStore_->SetDistributedTables(
+        auto ret = rdbStore->SetDistributedTables(
             {MEDIALIBRARY_TABLE, SMARTALBUM_TABLE, SMARTALBUM_MAP_TABLE, CATEGORY_SMARTALBUM_MAP_TABLE});
         MEDIA_INFO_LOG("InitMediaLibraryRdbStore ret = %{private}d", ret);
     }
 
+    return InitMediaLibraryRdbStore(rdbStore);
+}
+
+int32_t MediaLibraryDataManager::InitMediaLibraryRdbStore(const shared_ptr<RdbStore> &rdbStore)
+{
+    if (rdbStore == nullptr) {
+        MEDIA_ERR_LOG("InitMediaLibraryRdbStore: Rdb Store is null");
+        return DATA_ABILITY_FAIL;
+    }
+
+    rdbStore_ = rdbStore;
+    MediaLibraryAlbumCache::GetInstance()->Init(rdbStore_);
     isRdbStoreInitialized = true;
     mediaThumbnail_ = std::make_shared<MediaLibraryThumbnail>();
     MEDIA_INFO_LOG("InitMediaLibraryRdbStore SUCCESS");
     return DATA_ABILITY_SUCCESS;
 }
 
+shared_ptr<RdbStore> MediaLibraryDataManager::GetRdbStore() const
+{
+    return rdbStore_;
+}
+
 std::string MediaLibraryDataManager::GetType(const Uri &uri)
 {
     string getTypeUri = uri.ToString();
-    // If get uri contains media operation keyword, follow media operation procedure
-    if (getTypeUri.find(MEDIA_OPERN_KEYWORD) != string::npos) {
+    if (MediaLibraryUriRouter::Parse(getTypeUri).group == UriOprnGroup::KVSTORE) {
         MediaLibraryKvStoreOperations kvStoreOprn;
-
-        if (getTypeUri.find(MEDIA_KVSTOREOPRN) != string::npos) {
-            return kvStoreOprn.HandleKvStoreGetOperations(getTypeUri, kvStorePtr_);
-        }
+        return kvStoreOprn.HandleKvStoreGetOperations(getTypeUri, kvStorePtr_);
     }
     return "";
 }
@@ -291,51 +422,65 @@ int32_t MediaLibraryDataManager::Insert(const Uri &uri, const DataShareValuesBuc
     }
 
     ValuesBucket value = RdbUtils::ToValuesBucket(dataShareValue);
-    MediaLibrarySyncTable syncTable;
-    std::vector<std::string> devices = std::vector<std::string>();
+    auto syncScheduler = MediaLibrarySyncScheduler::GetInstance();
+    MediaLibraryUri route = MediaLibraryUriRouter::Parse(insertUri);
+    lock_guard<recursive_mutex> lock(writerLock_);
+    const string &operationType = route.operation;
     // If insert uri contains media opearation, follow media operation procedure
-    if (insertUri.find(MEDIA_OPERN_KEYWORD) != string::npos) {
-        MediaLibraryFileOperations fileOprn;
-        MediaLibraryAlbumOperations albumOprn;
-        MediaLibrarySmartAlbumOperations smartalbumOprn;
-        MediaLibrarySmartAlbumMapOperations smartalbumMapOprn;
-        MediaLibraryKvStoreOperations kvStoreOprn;
-
-        result = DATA_ABILITY_FAIL;
-        string operationType = MediaLibraryDataManagerUtils::GetOperationType(insertUri);
+    if (route.IsOprnUri()) {
         MEDIA_INFO_LOG("MediaData Insert operationType = %{private}s", operationType.c_str());
-        MEDIA_INFO_LOG("MediaData Insert uri = %{public}s", insertUri.c_str());
         if ((operationType == MEDIA_FILEOPRN_CREATEASSET ||
             operationType == MEDIA_ALBUMOPRN_CREATEALBUM) && !CheckFileNameValid(dataShareValue)) {
             return DATA_ABILITY_FILE_NAME_INVALID;
         }
-        if (insertUri.find(MEDIA_FILEOPRN) != string::npos) {
-            MEDIA_ERR_LOG("klh File %{public}s", insertUri.c_str());
-            result = fileOprn.HandleFileOperation(operationType, value, rdbStore_, mediaThumbnail_);
-            // After successful close asset operation, do a scan file
-            if ((result >= 0) && (operationType == MEDIA_FILEOPRN_CLOSEASSET)) {
-                ScanFile(value, rdbStore_);
+        result = DATA_ABILITY_FAIL;
+        switch (route.group) {
+            case UriOprnGroup::FILE: {
+                MediaLibraryFileOperations fileOprn;
+                result = fileOprn.HandleFileOperation(operationType, value, rdbStore_, mediaThumbnail_);
+                // After successful close asset operation, do a scan file
+                if ((result >= 0) && (operationType == MEDIA_FILEOPRN_CLOSEASSET)) {
+                    ScanFile(value, rdbStore_);
+                }
+                syncScheduler->MarkDirty(MEDIALIBRARY_TABLE);
+                break;
+            }
+            case UriOprnGroup::ALBUM: {
+                // Keeps the album it resolves, one per request
+                MediaLibraryAlbumOperations albumOprn;
+                result = albumOprn.HandleAlbumOperations(operationType, value, rdbStore_);
+                syncScheduler->MarkDirty(SMARTALBUM_TABLE);
+                break;
+            }
+            case UriOprnGroup::SMARTALBUM: {
+                MediaLibrarySmartAlbumOperations smartalbumOprn;
+                result = smartalbumOprn.HandleSmartAlbumOperations(operationType, value, rdbStore_);
+                syncScheduler->MarkDirty(SMARTALBUM_MAP_TABLE);
+                break;
             }
-            syncTable.SyncPushTable(rdbStore_, bundleName_, MEDIALIBRARY_TABLE, devices);
-        } else if (insertUri.find(MEDIA_ALBUMOPRN) != string::npos) {
-            MEDIA_ERR_LOG("klh Album %{public}s", insertUri.c_str());
-            result = albumOprn.HandleAlbumOperations(operationType, value, rdbStore_);
-            syncTable.SyncPushTable(rdbStore_, bundleName_, SMARTALBUM_TABLE, devices);
-        } else if (insertUri.find(MEDIA_SMARTALBUMOPRN) != string::npos) {
-            result = smartalbumOprn.HandleSmartAlbumOperations(operationType, value, rdbStore_);
-            syncTable.SyncPushTable(rdbStore_, bundleName_, SMARTALBUM_MAP_TABLE, devices);
-        } else if (insertUri.find(MEDIA_SMARTALBUMMAPOPRN) != string::npos) {
-            result = smartalbumMapOprn.HandleSmartAlbumMapOperations(operationType, value, rdbStore_);
-            syncTable.SyncPushTable(rdbStore_, bundleName_, CATEGORY_SMARTALBUM_MAP_TABLE, devices);
-        } else if (insertUri.find(MEDIA_KVSTOREOPRN) != string::npos) {
-            result = kvStoreOprn.HandleKvStoreInsertOperations(operationType, value, kvStorePtr_);
+            case UriOprnGroup::SMARTALBUMMAP: {
+                MediaLibrarySmartAlbumMapOperations smartalbumMapOprn;
+                result = smartalbumMapOprn.HandleSmartAlbumMapOperations(operationType, value, rdbStore_);
+                syncScheduler->MarkDirty(CATEGORY_SMARTALBUM_MAP_TABLE);
+                break;
+            }
+            case UriOprnGroup::KVSTORE: {
+                MediaLibraryKvStoreOperations kvStoreOprn;
+                result = kvStoreOprn.HandleKvStoreInsertOperations(operationType, value, kvStorePtr_);
+                break;
+            }
+            case UriOprnGroup::UNKNOWN:
+                MEDIA_ERR_LOG("MediaData Insert unknown operation uri %{private}s", route.uri.c_str());
+                result = DATA_ABILITY_FAIL;
+                break;
+            default:
+                break;
         }
         return result;
     }
 
     // boardcast operation
-    if (insertUri.find(MEDIA_BOARDCASTOPRN) != string::npos) {
-        std::string operationType = MediaLibraryDataManagerUtils::GetOperationType(insertUri);
+    if (route.group == UriOprnGroup::BOARDCAST) {
         MEDIA_INFO_LOG("MediaData Insert operationType = %{private}s", operationType.c_str());
         if (operationType == MEDIA_SCAN_OPERATION) {
             std::string path = "/storage/media/local/files";
@@ -347,8 +492,11 @@ int32_t MediaLibraryDataManager::Insert(const Uri &uri, const DataShareValuesBuc
     // Normal URI scenario
     int64_t outRowId = DATA_ABILITY_FAIL;
     (void)rdbStore_->Insert(outRowId, MEDIALIBRARY_TABLE, value);
+    if ((outRowId > 0) && IsAlbumValues(value)) {
+        MediaLibraryAlbumCache::GetInstance()->Insert(outRowId, value, rdbStore_);
+    }
 
-    syncTable.SyncPushTable(rdbStore_, bundleName_, MEDIALIBRARY_TABLE, devices);
+    syncScheduler->MarkDirty(MEDIALIBRARY_TABLE);
     return outRowId;
 }
 
@@ -362,26 +510,26 @@ int32_t MediaLibraryDataManager::Delete(const Uri &uri, const DataSharePredicate
     if (!CheckClientPermission(PERMISSION_NAME_WRITE_MEDIA)) {
         return DATA_ABILITY_PERMISSION_DENIED;
     }
-    string uriString = uri.ToString();
+    MediaLibraryUri route = MediaLibraryUriRouter::Parse(uri.ToString());
     string strDeleteCondition = predicates.GetWhereClause();
     if (strDeleteCondition.empty()) {
-        string::size_type pos = uriString.find_last_of('/');
-        CHECK_AND_RETURN_RET_LOG((pos != string::npos) && (pos == MEDIALIBRARY_DATA_URI.length()), DATA_ABILITY_FAIL,
-            "Invalid index position");
-
-        string strRow = uriString.substr(pos + 1);
-        CHECK_AND_RETURN_RET_LOG(MediaLibraryDataManagerUtils::IsNumber(strRow), DATA_ABILITY_FAIL, "Index not digit");
+        CHECK_AND_RETURN_RET_LOG(route.parent == MEDIALIBRARY_DATA_URI, DATA_ABILITY_FAIL, "Invalid index position");
+        CHECK_AND_RETURN_RET_LOG(MediaLibraryDataManagerUtils::IsNumber(route.operation), DATA_ABILITY_FAIL,
+            "Index not digit");
 
-        strDeleteCondition = MEDIA_DATA_DB_ID + " = " + strRow;
-        uriString = uriString.substr(0, pos);
+        strDeleteCondition = MEDIA_DATA_DB_ID + " = " + route.operation;
+    } else {
+        CHECK_AND_RETURN_RET_LOG(route.uri == MEDIALIBRARY_DATA_URI, DATA_ABILITY_FAIL, "Not Data ability Uri");
     }
 
-    // After removing the index values, check whether URI is correct
-    CHECK_AND_RETURN_RET_LOG(uriString == MEDIALIBRARY_DATA_URI, DATA_ABILITY_FAIL, "Not Data ability Uri");
-
     vector<string> whereArgs = predicates.GetWhereArgs();
     int32_t deletedRows = DATA_ABILITY_FAIL;
+    lock_guard<recursive_mutex> lock(writerLock_);
     (void)rdbStore_->Delete(deletedRows, MEDIALIBRARY_TABLE, strDeleteCondition, whereArgs);
+    if (deletedRows > 0) {
+        // The predicates may match any album, let the album cache reload
+        MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore_);
+    }
 
     return deletedRows;
 }
@@ -415,6 +563,18 @@ shared_ptr<ResultSetBridge> QueryBySmartTableType(TableType tabletype,
     return RdbUtils::ToResultSetBridge(queryResultSet);
 }
 
+string GetPullTableName(TableType tabletype)
+{
+    switch (tabletype) {
+        case TYPE_SMARTALBUM:
+            return SMARTALBUM_TABLE;
+        case TYPE_SMARTALBUM_MAP:
+            return SMARTALBUM_MAP_TABLE;
+        default:
+            return MEDIALIBRARY_TABLE;
+    }
+}
+
 shared_ptr<ResultSetBridge> QueryFile(string strQueryCondition,
     DataSharePredicates predicates,
     vector<string> columns,
@@ -486,10 +646,9 @@ shared_ptr<ResultSetBridge> QueryAlbum(string strQueryCondition,
             mediaLibAbsPredAlbum.SetWhereClause(strQueryCondition);
             mediaLibAbsPredAlbum.SetWhereArgs(predicates.GetWhereArgs());
             mediaLibAbsPredAlbum.SetOrder(predicates.GetOrder());
-            queryResultSet = rdbStore->Query(mediaLibAbsPredAlbum, columns);
-        } else {
-	    queryResultSet = rdbStore->QuerySql("SELECT * FROM " + ABLUM_VIEW_NAME);
-	}
+        }
+        // An empty projection selects every column of the view
+        queryResultSet = rdbStore->Query(mediaLibAbsPredAlbum, columns);
     }
     return RdbUtils::ToResultSetBridge(queryResultSet);
 }
@@ -517,113 +676,31 @@ shared_ptr<ResultSetBridge> QueryByViewType(TableType tabletype,
 {
     shared_ptr<AbsSharedResultSet> queryResultSet;
     if (tabletype == TYPE_ASSETSMAP_TABLE) {
-	string tableName = ASSETMAP_VIEW_NAME;
+        string tableName = ASSETMAP_VIEW_NAME;
         AbsRdbPredicates mediaLibAbsPredAlbum(tableName);
         if (!strQueryCondition.empty()) {
             mediaLibAbsPredAlbum.SetWhereClause(strQueryCondition);
             mediaLibAbsPredAlbum.SetWhereArgs(predicates.GetWhereArgs());
             mediaLibAbsPredAlbum.SetOrder(predicates.GetOrder());
-            queryResultSet = rdbStore->Query(mediaLibAbsPredAlbum, columns);
-        } else {
-            queryResultSet = rdbStore->QuerySql("SELECT * FROM " + ASSETMAP_VIEW_NAME);
-	}
+        }
+        queryResultSet = rdbStore->Query(mediaLibAbsPredAlbum, columns);
     } else if (tabletype == TYPE_SMARTALBUMASSETS_TABLE) {
         AbsRdbPredicates mediaLibAbsPredAlbum(SMARTABLUMASSETS_VIEW_NAME);
         if (!strQueryCondition.empty()) {
             mediaLibAbsPredAlbum.SetWhereClause(strQueryCondition);
             mediaLibAbsPredAlbum.SetWhereArgs(predicates.GetWhereArgs());
             mediaLibAbsPredAlbum.SetOrder(predicates.GetOrder());
-            queryResultSet = rdbStore->Query(mediaLibAbsPredAlbum, columns);
-        } else {
-            queryResultSet = rdbStore->QuerySql("SELECT * FROM " + SMARTABLUMASSETS_VIEW_NAME);
-	}
-    }
-    return RdbUtils::ToResultSetBridge(queryResultSet);
-}
-
-void SplitKeyValue(const string& keyValue, string &key, string &value)
-{
-    string::size_type pos = keyValue.find('=');
-    if (string::npos != pos) {
-        key = keyValue.substr(0, pos);
-        value = keyValue.substr(pos + 1);
-    }
-}
-
-void SplitKeys(const string& query, vector<string>& keys)
-{
-    string::size_type pos1 = 0;
-    string::size_type pos2 = query.find('&');
-    while (string::npos != pos2) {
-        keys.push_back(query.substr(pos1, pos2-pos1));
-        pos1 = pos2 + 1;
-        pos2 = query.find('&', pos1);
-    }
-    if (pos1 != query.length()) {
-        keys.push_back(query.substr(pos1));
-    }
-}
-
-bool ParseThumbnailInfo(string &uriString, vector<int> &space)
-{
-    string::size_type pos = uriString.find_last_of('?');
-    string queryKeys;
-    if (string::npos == pos) {
-        return false;
-    }
-    vector<string> keyWords = {
-        MEDIA_OPERN_KEYWORD,
-        MEDIA_DATA_DB_WIDTH,
-        MEDIA_DATA_DB_HEIGHT
-    };
-    queryKeys = uriString.substr(pos + 1);
-    uriString = uriString.substr(0, pos);
-    vector<string> vectorKeys;
-    SplitKeys(queryKeys, vectorKeys);
-    if (vectorKeys.size() != keyWords.size()) {
-        MEDIA_ERR_LOG("Parse error keys count %{private}d", (int)vectorKeys.size());
-        return false;
-    }
-    string action;
-    int width = 0;
-    int height = 0;
-    for (uint32_t i = 0; i < vectorKeys.size(); i++) {
-        string subKey, subVal;
-        SplitKeyValue(vectorKeys[i], subKey, subVal);
-        if (subKey.empty()) {
-            MEDIA_ERR_LOG("Parse key error [ %{private}s ]", vectorKeys[i].c_str());
-            return false;
         }
-        if (subKey == MEDIA_OPERN_KEYWORD) {
-            action = subVal;
-        } else if (subKey == MEDIA_DATA_DB_WIDTH) {
-            if (MediaLibraryDataManagerUtils::IsNumber(subVal)) {
-                width = stoi(subVal);
-            }
-        } else if (subKey == MEDIA_DATA_DB_HEIGHT) {
-            if (MediaLibraryDataManagerUtils::IsNumber(subVal)) {
-                height = stoi(subVal);
-            }
-        }
-    }
-    MEDIA_INFO_LOG("ParseThumbnailInfo| action [%{private}s] width %{private}d height %{private}d",
-        action.c_str(), width, height);
-    if (action != MEDIA_DATA_DB_THUMBNAIL || width <= 0 || height <= 0) {
-        MEDIA_ERR_LOG("ParseThumbnailInfo | Error args");
-        return false;
+        queryResultSet = rdbStore->Query(mediaLibAbsPredAlbum, columns);
     }
-    space.push_back(width);
-    space.push_back(height);
-    return true;
+    return RdbUtils::ToResultSetBridge(queryResultSet);
 }
 
 shared_ptr<ResultSetBridge> GenThumbnail(shared_ptr<RdbStore> rdb,
     shared_ptr<MediaLibraryThumbnail> thumbnail,
-    string &rowId, vector<int> space, string &networkId)
+    const string &rowId, int32_t width, int32_t height, const string &networkId)
 {
     shared_ptr<ResultSetBridge> queryResultSet;
-    int width = space[0];
-    int height = space[1];
     string filesTableName = MEDIALIBRARY_TABLE;
 
     if (!networkId.empty()) {
@@ -651,45 +728,24 @@ shared_ptr<ResultSetBridge> GenThumbnail(shared_ptr<RdbStore> rdb,
     return queryResultSet;
 }
 
-static void DealWithUriString(string &uriString, TableType &tabletype,
-    string &strQueryCondition, string::size_type &pos, string &strRow)
+// A row uri datashare:///media/<table>/<row> queried without a condition selects that row
+static void DealWithRowUri(const MediaLibraryUri &route, TableType &tabletype, string &strQueryCondition,
+    string &strRow)
 {
-    string type = uriString.substr(pos + 1);
-    MEDIA_INFO_LOG("MediaLibraryDataManager uriString type = %{private}s", type.c_str());
-    if (type == MEDIA_ALBUMOPRN_QUERYALBUM) {
-        tabletype = TYPE_ALBUM_TABLE;
-        uriString = MEDIALIBRARY_DATA_URI;
-    } else if (uriString == MEDIALIBRARY_DATA_URI + "/"
-               + MEDIA_ALBUMOPRN_QUERYALBUM + "/" + SMARTABLUMASSETS_VIEW_NAME) {
-        tabletype = TYPE_SMARTALBUMASSETS_TABLE;
-        uriString = MEDIALIBRARY_SMARTALBUM_URI;
-    } else if (uriString == MEDIALIBRARY_DATA_URI + "/"
-               + MEDIA_ALBUMOPRN_QUERYALBUM + "/" + ASSETMAP_VIEW_NAME) {
-        tabletype = TYPE_ASSETSMAP_TABLE;
-        uriString = MEDIALIBRARY_SMARTALBUM_URI;
-    } else if (uriString == MEDIALIBRARY_DATA_URI + "/" + MEDIA_DEVICE_QUERYALLDEVICE) {
-        tabletype = TYPE_ALL_DEVICE;
-        uriString = MEDIALIBRARY_DATA_URI;
-    } else if (uriString == MEDIALIBRARY_DATA_URI + "/" + MEDIA_DEVICE_QUERYACTIVEDEVICE) {
-        tabletype = TYPE_ACTIVE_DEVICE;
-        uriString = MEDIALIBRARY_DATA_URI;
-    } else if (strQueryCondition.empty() && pos != string::npos) {
-        strRow = type;
-        uriString = uriString.substr(0, pos);
-        string::size_type posTable = uriString.find_last_of('/');
-        string tableName = uriString.substr(posTable + 1);
-        MEDIA_INFO_LOG("MediaLibraryDataManager tableName = %{private}s", tableName.c_str());
-        MEDIA_INFO_LOG("MediaLibraryDataManager strRow = %{private}s", strRow.c_str());
-        if (SMARTALBUM_TABLE.compare(tableName) == 0) {
-            tabletype = TYPE_SMARTALBUM;
-            strQueryCondition = SMARTALBUM_DB_ID + " = " + strRow;
-        } else if (SMARTALBUM_MAP_TABLE.compare(tableName) == 0) {
-            tabletype = TYPE_SMARTALBUM_MAP;
-            strQueryCondition = SMARTALBUMMAP_DB_ALBUM_ID + " = " + strRow;
-        } else {
-            tabletype = TYPE_DATA;
-            strQueryCondition = MEDIA_DATA_DB_ID + " = " + strRow;
-        }
+    if ((tabletype != TYPE_DATA) || !strQueryCondition.empty() || route.parent.empty()) {
+        return;
+    }
+    strRow = route.operation;
+    MEDIA_INFO_LOG("MediaLibraryDataManager tableName = %{private}s", route.table.c_str());
+    MEDIA_INFO_LOG("MediaLibraryDataManager strRow = %{private}s", strRow.c_str());
+    if (route.table == SMARTALBUM_TABLE) {
+        tabletype = TYPE_SMARTALBUM;
+        strQueryCondition = SMARTALBUM_DB_ID + " = " + strRow;
+    } else if (route.table == SMARTALBUM_MAP_TABLE) {
+        tabletype = TYPE_SMARTALBUM_MAP;
+        strQueryCondition = SMARTALBUMMAP_DB_ALBUM_ID + " = " + strRow;
+    } else {
+        strQueryCondition = MEDIA_DATA_DB_ID + " = " + strRow;
     }
 }
 
@@ -711,34 +767,29 @@ shared_ptr<ResultSetBridge> MediaLibraryDataManager::Query(const Uri &uri,
     FinishTrace(BYTRACE_TAG_OHOS);
 
     shared_ptr<ResultSetBridge> queryResultSet;
-    TableType tabletype = TYPE_DATA;
-    string strRow, uriString = uri.ToString(), strQueryCondition = predicates.GetWhereClause();
-
-    vector<int> space;
-    bool thumbnailQuery = ParseThumbnailInfo(uriString, space);
-    string networkId = MediaLibraryDataManagerUtils::GetNetworkIdFromUri(uriString);
-    string::size_type pos = uriString.find_last_of('/');
-    string type = uriString.substr(pos + 1);
+    MediaLibraryUri route = MediaLibraryUriRouter::Parse(uri.ToString());
+    TableType tabletype = route.tableType;
+    const string &networkId = route.networkId;
+    string strRow, strQueryCondition = predicates.GetWhereClause();
     MEDIA_DEBUG_LOG("uriString = %{private}s, type = %{private}s, thumbnailQuery %{private}d, Rdb Verison %{private}d",
-        uriString.c_str(), type.c_str(), thumbnailQuery, MEDIA_RDB_VERSION);
-    if (uriString.find(MEDIA_QUERYOPRN_QUERYVOLUME) != string::npos) {
+        route.uri.c_str(), route.operation.c_str(), route.isThumbnail, MEDIA_RDB_VERSION);
+    if (route.operation == MEDIA_QUERYOPRN_QUERYVOLUME) {
         QueryData queryData;
         auto absResult = MediaLibraryQueryOperations::HandleQueryOperations(MEDIA_QUERYOPRN_QUERYVOLUME, queryData,
             rdbStore_);
         queryResultSet = RdbUtils::ToResultSetBridge(absResult);
         return queryResultSet;
     }
-    DealWithUriString(uriString, tabletype, strQueryCondition, pos, strRow);
+    DealWithRowUri(route, tabletype, strQueryCondition, strRow);
     if (!networkId.empty() && (tabletype != TYPE_ASSETSMAP_TABLE) && (tabletype != TYPE_SMARTALBUMASSETS_TABLE)) {
-        StartTrace(BYTRACE_TAG_OHOS, "QuerySync");
-        auto ret = QuerySync();
-        FinishTrace(BYTRACE_TAG_OHOS);
-        MEDIA_INFO_LOG("MediaLibraryDataManager QuerySync result = %{private}d", ret);
+        // Read from the local copy of the remote table, a stale copy is pulled in the background
+        bool fresh = MediaLibraryPullCache::GetInstance()->Refresh(networkId, GetPullTableName(tabletype));
+        MEDIA_DEBUG_LOG("Remote query on %{private}s, fresh %{private}d", networkId.c_str(), fresh);
     }
 
-    if (thumbnailQuery) {
+    if (route.isThumbnail) {
         StartTrace(BYTRACE_TAG_OHOS, "GenThumbnail");
-        queryResultSet = GenThumbnail(rdbStore_, mediaThumbnail_, strRow, space, networkId);
+        queryResultSet = GenThumbnail(rdbStore_, mediaThumbnail_, strRow, route.width, route.height, networkId);
         FinishTrace(BYTRACE_TAG_OHOS);
     } else if (tabletype == TYPE_SMARTALBUM || tabletype == TYPE_SMARTALBUM_MAP) {
         queryResultSet = QueryBySmartTableType(tabletype, strQueryCondition, predicates, columns, rdbStore_);
@@ -774,57 +825,90 @@ int32_t MediaLibraryDataManager::Update(const Uri &uri, const DataShareValuesBuc
     if (!CheckClientPermission(PERMISSION_NAME_WRITE_MEDIA)) {
         return DATA_ABILITY_PERMISSION_DENIED;
     }
-    MediaLibraryFileOperations fileOprn;
     int32_t changedRows = DATA_ABILITY_FAIL;
-    string uriString = uri.ToString();
-    vector<string> devices = vector<string>();
-    MEDIA_INFO_LOG("Update uriString = %{private}s", uriString.c_str());
+    MediaLibraryUri route = MediaLibraryUriRouter::Parse(uri.ToString());
+    MEDIA_INFO_LOG("Update uriString = %{private}s", route.uri.c_str());
     string strUpdateCondition = predicates.GetWhereClause();
     if (strUpdateCondition.empty()) {
-        string::size_type pos = uriString.find_last_of('/');
-        CHECK_AND_RETURN_RET_LOG((pos != string::npos) && (pos == MEDIALIBRARY_DATA_URI.length()), DATA_ABILITY_FAIL,
-            "Invalid index position");
-
-        string strRow = uriString.substr(pos + 1);
-        CHECK_AND_RETURN_RET_LOG(MediaLibraryDataManagerUtils::IsNumber(strRow), DATA_ABILITY_FAIL, "Index not digit");
+        CHECK_AND_RETURN_RET_LOG(route.parent == MEDIALIBRARY_DATA_URI, DATA_ABILITY_FAIL, "Invalid index position");
+        CHECK_AND_RETURN_RET_LOG(MediaLibraryDataManagerUtils::IsNumber(route.operation), DATA_ABILITY_FAIL,
+            "Index not digit");
 
-        uriString = uriString.substr(0, pos);
-        strUpdateCondition = MEDIA_DATA_DB_ID + " = " + strRow;
+        strUpdateCondition = MEDIA_DATA_DB_ID + " = " + route.operation;
     }
-    // After removing the index values, check whether URI is correct
 
     vector<string> whereArgs = predicates.GetWhereArgs();
-    if (uriString.find(MEDIA_SMARTALBUMOPRN) != string::npos) {
+    lock_guard<recursive_mutex> lock(writerLock_);
+    if (route.group == UriOprnGroup::SMARTALBUM) {
         (void)rdbStore_->Update(changedRows, SMARTALBUM_TABLE, value, strUpdateCondition, whereArgs);
-    } else if (uriString.find(MEDIA_SMARTALBUMMAPOPRN) != string::npos) {
+    } else if (route.group == UriOprnGroup::SMARTALBUMMAP) {
         (void)rdbStore_->Update(changedRows, SMARTALBUM_MAP_TABLE, value, strUpdateCondition, whereArgs);
     } else {
-        if (uriString == MEDIALIBRARY_DATA_URI + "/" + Media::MEDIA_FILEOPRN
-                + "/" + Media::MEDIA_FILEOPRN_MODIFYASSET) {
-        int result = fileOprn.HandleFileOperation(MEDIA_FILEOPRN_MODIFYASSET, value, rdbStore_, mediaThumbnail_);
-        if (result < 0) {
-            return result;
+        if ((route.group == UriOprnGroup::FILE) && (route.operation == MEDIA_FILEOPRN_MODIFYASSET)) {
+            MediaLibraryFileOperations fileOprn;
+            int result = fileOprn.HandleFileOperation(MEDIA_FILEOPRN_MODIFYASSET, value, rdbStore_, mediaThumbnail_);
+            if (result < 0) {
+                return result;
             }
         }
-    (void)rdbStore_->Update(changedRows, MEDIALIBRARY_TABLE, value, strUpdateCondition, whereArgs);
+        (void)rdbStore_->Update(changedRows, MEDIALIBRARY_TABLE, value, strUpdateCondition, whereArgs);
+        if ((changedRows > 0) && ChangesAlbumCache(value)) {
+            MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore_);
+        }
     }
     if (changedRows >= 0) {
-        MediaLibrarySyncTable syncTable;
-        syncTable.SyncPushTable(rdbStore_, bundleName_, MEDIALIBRARY_TABLE, devices);
+        MediaLibrarySyncScheduler::GetInstance()->MarkDirty(MEDIALIBRARY_TABLE);
     }
     return changedRows;
 }
 
+/**
+ * @brief Insert a batch of Files rows, or add or remove the map rows of many assets of one smart album
+ *
+ * @param uri MEDIALIBRARY_DATA_URI for Files rows, a smart album map add or remove operation uri otherwise
+ * @param values Rows to write
+ * @return int32_t Number of rows written. A smart album map batch is all or nothing: when one of its rows
+ *         fails the whole batch is rolled back and DATA_ABILITY_FAIL is returned.
+ */
 int32_t MediaLibraryDataManager::BatchInsert(const Uri &uri, const vector<DataShareValuesBucket> &values)
 {
     string uriString = uri.ToString();
-    if ((!isRdbStoreInitialized) || (rdbStore_ == nullptr) || (uriString != MEDIALIBRARY_DATA_URI)) {
+    MediaLibraryUri route = MediaLibraryUriRouter::Parse(uriString);
+    bool isSmartAlbumMap = route.IsOprnUri() && (route.group == UriOprnGroup::SMARTALBUMMAP) &&
+        ((route.operation == MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM) ||
+        (route.operation == MEDIA_SMARTALBUMMAPOPRN_REMOVESMARTALBUM));
+    if ((!isRdbStoreInitialized) || (rdbStore_ == nullptr) ||
+        ((uriString != MEDIALIBRARY_DATA_URI) && !isSmartAlbumMap)) {
         MEDIA_ERR_LOG("MediaLibraryDataManager BatchInsert: Input parameter is invalid");
         return DATA_ABILITY_FAIL;
     }
+    if (!CheckClientPermission(PERMISSION_NAME_WRITE_MEDIA)) {
+        return DATA_ABILITY_PERMISSION_DENIED;
+    }
+
+    if (isSmartAlbumMap) {
+        vector<ValuesBucket> mapValues;
+        for (const auto &dataShareValue : values) {
+            mapValues.push_back(RdbUtils::ToValuesBucket(dataShareValue));
+        }
+        MediaLibrarySmartAlbumMapOperations smartalbumMapOprn;
+        int32_t changedRows = smartalbumMapOprn.HandleBatchSmartAlbumMapOperations(route.operation, mapValues,
+            rdbStore_);
+        if (changedRows > 0) {
+            MediaLibrarySyncScheduler::GetInstance()->MarkDirty(CATEGORY_SMARTALBUM_MAP_TABLE);
+        }
+        return changedRows;
+    }
+
+    vector<int64_t> rowIds;
+    int32_t ret = ExecuteBatchInTransaction(values, false, rowIds);
+    if (ret < 0) {
+        return ret;
+    }
+
     int32_t rowCount = 0;
-    for (auto it = values.begin(); it != values.end(); it++) {
-        if (Insert(uri, *it) >= 0) {
+    for (auto rowId : rowIds) {
+        if (rowId >= 0) {
             rowCount++;
         }
     }
@@ -832,6 +916,126 @@ int32_t MediaLibraryDataManager::BatchInsert(const Uri &uri, const vector<DataSh
     return rowCount;
 }
 
+/**
+ * @brief Insert or update a batch of Files rows in a single transaction
+ *
+ * @param values Rows to write, a row carrying a positive MEDIA_DATA_DB_ID updates that row, others are inserted.
+ *        A row whose id no longer exists is inserted as a new row.
+ * @param rowIds Output, the row id of every input row in order
+ * @return int32_t Number of rows written, or a negative error code when the transaction was rolled back
+ */
+int32_t MediaLibraryDataManager::BatchUpsert(const vector<DataShareValuesBucket> &values, vector<int64_t> &rowIds)
+{
+    if ((!isRdbStoreInitialized) || (rdbStore_ == nullptr)) {
+        MEDIA_ERR_LOG("MediaLibraryDataManager BatchUpsert: Rdb Store is not initialized");
+        return DATA_ABILITY_FAIL;
+    }
+    if (!CheckClientPermission(PERMISSION_NAME_WRITE_MEDIA)) {
+        return DATA_ABILITY_PERMISSION_DENIED;
+    }
+
+    return ExecuteBatchInTransaction(values, true, rowIds);
+}
+
+/**
+ * @brief Run writes on rdbStore inside one transaction, serialized with every other write on the store
+ *
+ * @param rdbStore Store to write
+ * @param writes Writes to run, a negative return rolls the transaction back
+ * @return int32_t The return of writes, or DATA_ABILITY_FAIL when the transaction could not begin or commit
+ */
+int32_t MediaLibraryDataManager::ExecuteInTransaction(const shared_ptr<RdbStore> &rdbStore,
+    const function<int32_t()> &writes)
+{
+    if (rdbStore == nullptr) {
+        MEDIA_ERR_LOG("ExecuteInTransaction: Rdb Store is null");
+        return DATA_ABILITY_FAIL;
+    }
+
+    lock_guard<recursive_mutex> lock(writerLock_);
+    int32_t errCode = rdbStore->BeginTransaction();
+    if (errCode != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("BeginTransaction failed, errCode = %{public}d", errCode);
+        return DATA_ABILITY_FAIL;
+    }
+
+    int32_t ret = writes();
+    if (ret < 0) {
+        rdbStore->RollBack();
+        // The writes may have reached the album cache before the rollback, let it reload
+        MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore);
+        return ret;
+    }
+
+    errCode = rdbStore->Commit();
+    if (errCode != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("Commit failed, errCode = %{public}d", errCode);
+        rdbStore->RollBack();
+        MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore);
+        return DATA_ABILITY_FAIL;
+    }
+    return ret;
+}
+
+int32_t MediaLibraryDataManager::ExecuteBatchInTransaction(const vector<DataShareValuesBucket> &values,
+    bool isUpsert, vector<int64_t> &rowIds)
+{
+    rowIds.clear();
+    if (values.empty()) {
+        return DATA_ABILITY_SUCCESS;
+    }
+
+    StartTrace(BYTRACE_TAG_OHOS, "ExecuteBatchInTransaction");
+    bool hasAlbumRows = false;
+    int32_t errCode = ExecuteInTransaction(rdbStore_, [this, &values, isUpsert, &rowIds, &hasAlbumRows]() {
+        // Rows of one batch share the same column set, so the store keeps reusing the prepared
+        // INSERT/UPDATE statement instead of compiling it again for every row
+        const string updateCondition = MEDIA_DATA_DB_ID + " = ?";
+        for (const auto &dataShareValue : values) {
+            ValuesBucket value = RdbUtils::ToValuesBucket(dataShareValue);
+            hasAlbumRows = hasAlbumRows || IsAlbumValues(value);
+            int64_t rowId = DATA_ABILITY_FAIL;
+            int32_t id = 0;
+            int32_t ret = NativeRdb::E_OK;
+            int32_t changedRows = 0;
+            ValueObject valueObject;
+            if (isUpsert && value.GetObject(MEDIA_DATA_DB_ID, valueObject) &&
+                (valueObject.GetInt(id) == NativeRdb::E_OK) && (id > 0)) {
+                value.Delete(MEDIA_DATA_DB_ID);
+                vector<string> whereArgs = { to_string(id) };
+                ret = rdbStore_->Update(changedRows, MEDIALIBRARY_TABLE, value, updateCondition, whereArgs);
+                if (changedRows > 0) {
+                    rowId = id;
+                }
+            }
+            // The row to update may have been deleted since it was read, write it again as a new row
+            if ((ret == NativeRdb::E_OK) && (changedRows == 0)) {
+                ret = rdbStore_->Insert(rowId, MEDIALIBRARY_TABLE, value);
+            }
+
+            if ((ret != NativeRdb::E_OK) || (rowId <= 0)) {
+                MEDIA_ERR_LOG("Batch write failed at row %{public}d, errCode = %{public}d",
+                    static_cast<int32_t>(rowIds.size()), ret);
+                return DATA_ABILITY_FAIL;
+            }
+            rowIds.push_back(rowId);
+        }
+        return static_cast<int32_t>(rowIds.size());
+    });
+    FinishTrace(BYTRACE_TAG_OHOS);
+    if (errCode < 0) {
+        rowIds.clear();
+        return DATA_ABILITY_FAIL;
+    }
+    if (hasAlbumRows) {
+        MediaLibraryAlbumCache::GetInstance()->Invalidate(rdbStore_);
+    }
+
+    MediaLibrarySyncScheduler::GetInstance()->MarkDirty(MEDIALIBRARY_TABLE);
+
+    return errCode;
+}
+
 void MediaLibraryDataManager::ScanFile(const ValuesBucket &values, const shared_ptr<RdbStore> &rdbStore1)
 {
     string actualUri;
@@ -1010,40 +1214,6 @@ bool MediaLibraryDataManager::QuerySync(const std::string &deviceId, const std::
     return syncTable.SyncPullTable(rdbStore_, bundleName_, tableName, devices);
 }
 
-bool MediaLibraryDataManager::QuerySync()
-{
-    std::string strQueryCondition = DEVICE_DB_SYNC_STATUS + "=" + std::to_string(DEVICE_SYNCSTATUSING) +
-        " AND " + DEVICE_DB_DATE_MODIFIED + "=0";
-
-    std::vector<std::string> columns;
-    std::vector<std::string> devices;
-    AbsRdbPredicates deviceDataSharePredicates(DEVICE_TABLE);
-    deviceDataSharePredicates.SetWhereClause(strQueryCondition);
-
-    auto queryResultSet = rdbStore_->Query(deviceDataSharePredicates, columns);
-    if ( queryResultSet == nullptr) {
-        return false;
-    }
-
-    if (queryResultSet->GoToNextRow() == NativeRdb::E_OK) {
-        int32_t columnIndexId;
-        std::string deviceId;
-        queryResultSet->GetColumnIndex(DEVICE_DB_DEVICEID, columnIndexId);
-        queryResultSet->GetString(columnIndexId, deviceId);
-
-        if (!deviceId.empty()) {
-            devices.push_back(deviceId);
-        }
-    }
-
-    if (devices.empty()) {
-        return true;
-    }
-
-    MediaLibrarySyncTable syncTable;
-    return syncTable.SyncPullAllTableByDeviceId(rdbStore_, bundleName_, devices);
-}
-
 bool MediaLibraryDataManager::CheckFileNameValid(const DataShareValuesBucket &value)
 {
     DataShareValueObject valueObject;
@@ -1184,6 +1354,7 @@ void MediaLibraryDeviceStateCallback::OnDeviceOnline(const OHOS::DistributedHard
 void MediaLibraryDeviceStateCallback::OnDeviceOffline(const OHOS::DistributedHardware::DmDeviceInfo &deviceInfo)
 {
     MediaLibraryDevice::GetInstance()->OnDeviceOffline(deviceInfo, bundleName_);
+    MediaLibraryPullCache::GetInstance()->Invalidate(deviceInfo.deviceId);
 }
 
 void MediaLibraryDeviceStateCallback::OnDeviceChanged(const OHOS::DistributedHardware::DmDeviceInfo &deviceInfo)
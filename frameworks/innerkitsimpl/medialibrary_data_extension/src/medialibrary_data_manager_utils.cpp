@@ -16,6 +16,8 @@
 #include "medialibrary_data_manager_utils.h"
 #include <regex>
 #include "media_log.h"
+#include "medialibrary_album_cache.h"
+#include "medialibrary_statement_cache.h"
 
 using namespace std;
 using namespace OHOS::NativeRdb;
@@ -49,6 +51,12 @@ int32_t MediaLibraryDataManagerUtils::GetParentIdFromDb(const string &path, cons
     int32_t parentId = 0;
     int32_t columnIndex(0);
 
+    AlbumCacheEntry album;
+    AlbumCacheResult cacheResult = MediaLibraryAlbumCache::GetInstance()->GetAlbum(path, album, rdbStore);
+    if (cacheResult != AlbumCacheResult::UNAVAILABLE) {
+        return (cacheResult == AlbumCacheResult::FOUND) ? album.id : parentId;
+    }
+
     if (rdbStore != nullptr && !path.empty()) {
         AbsRdbPredicates absPredicates(MEDIALIBRARY_TABLE);
         absPredicates.EqualTo(MEDIA_DATA_DB_FILE_PATH, path);
@@ -75,6 +83,11 @@ string MediaLibraryDataManagerUtils::GetParentDisplayNameFromDb(const int &id, c
 {
     string parentName;
     int32_t columnIndex(0);
+    AlbumCacheEntry album;
+    AlbumCacheResult cacheResult = MediaLibraryAlbumCache::GetInstance()->GetAlbum(id, album, rdbStore);
+    if (cacheResult != AlbumCacheResult::UNAVAILABLE) {
+        return album.name;
+    }
     if (rdbStore != nullptr) {
         AbsRdbPredicates absPredicates(MEDIALIBRARY_TABLE);
         absPredicates.EqualTo(MEDIA_DATA_DB_ID, std::to_string(id));
@@ -139,11 +152,16 @@ NativeAlbumAsset MediaLibraryDataManagerUtils::GetAlbumAsset(const std::string &
                                                              const std::shared_ptr<NativeRdb::RdbStore> &rdbStore)
 {
     NativeAlbumAsset albumAsset;
-    vector<string> columns;
-    AbsRdbPredicates absPredicates(MEDIALIBRARY_TABLE);
-    absPredicates.EqualTo(MEDIA_DATA_DB_ID, id);
-    unique_ptr<NativeRdb::ResultSet> queryResultSet = rdbStore->Query(absPredicates, columns);
-    if (queryResultSet->GoToNextRow() == NativeRdb::E_OK) {
+    AlbumCacheEntry album;
+    AlbumCacheResult cacheResult = MediaLibraryAlbumCache::GetInstance()->GetAlbum(
+        IsNumber(id) ? stoi(id) : 0, album, rdbStore);
+    if (cacheResult == AlbumCacheResult::FOUND) {
+        albumAsset.SetAlbumId(album.id);
+        albumAsset.SetAlbumName(album.title);
+        return albumAsset;
+    }
+    auto queryResultSet = MediaLibraryStatementCache::GetInstance()->Query(rdbStore, StatementId::ALBUM_BY_ID, id);
+    if ((queryResultSet != nullptr) && (queryResultSet->GoToNextRow() == NativeRdb::E_OK)) {
         int32_t columnIndexId;
         int32_t idVal;
         int32_t columnIndexName;
@@ -170,30 +188,64 @@ std::string MediaLibraryDataManagerUtils::GetFileTitle(const std::string& displa
     }
     return title;
 }
+// Only the ancestors of relativePath can be its parent album, so look up those paths alone
+// through the data index instead of matching every row of the table against the path.
 NativeAlbumAsset MediaLibraryDataManagerUtils::GetLastAlbumExistInDb(const std::string &relativePath,
     const std::shared_ptr<NativeRdb::RdbStore> &rdbStore)
 {
     NativeAlbumAsset nativeAlbumAsset;
-    int32_t idVal = 0;
+    nativeAlbumAsset.SetAlbumId(0);
+    nativeAlbumAsset.SetAlbumPath(ROOT_MEDIA_DIR);
+
+    AlbumCacheEntry album;
+    AlbumCacheResult cacheResult = MediaLibraryAlbumCache::GetInstance()->GetLastAncestor(relativePath,
+        ROOT_MEDIA_DIR, album, rdbStore);
+    if (cacheResult != AlbumCacheResult::UNAVAILABLE) {
+        if (cacheResult == AlbumCacheResult::FOUND) {
+            nativeAlbumAsset.SetAlbumId(album.id);
+            nativeAlbumAsset.SetAlbumPath(album.path);
+        }
+        return nativeAlbumAsset;
+    }
+
+    string path = relativePath;
+    while (path.length() > ROOT_MEDIA_DIR.length() && path.back() == '/') {
+        path.pop_back();
+    }
+    vector<string> candidates;
+    for (size_t index = path.find('/', ROOT_MEDIA_DIR.length()); index != string::npos;
+        index = path.find('/', index + 1)) {
+        candidates.push_back(path.substr(0, index));
+    }
+    if (path.length() > ROOT_MEDIA_DIR.length()) {
+        candidates.push_back(path);
+    }
+    if (candidates.empty() || rdbStore == nullptr) {
+        return nativeAlbumAsset;
+    }
+
+    string sql = "SELECT " + MEDIA_DATA_DB_FILE_PATH + "," + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE +
+        " WHERE " + MEDIA_DATA_DB_FILE_PATH + " IN (?";
+    for (size_t i = 1; i < candidates.size(); i++) {
+        sql += ",?";
+    }
+    sql += ")";
+    unique_ptr<NativeRdb::ResultSet> queryResultSet = rdbStore->QuerySql(sql, candidates);
+    CHECK_AND_RETURN_RET_LOG(queryResultSet != nullptr, nativeAlbumAsset, "Failed to query parent albums");
+
+    int32_t columnIndexPath;
     int32_t columnIndexId;
-    int32_t maxColumnIndexPath;
+    queryResultSet->GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, columnIndexPath);
+    queryResultSet->GetColumnIndex(MEDIA_DATA_DB_ID, columnIndexId);
     string maxVal = ROOT_MEDIA_DIR;
-    string::size_type max = maxVal.length();
-    string maxPath = ROOT_MEDIA_DIR;
     int32_t maxId = 0;
-    string::size_type idx;
-    string sql = "SELECT " + MEDIA_DATA_DB_RELATIVE_PATH + ","
-    + MEDIA_DATA_DB_FILE_PATH + "," + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE;
-    unique_ptr<NativeRdb::ResultSet> queryResultSet = rdbStore->QuerySql(sql);
     while (queryResultSet->GoToNextRow() == NativeRdb::E_OK) {
-        queryResultSet->GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, maxColumnIndexPath);
-        queryResultSet->GetString(maxColumnIndexPath, maxPath);
-        queryResultSet->GetColumnIndex(MEDIA_DATA_DB_ID, columnIndexId);
+        string pathVal;
+        int32_t idVal = 0;
+        queryResultSet->GetString(columnIndexPath, pathVal);
         queryResultSet->GetInt(columnIndexId, idVal);
-        idx = relativePath.find(maxPath);
-        if (idx != string::npos && max < maxPath.length()) {
-            max = maxPath.length();
-            maxVal = maxPath;
+        if (pathVal.length() > maxVal.length()) {
+            maxVal = pathVal;
             maxId = idVal;
         }
     }
@@ -205,6 +257,14 @@ bool MediaLibraryDataManagerUtils::isAlbumExistInDb(const std::string &relativeP
     const std::shared_ptr<NativeRdb::RdbStore> &rdbStore,
     int32_t &outRow)
 {
+    AlbumCacheEntry album;
+    AlbumCacheResult cacheResult = MediaLibraryAlbumCache::GetInstance()->GetAlbum(relativePath, album, rdbStore);
+    if (cacheResult != AlbumCacheResult::UNAVAILABLE) {
+        if (cacheResult == AlbumCacheResult::FOUND) {
+            outRow = album.id;
+        }
+        return cacheResult == AlbumCacheResult::FOUND;
+    }
     vector<string> columns;
     AbsRdbPredicates absPredicates(MEDIALIBRARY_TABLE);
     absPredicates.EqualTo(MEDIA_DATA_DB_FILE_PATH, relativePath);
@@ -246,18 +306,11 @@ string MediaLibraryDataManagerUtils::GetOperationType(const string &uri)
 bool MediaLibraryDataManagerUtils::isFileExistInDb(const string &path, const shared_ptr<RdbStore> &rdbStore)
 {
     int32_t count = 0;
-    vector<string> selectionArgs = {};
     if ((path.empty()) || (rdbStore == nullptr)) {
         MEDIA_ERR_LOG("path is incorrect or rdbStore is null");
         return false;
     }
-    string strQueryCondition = MEDIA_DATA_DB_FILE_PATH + " = '" + path + "'";
-    AbsRdbPredicates absPredicates(MEDIALIBRARY_TABLE);
-    absPredicates.SetWhereClause(strQueryCondition);
-    absPredicates.SetWhereArgs(selectionArgs);
-    vector<string> columns;
-    columns.push_back(MEDIA_DATA_DB_FILE_PATH);
-    unique_ptr<NativeRdb::ResultSet> queryResultSet = rdbStore->Query(absPredicates, columns);
+    auto queryResultSet = MediaLibraryStatementCache::GetInstance()->Query(rdbStore, StatementId::ID_BY_PATH, path);
     if (queryResultSet != nullptr) {
         queryResultSet->GetRowCount(count);
         MEDIA_INFO_LOG("count is %{private}d", count);
@@ -272,7 +325,6 @@ bool MediaLibraryDataManagerUtils::isFileExistInDb(const string &path, const sha
 string MediaLibraryDataManagerUtils::GetPathFromDb(const string &id, const shared_ptr<RdbStore> &rdbStore)
 {
     string filePath("");
-    vector<string> selectionArgs = {};
     int32_t columnIndex(0);
 
     if ((id.empty()) || (!IsNumber(id)) || (stoi(id) == -1) || (rdbStore == nullptr)) {
@@ -280,16 +332,7 @@ string MediaLibraryDataManagerUtils::GetPathFromDb(const string &id, const share
         return filePath;
     }
 
-    string strQueryCondition = MEDIA_DATA_DB_ID + " = " + id;
-
-    AbsRdbPredicates absPredicates(MEDIALIBRARY_TABLE);
-    absPredicates.SetWhereClause(strQueryCondition);
-    absPredicates.SetWhereArgs(selectionArgs);
-
-    vector<string> columns;
-    columns.push_back(MEDIA_DATA_DB_FILE_PATH);
-
-    unique_ptr<NativeRdb::ResultSet> queryResultSet = rdbStore->Query(absPredicates, columns);
+    auto queryResultSet = MediaLibraryStatementCache::GetInstance()->Query(rdbStore, StatementId::PATH_BY_ID, id);
     CHECK_AND_RETURN_RET_LOG(queryResultSet != nullptr, filePath, "Failed to obtain path from database");
 
     auto ret = queryResultSet->GoToFirstRow();
@@ -531,11 +574,13 @@ string MediaLibraryDataManagerUtils::GetDistributedAlbumSql(const string &strQue
     if (!strQueryCondition.empty()) {
         distributedAlbumSql = "SELECT * FROM ( " + DISTRIBUTED_ABLUM_COLUMNS + " FROM " +
         tableName + " " + FILE_TABLE + ", " + tableName + " " + ABLUM_TABLE +
+        ABLUM_COVER_JOIN + tableName + ABLUM_COVER_JOIN_ON +
         DISTRIBUTED_ABLUM_WHERE_AND_GROUPBY + " )" +
         " WHERE " + strQueryCondition;
     } else {
         distributedAlbumSql = "SELECT * FROM ( " + DISTRIBUTED_ABLUM_COLUMNS + " FROM " +
         tableName + " " + FILE_TABLE + ", " + tableName + " " + ABLUM_TABLE +
+        ABLUM_COVER_JOIN + tableName + ABLUM_COVER_JOIN_ON +
         DISTRIBUTED_ABLUM_WHERE_AND_GROUPBY + " )";
     }
     MEDIA_INFO_LOG("GetDistributedAlbumSql distributedAlbumSql = %{private}s", distributedAlbumSql.c_str());
@@ -15,6 +15,8 @@
 
 #include "medialibrary_file_db.h"
 #include "media_log.h"
+#include "medialibrary_album_cache.h"
+#include "medialibrary_data_manager_utils.h"
 
 using namespace std;
 using namespace OHOS::NativeRdb;
@@ -45,6 +47,8 @@ int32_t MediaLibraryFileDb::Delete(const string &strRow, const shared_ptr<RdbSto
             int32_t result = rdbStore->Delete(deletedRows, MEDIALIBRARY_TABLE, strDeleteCondition, whereArgs);
             if (result != NativeRdb::E_OK) {
                 MEDIA_ERR_LOG("Delete operation failed. Result %{private}d. Deleted %{private}d", result, deletedRows);
+            } else if (MediaLibraryDataManagerUtils::IsNumber(strRow)) {
+                MediaLibraryAlbumCache::GetInstance()->Erase(stoi(strRow), rdbStore);
             }
         }
     }
@@ -16,6 +16,7 @@
 #include "medialibrary_file_operations.h"
 #include "media_log.h"
 #include "media_file_utils.h"
+#include "medialibrary_album_cache.h"
 #include "medialibrary_smartalbum_map_db.h"
 #include "datashare_predicates.h"
 #include "datashare_result_set.h"
@@ -32,14 +33,16 @@ void UpdateDateModifiedForAlbum(const shared_ptr<RdbStore> &rdbStore, const stri
     if (!albumPath.empty()) {
         int32_t count(0);
         vector<string> whereArgs = { albumPath };
+        int64_t dateModified = MediaLibraryDataManagerUtils::GetAlbumDateModified(albumPath);
         DataShareValuesBucket valuesBucket;
-        valuesBucket.PutLong(MEDIA_DATA_DB_DATE_MODIFIED,
-            MediaLibraryDataManagerUtils::GetAlbumDateModified(albumPath));
+        valuesBucket.PutLong(MEDIA_DATA_DB_DATE_MODIFIED, dateModified);
 
         int32_t updateResult = rdbStore->Update(count, MEDIALIBRARY_TABLE, RdbUtils::ToValuesBucket(valuesBucket),
                                                 MEDIA_DATA_DB_FILE_PATH + " = ?", whereArgs);
         if (updateResult != NativeRdb::E_OK) {
             MEDIA_ERR_LOG("Update failed for album");
+        } else {
+            MediaLibraryAlbumCache::GetInstance()->UpdateDateModified(albumPath, dateModified, rdbStore);
         }
     }
 }
@@ -169,12 +172,14 @@ int ModifyDisName(const string &dstFileName,
         if (deleteResult != NativeRdb::E_OK) {
             MEDIA_ERR_LOG("Delete rows for the hidden album failed");
         }
+        MediaLibraryAlbumCache::GetInstance()->Erase(destAlbumPath, rdbStore);
         whereArgs.clear();
         whereArgs.push_back(srcPath);
         deleteResult = rdbStore->Delete(deletedRows, MEDIALIBRARY_TABLE, MEDIA_DATA_DB_FILE_PATH + " = ?", whereArgs);
         if (deleteResult != NativeRdb::E_OK) {
             MEDIA_ERR_LOG("Delete rows for the old path failed");
         }
+        MediaLibraryAlbumCache::GetInstance()->Erase(srcPath, rdbStore);
         errCode = DATA_ABILITY_FAIL;
     }
 
@@ -187,6 +192,7 @@ int ModifyDisName(const string &dstFileName,
         if (deleteResult != NativeRdb::E_OK) {
             MEDIA_ERR_LOG("Delete rows failed");
         }
+        MediaLibraryAlbumCache::GetInstance()->Erase(srcPath, rdbStore);
         errCode = DATA_ABILITY_FAIL;
     }
     return errCode;
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_pull_cache.h"
+
+#include "bytrace.h"
+#include "media_log.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+MediaLibraryPullCache *MediaLibraryPullCache::GetInstance()
+{
+    static MediaLibraryPullCache pullCache;
+    return &pullCache;
+}
+
+MediaLibraryPullCache::~MediaLibraryPullCache()
+{
+    Stop();
+}
+
+void MediaLibraryPullCache::Start(PullFunc pullFunc, chrono::milliseconds maxAge, size_t deviceConcurrency,
+    size_t workers)
+{
+    if ((pullFunc == nullptr) || (deviceConcurrency == 0) || (workers == 0)) {
+        MEDIA_ERR_LOG("Invalid pull cache parameters");
+        return;
+    }
+
+    Stop();
+    lock_guard<mutex> lock(lock_);
+    pullFunc_ = move(pullFunc);
+    maxAge_ = maxAge;
+    deviceConcurrency_ = deviceConcurrency;
+    running_ = true;
+    for (size_t i = 0; i < workers; i++) {
+        workers_.emplace_back([this] { Run(); });
+    }
+}
+
+void MediaLibraryPullCache::Stop()
+{
+    {
+        lock_guard<mutex> lock(lock_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+        queue_.clear();
+    }
+    pullCv_.notify_all();
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    lock_guard<mutex> lock(lock_);
+    workers_.clear();
+    entries_.clear();
+    devicePulls_.clear();
+    pullFunc_ = nullptr;
+}
+
+bool MediaLibraryPullCache::Refresh(const string &deviceId, const string &tableName)
+{
+    lock_guard<mutex> lock(lock_);
+    if (!running_ || deviceId.empty() || tableName.empty()) {
+        return false;
+    }
+
+    PullEntry &entry = entries_[PullKey(deviceId, tableName)];
+    if (entry.synced && (chrono::steady_clock::now() - entry.lastSync < maxAge_)) {
+        fresh_++;
+        return true;
+    }
+
+    stale_++;
+    if (entry.pending) {
+        coalesced_++;
+        return false;
+    }
+    entry.pending = true;
+    queue_.emplace_back(deviceId, tableName);
+    pullCv_.notify_one();
+    return false;
+}
+
+void MediaLibraryPullCache::Invalidate(const string &deviceId)
+{
+    lock_guard<mutex> lock(lock_);
+    for (auto iter = queue_.begin(); iter != queue_.end();) {
+        iter = (iter->first == deviceId) ? queue_.erase(iter) : next(iter);
+    }
+    for (auto iter = entries_.begin(); iter != entries_.end();) {
+        iter = (iter->first.first == deviceId) ? entries_.erase(iter) : next(iter);
+    }
+}
+
+// Called with lock_ held, the oldest queued pull of a device below its concurrency bound
+bool MediaLibraryPullCache::TakeNext(PullKey &key)
+{
+    for (auto iter = queue_.begin(); iter != queue_.end(); ++iter) {
+        if (devicePulls_[iter->first] < deviceConcurrency_) {
+            key = move(*iter);
+            queue_.erase(iter);
+            return true;
+        }
+    }
+    return false;
+}
+
+void MediaLibraryPullCache::Run()
+{
+    unique_lock<mutex> lock(lock_);
+    while (true) {
+        PullKey key;
+        pullCv_.wait(lock, [this, &key] { return !running_ || TakeNext(key); });
+        if (!running_) {
+            break;
+        }
+
+        devicePulls_[key.first]++;
+        PullFunc pullFunc = pullFunc_;
+        pulled_++;
+        lock.unlock();
+        StartTrace(BYTRACE_TAG_OHOS, "MediaLibraryPullCache::Pull");
+        bool ret = pullFunc(key.first, key.second);
+        FinishTrace(BYTRACE_TAG_OHOS);
+        lock.lock();
+
+        if (--devicePulls_[key.first] == 0) {
+            devicePulls_.erase(key.first);
+        }
+        if (!ret) {
+            failed_++;
+            MEDIA_ERR_LOG("Pull of %{private}s from %{private}s failed", key.second.c_str(), key.first.c_str());
+        }
+        // Gone when the device was invalidated during the pull
+        auto iter = entries_.find(key);
+        if (iter != entries_.end()) {
+            iter->second.pending = false;
+            if (ret) {
+                iter->second.synced = true;
+                iter->second.lastSync = chrono::steady_clock::now();
+            }
+        }
+        // A pull of this device waiting on the bound may go now
+        pullCv_.notify_all();
+    }
+}
+
+PullCacheCounters MediaLibraryPullCache::GetCounters() const
+{
+    PullCacheCounters counters;
+    counters.fresh = fresh_.load();
+    counters.stale = stale_.load();
+    counters.pulled = pulled_.load();
+    counters.coalesced = coalesced_.load();
+    counters.failed = failed_.load();
+    return counters;
+}
+
+void MediaLibraryPullCache::ResetCounters()
+{
+    fresh_ = 0;
+    stale_ = 0;
+    pulled_ = 0;
+    coalesced_ = 0;
+    failed_ = 0;
+}
+} // namespace Media
+} // namespace OHOS
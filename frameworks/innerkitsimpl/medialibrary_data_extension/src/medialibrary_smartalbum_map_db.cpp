@@ -14,6 +14,9 @@
  */
 
 #include "medialibrary_smartalbum_map_db.h"
+
+#include <algorithm>
+
 #include "media_log.h"
 #include "rdb_utils.h"
 
@@ -22,6 +25,11 @@ using namespace OHOS::NativeRdb;
 
 namespace OHOS {
 namespace Media {
+namespace {
+// SQLITE_MAX_VARIABLE_NUMBER of the SQLite builds the store runs on
+const size_t MAX_SQL_VARIABLES = 999;
+}
+
 int64_t MediaLibrarySmartAlbumMapDb::InsertSmartAlbumMapInfo(const ValuesBucket &values,
                                                              const shared_ptr<RdbStore> &rdbStore)
 {
@@ -43,6 +51,31 @@ int32_t MediaLibrarySmartAlbumMapDb::DeleteSmartAlbumMapInfo(const int32_t album
     CHECK_AND_RETURN_RET_LOG(deleteResult == NativeRdb::E_OK, ALBUM_OPERATION_ERR, "Delete failed");
     return (deletedRows > 0) ? DATA_ABILITY_SUCCESS : DATA_ABILITY_FAIL;
 }
+int32_t MediaLibrarySmartAlbumMapDb::DeleteSmartAlbumMapInfos(const int32_t albumId,
+                                                              const vector<int32_t> &assetIds,
+                                                              const shared_ptr<RdbStore> &rdbStore)
+{
+    CHECK_AND_RETURN_RET_LOG((rdbStore != nullptr) && (albumId > 0) && !assetIds.empty(),
+        ALBUM_OPERATION_ERR, "Invalid input");
+    // One statement per chunk, SQLite binds at most MAX_SQL_VARIABLES and one of them is the album id
+    int32_t totalDeletedRows = 0;
+    for (size_t begin = 0; begin < assetIds.size(); begin += MAX_SQL_VARIABLES - 1) {
+        size_t end = min(assetIds.size(), begin + MAX_SQL_VARIABLES - 1);
+        string placeholders;
+        vector<string> whereArgs = { std::to_string(albumId) };
+        for (size_t i = begin; i < end; i++) {
+            placeholders += placeholders.empty() ? "?" : ",?";
+            whereArgs.push_back(std::to_string(assetIds[i]));
+        }
+        string whereClause = SMARTALBUMMAP_DB_ALBUM_ID + " = ? AND " + SMARTALBUMMAP_DB_ASSET_ID +
+            " IN (" + placeholders + ")";
+        int32_t deletedRows(ALBUM_OPERATION_ERR);
+        int32_t deleteResult = rdbStore->Delete(deletedRows, SMARTALBUM_MAP_TABLE, whereClause, whereArgs);
+        CHECK_AND_RETURN_RET_LOG(deleteResult == NativeRdb::E_OK, ALBUM_OPERATION_ERR, "Delete failed");
+        totalDeletedRows += deletedRows;
+    }
+    return totalDeletedRows;
+}
 int32_t MediaLibrarySmartAlbumMapDb::DeleteAllSmartAlbumMapInfo(const int32_t albumId,
                                                                 const shared_ptr<RdbStore> &rdbStore)
 {
@@ -15,6 +15,7 @@
 
 #include "medialibrary_smartalbum_map_operations.h"
 #include "media_log.h"
+#include "medialibrary_data_manager.h"
 using namespace std;
 using namespace OHOS::NativeRdb;
 
@@ -63,5 +64,52 @@ int32_t MediaLibrarySmartAlbumMapOperations::HandleSmartAlbumMapOperations(const
     }
     return errCode;
 }
+int32_t MediaLibrarySmartAlbumMapOperations::HandleBatchSmartAlbumMapOperations(const string &oprn,
+    const vector<ValuesBucket> &values, const shared_ptr<RdbStore> &rdbStore)
+{
+    CHECK_AND_RETURN_RET_LOG((rdbStore != nullptr) && !values.empty(), DATA_ABILITY_FAIL, "Invalid input");
+    CHECK_AND_RETURN_RET_LOG((oprn == MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM) ||
+        (oprn == MEDIA_SMARTALBUMMAPOPRN_REMOVESMARTALBUM), DATA_ABILITY_FAIL, "Invalid operation");
+
+    // Every row of a batch belongs to the same album
+    int32_t albumId = 0;
+    vector<int32_t> assetIds;
+    for (const auto &value : values) {
+        ValueObject valueObject;
+        int32_t rowAlbumId = 0;
+        int32_t assetId = 0;
+        if (value.GetObject(SMARTALBUMMAP_DB_ALBUM_ID, valueObject)) {
+            valueObject.GetInt(rowAlbumId);
+        }
+        if (value.GetObject(SMARTALBUMMAP_DB_ASSET_ID, valueObject)) {
+            valueObject.GetInt(assetId);
+        }
+        CHECK_AND_RETURN_RET_LOG((rowAlbumId > 0) && (assetId > 0) && ((albumId == 0) || (albumId == rowAlbumId)),
+            DATA_ABILITY_FAIL, "Invalid batch row");
+        albumId = rowAlbumId;
+        assetIds.push_back(assetId);
+    }
+
+    int32_t changedRows = MediaLibraryDataManager::ExecuteInTransaction(rdbStore,
+        [&oprn, &values, albumId, &assetIds, &rdbStore]() {
+            MediaLibrarySmartAlbumMapDb smartAlbumMapDbOprn;
+            if (oprn != MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM) {
+                return smartAlbumMapDbOprn.DeleteSmartAlbumMapInfos(albumId, assetIds, rdbStore);
+            }
+            int32_t insertedRows = 0;
+            for (const auto &value : values) {
+                if (smartAlbumMapDbOprn.InsertSmartAlbumMapInfo(value, rdbStore) < 0) {
+                    return ALBUM_OPERATION_ERR;
+                }
+                insertedRows++;
+            }
+            return insertedRows;
+        });
+    if (changedRows < 0) {
+        MEDIA_ERR_LOG("Batch %{public}s of album %{private}d failed", oprn.c_str(), albumId);
+        return DATA_ABILITY_FAIL;
+    }
+    return changedRows;
+}
 } // namespace Media
 } // namespace OHOS
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_statement_cache.h"
+
+#include <chrono>
+
+#include "bytrace.h"
+#include "media_data_ability_const.h"
+#include "media_log.h"
+#include "rdb_errno.h"
+
+using namespace std;
+using namespace OHOS::NativeRdb;
+
+namespace OHOS {
+namespace Media {
+namespace {
+    string BuildSql(StatementId id, const string &table)
+    {
+        switch (id) {
+            case StatementId::FILE_MODIFIED_INFO:
+                return "SELECT " + MEDIA_DATA_DB_ID + ", " + MEDIA_DATA_DB_SIZE + ", " + MEDIA_DATA_DB_DATE_MODIFIED +
+                    ", " + MEDIA_DATA_DB_NAME + " FROM " + table + " WHERE " + MEDIA_DATA_DB_FILE_PATH + " = ?";
+            case StatementId::ID_BY_PATH:
+                return "SELECT " + MEDIA_DATA_DB_ID + " FROM " + table + " WHERE " + MEDIA_DATA_DB_FILE_PATH + " = ?";
+            case StatementId::PATH_BY_ID:
+                return "SELECT " + MEDIA_DATA_DB_FILE_PATH + " FROM " + table + " WHERE " + MEDIA_DATA_DB_ID + " = ?";
+            case StatementId::ALBUM_BY_ID:
+                return "SELECT " + MEDIA_DATA_DB_ID + ", " + MEDIA_DATA_DB_TITLE + " FROM " + table + " WHERE " +
+                    MEDIA_DATA_DB_ID + " = ?";
+            case StatementId::THUMBNAIL_INFO:
+                return "SELECT " + MEDIA_DATA_DB_ID + ", " + MEDIA_DATA_DB_FILE_PATH + ", " + MEDIA_DATA_DB_THUMBNAIL +
+                    ", " + MEDIA_DATA_DB_LCD + ", " + MEDIA_DATA_DB_MEDIA_TYPE + " FROM " + table + " WHERE " +
+                    MEDIA_DATA_DB_ID + " = ?";
+            default:
+                return "";
+        }
+    }
+} // namespace
+
+MediaLibraryStatementCache *MediaLibraryStatementCache::GetInstance()
+{
+    static MediaLibraryStatementCache statementCache;
+    return &statementCache;
+}
+
+const char *MediaLibraryStatementCache::GetName(StatementId id)
+{
+    switch (id) {
+        case StatementId::FILE_MODIFIED_INFO:
+            return "file_modified_info";
+        case StatementId::ID_BY_PATH:
+            return "id_by_path";
+        case StatementId::PATH_BY_ID:
+            return "path_by_id";
+        case StatementId::ALBUM_BY_ID:
+            return "album_by_id";
+        case StatementId::THUMBNAIL_INFO:
+            return "thumbnail_info";
+        default:
+            return "unknown";
+    }
+}
+
+// Entries are never erased, the returned reference stays valid
+const string &MediaLibraryStatementCache::GetSql(StatementId id, const string &table)
+{
+    lock_guard<mutex> lock(sqlLock_);
+    auto key = make_pair(id, table.empty() ? MEDIALIBRARY_TABLE : table);
+    auto iter = sqls_.find(key);
+    if (iter == sqls_.end()) {
+        iter = sqls_.emplace(key, BuildSql(id, key.second)).first;
+    }
+    return iter->second;
+}
+
+shared_ptr<AbsSharedResultSet> MediaLibraryStatementCache::Query(const shared_ptr<RdbStore> &rdbStore,
+    StatementId id, const string &arg, const string &table)
+{
+    if ((rdbStore == nullptr) || (id >= StatementId::COUNT)) {
+        MEDIA_ERR_LOG("Invalid statement query");
+        return nullptr;
+    }
+
+    StartTrace(BYTRACE_TAG_OHOS, GetName(id));
+    auto start = chrono::steady_clock::now();
+    shared_ptr<AbsSharedResultSet> resultSet = rdbStore->QuerySql(GetSql(id, table), vector<string> { arg });
+    // The statement runs when the result set is first filled, count that in its time
+    int32_t rows = 0;
+    bool failed = (resultSet == nullptr) || (resultSet->GetRowCount(rows) != E_OK);
+    uint64_t time = static_cast<uint64_t>(
+        chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count());
+    FinishTrace(BYTRACE_TAG_OHOS);
+
+    Count(id, time, rows, failed);
+    if (failed) {
+        MEDIA_ERR_LOG("Statement %{public}s failed", GetName(id));
+        return nullptr;
+    }
+    return resultSet;
+}
+
+void MediaLibraryStatementCache::Count(StatementId id, uint64_t time, int32_t rows, bool failed)
+{
+    StatementStats &stats = stats_[static_cast<size_t>(id)];
+    stats.calls++;
+    stats.totalTime += time;
+    if (failed) {
+        stats.failed++;
+    } else {
+        stats.rows += static_cast<uint64_t>(rows);
+    }
+    uint64_t maxTime = stats.maxTime.load();
+    while ((time > maxTime) && !stats.maxTime.compare_exchange_weak(maxTime, time)) {
+    }
+}
+
+StatementCounters MediaLibraryStatementCache::GetCounters(StatementId id) const
+{
+    StatementCounters counters;
+    if (id >= StatementId::COUNT) {
+        return counters;
+    }
+    const StatementStats &stats = stats_[static_cast<size_t>(id)];
+    counters.calls = stats.calls.load();
+    counters.failed = stats.failed.load();
+    counters.rows = stats.rows.load();
+    counters.totalTime = stats.totalTime.load();
+    counters.maxTime = stats.maxTime.load();
+    return counters;
+}
+
+void MediaLibraryStatementCache::ResetCounters()
+{
+    for (auto &stats : stats_) {
+        stats.calls = 0;
+        stats.failed = 0;
+        stats.rows = 0;
+        stats.totalTime = 0;
+        stats.maxTime = 0;
+    }
+}
+} // namespace Media
+} // namespace OHOS
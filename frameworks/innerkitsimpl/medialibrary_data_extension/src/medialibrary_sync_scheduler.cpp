@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_sync_scheduler.h"
+
+#include "bytrace.h"
+#include "media_log.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+MediaLibrarySyncScheduler *MediaLibrarySyncScheduler::GetInstance()
+{
+    static MediaLibrarySyncScheduler syncScheduler;
+    return &syncScheduler;
+}
+
+MediaLibrarySyncScheduler::~MediaLibrarySyncScheduler()
+{
+    Stop();
+}
+
+void MediaLibrarySyncScheduler::Start(PushFunc pushFunc, chrono::milliseconds window)
+{
+    if (pushFunc == nullptr) {
+        MEDIA_ERR_LOG("Sync scheduler needs a push function");
+        return;
+    }
+
+    Stop();
+    lock_guard<mutex> lock(lock_);
+    pushFunc_ = move(pushFunc);
+    window_ = window;
+    running_ = true;
+    worker_ = thread([this] { Run(); });
+}
+
+void MediaLibrarySyncScheduler::Stop()
+{
+    {
+        lock_guard<mutex> lock(lock_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    dirtyCv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    Flush();
+    lock_guard<mutex> lock(lock_);
+    pushFunc_ = nullptr;
+    dirtyTables_.clear();
+}
+
+void MediaLibrarySyncScheduler::MarkDirty(const string &tableName)
+{
+    unique_lock<mutex> lock(lock_);
+    if (pushFunc_ == nullptr) {
+        MEDIA_ERR_LOG("Sync scheduler not started, %{private}s not pushed", tableName.c_str());
+        return;
+    }
+
+    requested_++;
+    if (!dirtyTables_.insert(tableName).second) {
+        coalesced_++;
+        return;
+    }
+    if (dirtyTables_.size() == 1) {
+        // First dirty table of the window
+        deadline_ = chrono::steady_clock::now() + window_;
+        lock.unlock();
+        dirtyCv_.notify_one();
+    }
+}
+
+void MediaLibrarySyncScheduler::Flush()
+{
+    set<string> tables;
+    {
+        lock_guard<mutex> lock(lock_);
+        tables.swap(dirtyTables_);
+    }
+    Push(tables);
+}
+
+void MediaLibrarySyncScheduler::Run()
+{
+    unique_lock<mutex> lock(lock_);
+    while (running_) {
+        if (dirtyTables_.empty()) {
+            dirtyCv_.wait(lock, [this] { return !running_ || !dirtyTables_.empty(); });
+            continue;
+        }
+        if (dirtyCv_.wait_until(lock, deadline_, [this] { return !running_; })) {
+            // Stopping, Stop flushes what is left
+            break;
+        }
+
+        set<string> tables;
+        tables.swap(dirtyTables_);
+        lock.unlock();
+        Push(tables);
+        lock.lock();
+    }
+}
+
+void MediaLibrarySyncScheduler::Push(const set<string> &tables)
+{
+    if (tables.empty()) {
+        return;
+    }
+
+    lock_guard<mutex> pushLock(pushLock_);
+    PushFunc pushFunc;
+    {
+        lock_guard<mutex> lock(lock_);
+        pushFunc = pushFunc_;
+    }
+    if (pushFunc == nullptr) {
+        return;
+    }
+
+    StartTrace(BYTRACE_TAG_OHOS, "MediaLibrarySyncScheduler::Push");
+    for (const auto &table : tables) {
+        pushed_++;
+        if (!pushFunc(table)) {
+            failed_++;
+            MEDIA_ERR_LOG("Push of %{private}s failed", table.c_str());
+        }
+    }
+    FinishTrace(BYTRACE_TAG_OHOS);
+}
+
+SyncPushCounters MediaLibrarySyncScheduler::GetCounters() const
+{
+    SyncPushCounters counters;
+    counters.requested = requested_.load();
+    counters.pushed = pushed_.load();
+    counters.coalesced = coalesced_.load();
+    counters.failed = failed_.load();
+    return counters;
+}
+
+void MediaLibrarySyncScheduler::ResetCounters()
+{
+    requested_ = 0;
+    pushed_ = 0;
+    coalesced_ = 0;
+    failed_ = 0;
+}
+} // namespace Media
+} // namespace OHOS
@@ -15,7 +15,11 @@
 
 #include "medialibrary_thumbnail.h"
 
+#include <cerrno>
+#include <cmath>
 #include <fcntl.h>
+#include <thread>
+#include <unistd.h>
 
 #include "bytrace.h"
 #include "distributed_kv_data_manager.h"
@@ -23,8 +27,9 @@
 #include "media_data_ability_const.h"
 #include "media_lib_service_const.h"
 #include "media_log.h"
-#include "medialibrary_sync_table.h"
-#include "medialibrary_sync_table.h"
+#include "medialibrary_data_manager.h"
+#include "medialibrary_statement_cache.h"
+#include "medialibrary_sync_scheduler.h"
 #include "openssl/sha.h"
 #include "rdb_errno.h"
 #include "rdb_predicates.h"
@@ -45,6 +50,11 @@ const string THUMBNAIL_FORMAT = "image/jpeg";
 static constexpr uint8_t THUMBNAIL_QUALITY = 80;
 //static constexpr uint32_t THUMBNAIL_QUERY_MAX = 1000;
 static constexpr int64_t AV_FRAME_TIME = 0;
+static constexpr uint32_t THUMBNAIL_WORKER_MAX = 4;
+// Compressed thumbnails waiting for the writer, the workers block beyond this
+static constexpr size_t THUMBNAIL_PENDING_MAX = 32;
+static constexpr size_t THUMBNAIL_WRITE_BATCH = 16;
+static constexpr size_t FILE_HASH_BUFFER_SIZE = 64 * 1024;
 
 static constexpr uint8_t NUM_0 = 0;
 static constexpr uint8_t NUM_1 = 1;
@@ -52,7 +62,33 @@ static constexpr uint8_t NUM_2 = 2;
 static constexpr uint8_t NUM_3 = 3;
 static constexpr uint8_t NUM_4 = 4;
 
-void ThumbnailDataCopy(ThumbnailData &data, ThumbnailRdbData &rdbData)
+// Ask the decoder for the smallest size that keeps the aspect ratio and still covers target, a zero
+// target dimension is unconstrained. JPEG then decodes with DCT scaling (1/2, 1/4, 1/8) instead of
+// producing the full resolution bitmap only to scale it down afterwards. Never upscales.
+static void SetDecodeSize(ImageSource &imageSource, const Size &target, DecodeOptions &decodeOpts)
+{
+    ImageInfo imageInfo;
+    if (imageSource.GetImageInfo(0, imageInfo) != Media::SUCCESS ||
+        imageInfo.size.width <= 0 || imageInfo.size.height <= 0) {
+        return;
+    }
+
+    double scale = 0.0;
+    if (target.width > 0) {
+        scale = max(scale, static_cast<double>(target.width) / imageInfo.size.width);
+    }
+    if (target.height > 0) {
+        scale = max(scale, static_cast<double>(target.height) / imageInfo.size.height);
+    }
+    if (scale <= 0.0 || scale >= 1.0) {
+        return;
+    }
+
+    decodeOpts.desiredSize.width = max(1, static_cast<int32_t>(ceil(imageInfo.size.width * scale)));
+    decodeOpts.desiredSize.height = max(1, static_cast<int32_t>(ceil(imageInfo.size.height * scale)));
+}
+
+void ThumbnailDataCopy(ThumbnailData &data, const ThumbnailRdbData &rdbData)
 {
     data.id = rdbData.id;
     data.path = rdbData.path;
@@ -110,7 +146,7 @@ bool MediaLibraryThumbnail::CreateThumbnail(ThumbRdbOpt &opts,
         return true;
     }
 
-    if (!LoadSourceImage(data)) {
+    if (!LoadSourceImage(data, DEFAULT_THUMBNAIL_SIZE)) {
         return false;
     }
 
@@ -146,7 +182,68 @@ bool MediaLibraryThumbnail::CreateThumbnail(ThumbRdbOpt &opts,
     return true;
 }
 
+// Requests for a row and rendition already being generated wait for that generation and share its
+// result instead of decoding and compressing the same source again. A request for the other rendition
+// of the row waits until that generation is done and then runs its own.
+bool MediaLibraryThumbnail::GenerateOnce(ThumbRdbOpt &opts, ThumbnailRendition rendition, string &key,
+    GenerateFunc generate)
+{
+    ThumbnailFlightKey flightKey(opts.table, opts.row);
+    shared_ptr<ThumbnailFlight> flight;
+    function<void()> flightHook;
+    {
+        unique_lock<mutex> lock(flightLock_);
+        for (auto iter = flights_.find(flightKey); iter != flights_.end(); iter = flights_.find(flightKey)) {
+            flight = iter->second;
+            if (flight->rendition == rendition) {
+                coalescedCount_++;
+                flight->finished.wait(lock, [&flight] { return flight->done; });
+                key = flight->key;
+                return flight->ret;
+            }
+            flight->finished.wait(lock, [&flight] { return flight->done; });
+        }
+        flight = make_shared<ThumbnailFlight>();
+        flight->rendition = rendition;
+        flights_.emplace(flightKey, flight);
+        flightHook = flightHook_;
+    }
+
+    if (flightHook) {
+        flightHook();
+    }
+    generatedCount_++;
+    bool ret = (this->*generate)(opts, key);
+
+    lock_guard<mutex> lock(flightLock_);
+    flight->done = true;
+    flight->ret = ret;
+    flight->key = key;
+    flights_.erase(flightKey);
+    flight->finished.notify_all();
+    return ret;
+}
+
+ThumbnailFlightCounters MediaLibraryThumbnail::GetFlightCounters() const
+{
+    ThumbnailFlightCounters counters;
+    counters.generated = generatedCount_.load();
+    counters.coalesced = coalescedCount_.load();
+    return counters;
+}
+
+void MediaLibraryThumbnail::SetFlightHook(const function<void()> &hook)
+{
+    lock_guard<mutex> lock(flightLock_);
+    flightHook_ = hook;
+}
+
 bool MediaLibraryThumbnail::CreateThumbnail(ThumbRdbOpt &opts, string &key)
+{
+    return GenerateOnce(opts, ThumbnailRendition::THUMBNAIL, key, &MediaLibraryThumbnail::GenerateThumbnail);
+}
+
+bool MediaLibraryThumbnail::GenerateThumbnail(ThumbRdbOpt &opts, string &key)
 {
     StartTrace(BYTRACE_TAG_OHOS, "CreateThumbnail");
     MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateThumbnail IN");
@@ -166,64 +263,100 @@ bool MediaLibraryThumbnail::CreateThumbnail(ThumbRdbOpt &opts, string &key)
 }
 
 bool MediaLibraryThumbnail::CreateLcd(ThumbRdbOpt &opts, string &key)
+{
+    return GenerateOnce(opts, ThumbnailRendition::LCD, key, &MediaLibraryThumbnail::GenerateLcd);
+}
+
+bool MediaLibraryThumbnail::GenerateLcd(ThumbRdbOpt &opts, string &key)
 {
     StartTrace(BYTRACE_TAG_OHOS, "CreateLcd");
     MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateLcd IN");
 
+    string thumbnailKey;
+    bool ret = CreateRenditions(opts, thumbnailKey, key);
+
+    MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateLcd OUT");
+    FinishTrace(BYTRACE_TAG_OHOS);
+
+    return ret;
+}
+
+// Generate whichever of the thumbnail and LCD renditions is missing from a single decode. The
+// source is decoded at LCD size when the LCD is needed and both renditions are compressed from
+// that buffer; their keys share one hash of the source pixels and land in one row update.
+bool MediaLibraryThumbnail::CreateRenditions(ThumbRdbOpt &opts, string &thumbnailKey, string &lcdKey)
+{
+    StartTrace(BYTRACE_TAG_OHOS, "CreateRenditions");
+    MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateRenditions IN");
+
     ThumbnailData thumbnailData;
     int errorCode;
     if (!QueryThumbnailInfo(opts, thumbnailData, errorCode)) {
         return false;
     }
 
-    if (!thumbnailData.lcdKey.empty() &&
-        IsImageExist(thumbnailData.lcdKey)) {
-        MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateLcd image has exist in kvStore");
+    bool needThumbnail = thumbnailData.thumbnailKey.empty() || !IsImageExist(thumbnailData.thumbnailKey);
+    bool needLcd = thumbnailData.lcdKey.empty() || !IsImageExist(thumbnailData.lcdKey);
+    if (!needThumbnail && !needLcd) {
+        MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateRenditions image has exist in kvStore");
+        thumbnailKey = thumbnailData.thumbnailKey;
+        lcdKey = thumbnailData.lcdKey;
         return true;
     }
 
-    if (!LoadSourceImage(thumbnailData)) {
-        return false;
-    }
-
-    StartTrace(BYTRACE_TAG_OHOS, "CreateLcd GenLcdKey");
-    if (!GenLcdKey(thumbnailData)) {
+    if (!LoadSourceImage(thumbnailData, needLcd ? DEFAULT_LCD_SIZE : DEFAULT_THUMBNAIL_SIZE)) {
         return false;
     }
-    FinishTrace(BYTRACE_TAG_OHOS);
 
-    if (thumbnailData.lcdKey.empty()) {
-        MEDIA_ERR_LOG("MediaLibraryThumbnail::Gen lcd Key is empty");
+    // Same key as CreateThumbnail and CreateThumbnails give the asset, although this decode is LCD sized
+    string sourceKey;
+    if (!GenSourceKey(thumbnailData, sourceKey) || sourceKey.empty()) {
+        MEDIA_ERR_LOG("MediaLibraryThumbnail::Gen rendition Key is empty");
         return false;
     }
 
-    if (IsImageExist(thumbnailData.lcdKey)) {
-        MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateThumbnail Get lcd in kvStore");
-    } else {
-        if (!CreateLcdData(thumbnailData)) {
-            return false;
+    // A row key that is not the source key any more belongs to an older version of the file
+    vector<string> replacedKeys;
+    if (needThumbnail) {
+        if (!thumbnailData.thumbnailKey.empty()) {
+            replacedKeys.push_back(thumbnailData.thumbnailKey);
         }
-
-        if (!SaveLcdData(thumbnailData)) {
+        thumbnailData.thumbnailKey = sourceKey + THUMBNAIL_END_SUFFIX;
+        if (!IsImageExist(thumbnailData.thumbnailKey) &&
+            (!CreateThumbnailData(thumbnailData) || !SaveThumbnailData(thumbnailData))) {
             return false;
         }
     }
 
-    if (thumbnailData.thumbnailKey.empty()) {
-        CreateThumbnail(opts, thumbnailData, key);
+    if (needLcd) {
+        if (!thumbnailData.lcdKey.empty()) {
+            replacedKeys.push_back(thumbnailData.lcdKey);
+        }
+        thumbnailData.lcdKey = sourceKey + THUMBNAIL_LCD_END_SUFFIX;
+        if (!IsImageExist(thumbnailData.lcdKey) &&
+            (!CreateLcdData(thumbnailData) || !SaveLcdData(thumbnailData))) {
+            return false;
+        }
     }
+    thumbnailData.source.reset();
 
-    thumbnailData.thumbnail.clear();
-
-    StartTrace(BYTRACE_TAG_OHOS, "CreateLcd UpdateThumbnailInfo");
+    StartTrace(BYTRACE_TAG_OHOS, "CreateRenditions UpdateThumbnailInfo");
     if (!UpdateThumbnailInfo(opts, thumbnailData, errorCode)) {
         return false;
     }
     FinishTrace(BYTRACE_TAG_OHOS);
 
-    key = thumbnailData.lcdKey;
+    // Nothing refers to the old images any more once the row has the new keys
+    for (auto &replacedKey : replacedKeys) {
+        if ((replacedKey != thumbnailData.thumbnailKey) && (replacedKey != thumbnailData.lcdKey)) {
+            DeleteImage(replacedKey);
+        }
+    }
+
+    thumbnailKey = thumbnailData.thumbnailKey;
+    lcdKey = thumbnailData.lcdKey;
 
-    MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateLcd OUT");
+    MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateRenditions OUT");
     FinishTrace(BYTRACE_TAG_OHOS);
 
     return true;
@@ -293,6 +426,9 @@ unique_ptr<PixelMap> MediaLibraryThumbnail::GetThumbnailByRdb(ThumbRdbOpt &opts,
     return GetThumbnail(key, size, uri);
 }
 
+// Generate the missing thumbnails of a table. Decoding, resizing and compressing run on a pool
+// of workers; each worker drops the decoded source as soon as it is compressed, so at most one
+// full size image per worker is alive. The calling thread writes the results in batches.
 void MediaLibraryThumbnail::CreateThumbnails(ThumbRdbOpt &opts)
 {
     MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateThumbnails IN");
@@ -308,19 +444,151 @@ void MediaLibraryThumbnail::CreateThumbnails(ThumbRdbOpt &opts)
         return;
     }
 
-    for (uint32_t i = 0; i < infos.size(); i++) {
-        string key;
+    ThumbnailPipeline pipeline;
+    uint32_t workerCount = min(max(thread::hardware_concurrency(), 1u), THUMBNAIL_WORKER_MAX);
+    workerCount = min(workerCount, static_cast<uint32_t>(infos.size()));
+    pipeline.activeWorkers = workerCount;
+
+    vector<thread> workers;
+    for (uint32_t i = 0; i < workerCount; i++) {
+        workers.emplace_back(&MediaLibraryThumbnail::GenerateThumbnailWorker, this, ref(pipeline), cref(infos));
+    }
+    WriteThumbnails(opts, pipeline);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateThumbnails OUT");
+}
+
+void MediaLibraryThumbnail::GenerateThumbnailWorker(ThumbnailPipeline &pipeline,
+                                                    const vector<ThumbnailRdbData> &infos)
+{
+    for (size_t i = pipeline.nextIndex++; i < infos.size(); i = pipeline.nextIndex++) {
         ThumbnailData data;
-        opts.row = infos[i].id;
         ThumbnailDataCopy(data, infos[i]);
-        CreateThumbnail(opts, data, key);
+        if (!PrepareThumbnailData(data)) {
+            continue;
+        }
+
+        unique_lock<mutex> lock(pipeline.lock);
+        pipeline.notFull.wait(lock, [&pipeline]() { return pipeline.pending.size() < THUMBNAIL_PENDING_MAX; });
+        pipeline.pending.push_back(move(data));
+        pipeline.notEmpty.notify_one();
     }
 
-    MEDIA_INFO_LOG("MediaLibraryThumbnail::CreateThumbnails OUT");
+    lock_guard<mutex> lock(pipeline.lock);
+    pipeline.activeWorkers--;
+    pipeline.notEmpty.notify_one();
+}
+
+// Same steps as CreateThumbnail up to the kv store write. data.thumbnail stays empty when the
+// key already has an image, only the row then needs its key.
+bool MediaLibraryThumbnail::PrepareThumbnailData(ThumbnailData &data)
+{
+    if (!LoadSourceImage(data, DEFAULT_THUMBNAIL_SIZE)) {
+        return false;
+    }
+
+    if (!GenThumbnailKey(data) || data.thumbnailKey.empty()) {
+        MEDIA_ERR_LOG("MediaLibraryThumbnail::Gen Thumbnail Key is empty");
+        return false;
+    }
+
+    bool ret = true;
+    if (!IsImageExist(data.thumbnailKey)) {
+        ret = CreateThumbnailData(data);
+    }
+    data.source.reset();
+    return ret;
+}
+
+void MediaLibraryThumbnail::WriteThumbnails(ThumbRdbOpt &opts, ThumbnailPipeline &pipeline)
+{
+    vector<ThumbnailData> batch;
+    while (true) {
+        {
+            unique_lock<mutex> lock(pipeline.lock);
+            pipeline.notEmpty.wait(lock, [&pipeline]() {
+                return pipeline.pending.size() >= THUMBNAIL_WRITE_BATCH || pipeline.activeWorkers == 0;
+            });
+            if (pipeline.pending.empty() && pipeline.activeWorkers == 0) {
+                break;
+            }
+            while (!pipeline.pending.empty() && batch.size() < THUMBNAIL_WRITE_BATCH) {
+                batch.push_back(move(pipeline.pending.front()));
+                pipeline.pending.pop_front();
+            }
+        }
+        pipeline.notFull.notify_all();
+
+        // The kv store or the transaction may be busy for a moment, give the batch a second try
+        if (!SaveThumbnailBatch(opts, batch) && !SaveThumbnailBatch(opts, batch)) {
+            MEDIA_ERR_LOG("Failed to save %{public}zu thumbnails", batch.size());
+        }
+        batch.clear();
+    }
+}
+
+// One kv store PutBatch, one transaction for the row updates and one table sync per batch
+bool MediaLibraryThumbnail::SaveThumbnailBatch(ThumbRdbOpt &opts, vector<ThumbnailData> &batch)
+{
+    if (singleKvStorePtr_ == nullptr) {
+        MEDIA_ERR_LOG("KvStore is not init");
+        return false;
+    }
+
+    StartTrace(BYTRACE_TAG_OHOS, "SaveThumbnailBatch singleKvStorePtr_->PutBatch");
+
+    vector<Entry> entries;
+    for (auto &data : batch) {
+        if (!data.thumbnail.empty()) {
+            Entry entry;
+            entry.key = data.thumbnailKey;
+            entry.value = Value(data.thumbnail);
+            entries.push_back(move(entry));
+        }
+    }
+    if (!entries.empty()) {
+        Status status = singleKvStorePtr_->PutBatch(entries);
+        if (status != Status::SUCCESS) {
+            MEDIA_ERR_LOG("Failed to PutBatch %{private}d", static_cast<int32_t>(status));
+            FinishTrace(BYTRACE_TAG_OHOS);
+            return false;
+        }
+    }
+    FinishTrace(BYTRACE_TAG_OHOS);
+
+    StartTrace(BYTRACE_TAG_OHOS, "SaveThumbnailBatch opts.store->Update");
+    int errorCode = MediaLibraryDataManager::ExecuteInTransaction(opts.store, [&opts, &batch]() {
+        for (auto &data : batch) {
+            ValuesBucket values;
+            values.PutString(MEDIA_DATA_DB_THUMBNAIL, data.thumbnailKey);
+            int changedRows = 0;
+            int ret = opts.store->Update(changedRows, opts.table, values, MEDIA_DATA_DB_ID + " = ?",
+                vector<string> { data.id });
+            if (ret != NativeRdb::E_OK) {
+                MEDIA_ERR_LOG("RdbStore Update failed! %{private}d", ret);
+                return DATA_ABILITY_FAIL;
+            }
+        }
+        return DATA_ABILITY_SUCCESS;
+    });
+    if (errorCode != DATA_ABILITY_SUCCESS) {
+        FinishTrace(BYTRACE_TAG_OHOS);
+        return false;
+    }
+
+    // Pushed with the other writes of the window, not once per thumbnail
+    MediaLibrarySyncScheduler::GetInstance()->MarkDirty(MEDIALIBRARY_TABLE);
+    FinishTrace(BYTRACE_TAG_OHOS);
+
+    return true;
 }
 
 bool MediaLibraryThumbnail::LoadAudioFile(string &path,
-                                          shared_ptr<PixelMap> &pixelMap)
+                                          shared_ptr<PixelMap> &pixelMap,
+                                          const Size &desiredSize)
 {
     MEDIA_INFO_LOG("MediaLibraryThumbnail::LoadAudioFile IN");
 #ifdef OLD_MEDIA_STD_API
@@ -352,6 +620,7 @@ bool MediaLibraryThumbnail::LoadAudioFile(string &path,
 
     error = SUCCESS;
     DecodeOptions decOpts;
+    SetDecodeSize(*audioImageSource, desiredSize, decOpts);
     pixelMap = audioImageSource->CreatePixelMap(decOpts, error);
     if (pixelMap == nullptr) {
         MEDIA_ERR_LOG("Av meta data helper fetch frame at time failed");
@@ -390,7 +659,8 @@ bool MediaLibraryThumbnail::LoadVideoFile(string &path,
     return true;
 }
 bool MediaLibraryThumbnail::LoadImageFile(string &path,
-                                          shared_ptr<PixelMap> &pixelMap)
+                                          shared_ptr<PixelMap> &pixelMap,
+                                          const Size &desiredSize)
 {
     MEDIA_INFO_LOG("MediaLibraryThumbnail::LoadImageFile IN");
     uint32_t errorCode = 0;
@@ -409,6 +679,7 @@ bool MediaLibraryThumbnail::LoadImageFile(string &path,
 
     StartTrace(BYTRACE_TAG_OHOS, "imageSource->CreatePixelMap");
     DecodeOptions decodeOpts;
+    SetDecodeSize(*imageSource, desiredSize, decodeOpts);
     pixelMap = imageSource->CreatePixelMap(decodeOpts, errorCode);
     if (errorCode != Media::SUCCESS) {
         MEDIA_ERR_LOG("Failed to create pixelmap path %{private}s err %{private}d",
@@ -421,19 +692,9 @@ bool MediaLibraryThumbnail::LoadImageFile(string &path,
     return true;
 }
 
-bool MediaLibraryThumbnail::GenKey(vector<uint8_t> &data, string &key)
+// Translate a sha256 hash to hexadecimal, each 8-bit char is presented by two characters([0-9a-f])
+static void HashToKey(const unsigned char (&hash)[SHA256_DIGEST_LENGTH], string &key)
 {
-    MEDIA_INFO_LOG("MediaLibraryThumbnail::GenKey IN");
-    if (data.size() <= 0) {
-        MEDIA_ERR_LOG("Empty data");
-        return false;
-    }
-    unsigned char hash[SHA256_DIGEST_LENGTH] = "";
-    SHA256_CTX ctx;
-    SHA256_Init(&ctx);
-    SHA256_Update(&ctx, data.data(), data.size());
-    SHA256_Final(hash, &ctx);
-    // here we translate sha256 hash to hexadecimal. each 8-bit char will be presented by two characters([0-9a-f])
     constexpr int CHAR_WIDTH = 8;
     constexpr int HEX_WIDTH = 4;
     constexpr unsigned char HEX_MASK = 0xf;
@@ -453,10 +714,67 @@ bool MediaLibraryThumbnail::GenKey(vector<uint8_t> &data, string &key)
             key.push_back('a' + hex - HEX_A);
         }
     }
+}
+
+bool MediaLibraryThumbnail::GenKey(vector<uint8_t> &data, string &key)
+{
+    MEDIA_INFO_LOG("MediaLibraryThumbnail::GenKey IN");
+    if (data.size() <= 0) {
+        MEDIA_ERR_LOG("Empty data");
+        return false;
+    }
+    unsigned char hash[SHA256_DIGEST_LENGTH] = "";
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    SHA256_Update(&ctx, data.data(), data.size());
+    SHA256_Final(hash, &ctx);
+    HashToKey(hash, key);
     MEDIA_INFO_LOG("MediaLibraryThumbnail::GenKey OUT [%{private}s]", key.c_str());
     return true;
 }
 
+bool MediaLibraryThumbnail::GenFileKey(const string &path, string &key)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        MEDIA_ERR_LOG("Failed to open %{private}s, errno %{public}d", path.c_str(), errno);
+        return false;
+    }
+    SHA256_CTX ctx;
+    SHA256_Init(&ctx);
+    vector<uint8_t> buffer(FILE_HASH_BUFFER_SIZE);
+    ssize_t readSize = 0;
+    size_t totalSize = 0;
+    while ((readSize = read(fd, buffer.data(), buffer.size())) > 0) {
+        SHA256_Update(&ctx, buffer.data(), static_cast<size_t>(readSize));
+        totalSize += static_cast<size_t>(readSize);
+    }
+    close(fd);
+    if ((readSize < 0) || (totalSize == 0)) {
+        MEDIA_ERR_LOG("Failed to read %{private}s", path.c_str());
+        return false;
+    }
+    unsigned char hash[SHA256_DIGEST_LENGTH] = "";
+    SHA256_Final(hash, &ctx);
+    HashToKey(hash, key);
+    return true;
+}
+
+// Key of every rendition of the asset, whatever size its source was decoded at. Images and audio hash
+// the file, a video frame is always decoded at full size so its pixels are hashed instead of the whole video.
+bool MediaLibraryThumbnail::GenSourceKey(ThumbnailData &data, string &key)
+{
+    if (data.mediaType != MEDIA_TYPE_VIDEO) {
+        return GenFileKey(data.path, key);
+    }
+    if (data.source == nullptr) {
+        MEDIA_ERR_LOG("Video frame is not loaded");
+        return false;
+    }
+    vector<uint8_t> source(data.source->GetPixels(), data.source->GetPixels() + data.source->GetByteCount());
+    return GenKey(source, key);
+}
+
 bool MediaLibraryThumbnail::CompressImage(std::shared_ptr<PixelMap> &pixelMap,
                                           Size &size,
                                           std::vector<uint8_t> &data)
@@ -535,6 +853,23 @@ bool MediaLibraryThumbnail::SaveImage(string &key, vector<uint8_t> &image)
     return true;
 }
 
+bool MediaLibraryThumbnail::DeleteImage(const string &key)
+{
+    if (singleKvStorePtr_ == nullptr) {
+        MEDIA_ERR_LOG("KvStore is not init");
+        return false;
+    }
+
+    StartTrace(BYTRACE_TAG_OHOS, "DeleteImage singleKvStorePtr_->Delete");
+    Status status = singleKvStorePtr_->Delete(key);
+    FinishTrace(BYTRACE_TAG_OHOS);
+    if (status != Status::SUCCESS) {
+        MEDIA_ERR_LOG("Failed to Delete %{private}d", static_cast<int32_t>(status));
+        return false;
+    }
+    return true;
+}
+
 shared_ptr<ResultSetBridge> MediaLibraryThumbnail::QueryThumbnailSet(ThumbRdbOpt &opts)
 {
     MEDIA_INFO_LOG("MediaLibraryThumbnail::QueryThumbnailSet IN row [%{private}s]",
@@ -566,33 +901,18 @@ shared_ptr<ResultSetBridge> MediaLibraryThumbnail::QueryThumbnailInfo(ThumbRdbOp
 
     MEDIA_INFO_LOG("MediaLibraryThumbnail::QueryThumbnailInfo IN row [%{private}s]",
                    opts.row.c_str());
-    vector<string> column = {
-        MEDIA_DATA_DB_ID,
-        MEDIA_DATA_DB_FILE_PATH,
-        MEDIA_DATA_DB_THUMBNAIL,
-        MEDIA_DATA_DB_LCD,
-        MEDIA_DATA_DB_MEDIA_TYPE
-    };
-
-    vector<string> selectionArgs;
-    string strQueryCondition = MEDIA_DATA_DB_ID + "=" + opts.row;
-
-    AbsRdbPredicates rdbPredicates(opts.table);
-    rdbPredicates.SetWhereClause(strQueryCondition);
-    rdbPredicates.SetWhereArgs(selectionArgs);
-
-    StartTrace(BYTRACE_TAG_OHOS, "opts.store->Query");
-    shared_ptr<AbsSharedResultSet> resultSet = opts.store->Query(rdbPredicates, column);
+    // Selects id, data, thumbnail, lcd and media_type with the row bound
+    shared_ptr<AbsSharedResultSet> resultSet = MediaLibraryStatementCache::GetInstance()->Query(opts.store,
+        StatementId::THUMBNAIL_INFO, opts.row, opts.table);
     int rowCount = 0;
-    errorCode = resultSet->GetRowCount(rowCount);
+    errorCode = (resultSet == nullptr) ? NativeRdb::E_ERROR : resultSet->GetRowCount(rowCount);
     if (errorCode != NativeRdb::E_OK) {
         MEDIA_ERR_LOG("Failed to get row count %{private}d", errorCode);
         return nullptr;
     }
-    FinishTrace(BYTRACE_TAG_OHOS);
 
     if (rowCount <= 0) {
-        MEDIA_ERR_LOG("No match! %{private}s", rdbPredicates.GetWhereClause().c_str());
+        MEDIA_ERR_LOG("No match! row %{private}s", opts.row.c_str());
         errorCode = NativeRdb::E_EMPTY_VALUES_BUCKET;
         return nullptr;
     }
@@ -710,22 +1030,28 @@ bool MediaLibraryThumbnail::UpdateThumbnailInfo(ThumbRdbOpt &opts,
     }
 
     StartTrace(BYTRACE_TAG_OHOS, "UpdateThumbnailInfo opts.store->Update");
-    errorCode = opts.store->Update(changedRows, opts.table, values, MEDIA_DATA_DB_ID+" = ?",
-        vector<string> { opts.row });
-    if (errorCode != NativeRdb::E_OK) {
-        MEDIA_ERR_LOG("RdbStore Update failed! %{private}d", errorCode);
+    // Through the writer lock, a plain update would otherwise join the open transaction of another thread
+    errorCode = MediaLibraryDataManager::ExecuteInTransaction(opts.store, [&opts, &values, &changedRows]() {
+        int ret = opts.store->Update(changedRows, opts.table, values, MEDIA_DATA_DB_ID + " = ?",
+            vector<string> { opts.row });
+        if (ret != NativeRdb::E_OK) {
+            MEDIA_ERR_LOG("RdbStore Update failed! %{private}d", ret);
+            return DATA_ABILITY_FAIL;
+        }
+        return DATA_ABILITY_SUCCESS;
+    });
+    if (errorCode != DATA_ABILITY_SUCCESS) {
+        FinishTrace(BYTRACE_TAG_OHOS);
         return false;
     }
     FinishTrace(BYTRACE_TAG_OHOS);
 
-    std::vector<std::string> devices = std::vector<std::string>();
-    MediaLibrarySyncTable syncTable;
-    syncTable.SyncPushTable(opts.store, BUNDLE_NAME, MEDIALIBRARY_TABLE, devices);
+    MediaLibrarySyncScheduler::GetInstance()->MarkDirty(MEDIALIBRARY_TABLE);
 
     return true;
 }
 
-bool MediaLibraryThumbnail::LoadSourceImage(ThumbnailData &data)
+bool MediaLibraryThumbnail::LoadSourceImage(ThumbnailData &data, const Size &desiredSize)
 {
     StartTrace(BYTRACE_TAG_OHOS, "LoadSourceImage");
     MEDIA_INFO_LOG("MediaLibraryThumbnail::LoadSourceImage IN");
@@ -734,9 +1060,9 @@ bool MediaLibraryThumbnail::LoadSourceImage(ThumbnailData &data)
     if (data.mediaType == MEDIA_TYPE_VIDEO) {
         ret = LoadVideoFile(data.path, data.source);
     } else if (data.mediaType == MEDIA_TYPE_AUDIO) {
-        ret = LoadAudioFile(data.path, data.source);
+        ret = LoadAudioFile(data.path, data.source, desiredSize);
     } else {
-        ret = LoadImageFile(data.path, data.source);
+        ret = LoadImageFile(data.path, data.source, desiredSize);
     }
 
     MEDIA_INFO_LOG("MediaLibraryThumbnail::LoadSourceImage OUT");
@@ -748,10 +1074,8 @@ bool MediaLibraryThumbnail::GenThumbnailKey(ThumbnailData &data)
 {
     StartTrace(BYTRACE_TAG_OHOS, "GenThumbnailKey");
     MEDIA_INFO_LOG("MediaLibraryThumbnail::GenThumbnailKey IN");
-    vector<uint8_t> source(data.source->GetPixels(),
-        data.source->GetPixels() + data.source->GetByteCount());
-
-    bool ret = GenKey(source, data.thumbnailKey);
+    data.thumbnailKey.clear();
+    bool ret = GenSourceKey(data, data.thumbnailKey);
     if (ret) {
         data.thumbnailKey += THUMBNAIL_END_SUFFIX;
     }
@@ -765,10 +1089,8 @@ bool MediaLibraryThumbnail::GenThumbnailKey(ThumbnailData &data)
 bool MediaLibraryThumbnail::GenLcdKey(ThumbnailData &data)
 {
     MEDIA_INFO_LOG("MediaLibraryThumbnail::GenLcdKey IN");
-    vector<uint8_t> source(data.source->GetPixels(),
-        data.source->GetPixels() + data.source->GetByteCount());
-
-    bool ret = GenKey(source, data.lcdKey);
+    data.lcdKey.clear();
+    bool ret = GenSourceKey(data, data.lcdKey);
     if (ret) {
         data.lcdKey += THUMBNAIL_LCD_END_SUFFIX;
     }
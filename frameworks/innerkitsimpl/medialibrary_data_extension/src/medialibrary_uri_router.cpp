@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_uri_router.h"
+
+#include <climits>
+#include <functional>
+#include <map>
+
+#include "media_data_ability_const.h"
+#include "media_log.h"
+
+using namespace std;
+
+namespace OHOS {
+namespace Media {
+namespace {
+    const map<string, UriOprnGroup, less<>> OPRN_GROUPS {
+        { MEDIA_FILEOPRN, UriOprnGroup::FILE },
+        { MEDIA_ALBUMOPRN, UriOprnGroup::ALBUM },
+        { MEDIA_SMARTALBUMOPRN, UriOprnGroup::SMARTALBUM },
+        { MEDIA_SMARTALBUMMAPOPRN, UriOprnGroup::SMARTALBUMMAP },
+        { MEDIA_KVSTOREOPRN, UriOprnGroup::KVSTORE },
+        { MEDIA_QUERYOPRN, UriOprnGroup::QUERY },
+        { MEDIA_BOARDCASTOPRN, UriOprnGroup::BOARDCAST },
+    };
+
+    const map<string, TableType, less<>> VIEW_URIS {
+        { MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM + "/" + SMARTABLUMASSETS_VIEW_NAME,
+            TYPE_SMARTALBUMASSETS_TABLE },
+        { MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM + "/" + ASSETMAP_VIEW_NAME, TYPE_ASSETSMAP_TABLE },
+        { MEDIALIBRARY_DATA_URI + "/" + MEDIA_DEVICE_QUERYALLDEVICE, TYPE_ALL_DEVICE },
+        { MEDIALIBRARY_DATA_URI + "/" + MEDIA_DEVICE_QUERYACTIVEDEVICE, TYPE_ACTIVE_DEVICE },
+    };
+
+    // Positive decimal without sign, 0 when the value is not one
+    int32_t ToPositiveInt(string_view value)
+    {
+        int64_t result = 0;
+        for (char c : value) {
+            if ((c < '0') || (c > '9')) {
+                return 0;
+            }
+            result = result * 10 + (c - '0');
+            if (result > INT32_MAX) {
+                return 0;
+            }
+        }
+        return static_cast<int32_t>(result);
+    }
+} // namespace
+
+MediaLibraryUri MediaLibraryUriRouter::Parse(const string &uri)
+{
+    MediaLibraryUri route;
+    string_view view(uri);
+    string_view::size_type pos = view.find_last_of('?');
+    if (pos != string_view::npos) {
+        ParseThumbnail(view.substr(pos + 1), route);
+        view = view.substr(0, pos);
+    }
+    route.uri = string(view);
+
+    if (view.compare(0, MEDIALIBRARY_DATA_ABILITY_PREFIX.length(), MEDIALIBRARY_DATA_ABILITY_PREFIX) == 0) {
+        string_view authority = view.substr(MEDIALIBRARY_DATA_ABILITY_PREFIX.length());
+        pos = authority.find('/');
+        if ((pos != 0) && (pos != string_view::npos)) {
+            route.networkId = string(authority.substr(0, pos));
+        }
+    }
+
+    pos = view.find_last_of('/');
+    route.operation = string(view.substr((pos == string_view::npos) ? 0 : (pos + 1)));
+    if (pos != string_view::npos) {
+        string_view parent = view.substr(0, pos);
+        string_view::size_type posTable = parent.find_last_of('/');
+        route.parent = string(parent);
+        route.table = string(parent.substr((posTable == string_view::npos) ? 0 : (posTable + 1)));
+    }
+
+    for (string_view::size_type start = 0; start < view.size();) {
+        string_view::size_type end = view.find('/', start);
+        auto iter = OPRN_GROUPS.find(view.substr(start, end - start));
+        if (iter != OPRN_GROUPS.end()) {
+            route.group = iter->second;
+            break;
+        }
+        if (end == string_view::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    if ((route.group == UriOprnGroup::NONE) && (view.find(MEDIA_OPERN_KEYWORD) != string_view::npos)) {
+        route.group = UriOprnGroup::UNKNOWN;
+    }
+
+    if (route.operation == MEDIA_ALBUMOPRN_QUERYALBUM) {
+        route.tableType = TYPE_ALBUM_TABLE;
+    } else {
+        auto iter = VIEW_URIS.find(view);
+        if (iter != VIEW_URIS.end()) {
+            route.tableType = iter->second;
+        }
+    }
+    return route;
+}
+
+void MediaLibraryUriRouter::ParseThumbnail(string_view query, MediaLibraryUri &route)
+{
+    const size_t thumbnailKeys = 3;
+    string_view action;
+    int32_t width = 0;
+    int32_t height = 0;
+    size_t keys = 0;
+    for (string_view::size_type start = 0; start < query.size(); keys++) {
+        string_view::size_type end = query.find('&', start);
+        string_view keyValue = query.substr(start, end - start);
+        string_view::size_type pos = keyValue.find('=');
+        if ((pos == 0) || (pos == string_view::npos)) {
+            MEDIA_ERR_LOG("Parse key error [ %{private}s ]", string(keyValue).c_str());
+            return;
+        }
+        string_view key = keyValue.substr(0, pos);
+        string_view value = keyValue.substr(pos + 1);
+        if (key == MEDIA_OPERN_KEYWORD) {
+            action = value;
+        } else if (key == MEDIA_DATA_DB_WIDTH) {
+            width = ToPositiveInt(value);
+        } else if (key == MEDIA_DATA_DB_HEIGHT) {
+            height = ToPositiveInt(value);
+        }
+        if (end == string_view::npos) {
+            keys++;
+            break;
+        }
+        start = end + 1;
+    }
+
+    if ((keys != thumbnailKeys) || (action != MEDIA_DATA_DB_THUMBNAIL) || (width <= 0) || (height <= 0)) {
+        MEDIA_ERR_LOG("Thumbnail args error, keys %{public}d width %{private}d height %{private}d",
+            static_cast<int32_t>(keys), width, height);
+        return;
+    }
+    route.isThumbnail = true;
+    route.width = width;
+    route.height = height;
+}
+} // namespace Media
+} // namespace OHOS
@@ -0,0 +1,1196 @@
+/*
+ * Copyright (C) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mediadataability_rdb_unit_test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "abs_rdb_predicates.h"
+#include "datashare_values_bucket.h"
+#include "media_data_ability_const.h"
+#include "media_lib_service_const.h"
+#include "media_scanner_db.h"
+#include "medialibrary_album_cache.h"
+#include "medialibrary_data_manager.h"
+#include "medialibrary_data_manager_utils.h"
+#include "medialibrary_pull_cache.h"
+#include "medialibrary_smartalbum_map_operations.h"
+#include "medialibrary_statement_cache.h"
+#include "medialibrary_sync_scheduler.h"
+#include "medialibrary_uri_router.h"
+#include "metadata.h"
+#include "rdb_errno.h"
+#include "rdb_helper.h"
+
+using namespace std;
+using namespace OHOS::NativeRdb;
+using namespace testing::ext;
+
+namespace OHOS {
+namespace Media {
+namespace {
+    const string TEST_DB_PATH = "/data/test/mediadataability_rdb_test.db";
+    const string FILES_DB_PATH = "/data/test/mediadataability_rdb_files.db";
+    const int32_t FILES_ROW_COUNT = 10000;
+    const int32_t FILES_ALBUM_COUNT = 200;
+    const int32_t FILES_TRASH_RATIO = 50;
+    const int32_t CACHED_ALBUM_COUNT = 20;
+    const int32_t DIRTY_MARK_COUNT = 100;
+    const int32_t MAP_BATCH_ASSETS = 500;
+    const int32_t PATH_LOOKUP_ROWS = 1000;
+    const int32_t SCAN_BATCHES = 20;
+    const int32_t SCAN_BATCH_ASSETS = 100;
+    const int32_t GRID_READERS = 4;
+    const int32_t GRID_PAGE_ROWS = 100;
+    // Pages the readers cycle through, all of them full whatever the scanner has written yet
+    const int32_t GRID_PAGES = FILES_ROW_COUNT / 2 / GRID_PAGE_ROWS;
+    const chrono::milliseconds SYNC_WINDOW(100);
+    // Store filled with FILES_ROW_COUNT rows at MEDIA_RDB_VERSION_INIT, shared by the cases
+    shared_ptr<RdbStore> g_filesStore = nullptr;
+
+    // Store the data manager served before a case swapped in its own one
+    shared_ptr<RdbStore> g_savedRdbStore = nullptr;
+    bool g_isRdbStoreSwapped = false;
+
+    // A store with the current schema, as the data manager creates it on a new device
+    shared_ptr<RdbStore> OpenTestStore(const string &path)
+    {
+        RdbHelper::DeleteRdbStore(path);
+        RdbStoreConfig config(path);
+        MediaLibraryDataCallBack callback;
+        int32_t errCode = E_OK;
+        return RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION, callback, errCode);
+    }
+
+    int32_t SwapDataManagerStore(const shared_ptr<RdbStore> &store)
+    {
+        auto dataManager = MediaLibraryDataManager::GetInstance();
+        g_savedRdbStore = dataManager->GetRdbStore();
+        g_isRdbStoreSwapped = true;
+        return dataManager->InitMediaLibraryRdbStore(store);
+    }
+
+    void RestoreDataManagerStore()
+    {
+        if (!g_isRdbStoreSwapped) {
+            return;
+        }
+        auto dataManager = MediaLibraryDataManager::GetInstance();
+        if (g_savedRdbStore != nullptr) {
+            dataManager->InitMediaLibraryRdbStore(g_savedRdbStore);
+        } else {
+            dataManager->ClearMediaLibraryMgr();
+        }
+        g_savedRdbStore = nullptr;
+        g_isRdbStoreSwapped = false;
+    }
+
+    int32_t QueryCount(RdbStore &store, const string &sql, const vector<string> &args)
+    {
+        int32_t count = -1;
+        auto resultSet = store.QuerySql(sql, args);
+        if ((resultSet != nullptr) && (resultSet->GoToFirstRow() == E_OK)) {
+            resultSet->GetInt(0, count);
+        }
+        if (resultSet != nullptr) {
+            resultSet->Close();
+        }
+        return count;
+    }
+
+    int32_t CountFiles(RdbStore &store)
+    {
+        return QueryCount(store, "SELECT COUNT(*) FROM " + MEDIALIBRARY_TABLE, {});
+    }
+
+    string QueryFileName(RdbStore &store, int32_t id)
+    {
+        string name;
+        auto resultSet = store.QuerySql("SELECT " + MEDIA_DATA_DB_NAME + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+            MEDIA_DATA_DB_ID + " = ?", vector<string> { to_string(id) });
+        if ((resultSet != nullptr) && (resultSet->GoToFirstRow() == E_OK)) {
+            resultSet->GetString(0, name);
+        }
+        if (resultSet != nullptr) {
+            resultSet->Close();
+        }
+        return name;
+    }
+
+    struct FilesQuery {
+        string name;
+        string sql;
+        vector<string> args;
+    };
+
+    string GetAlbumPath(int32_t albumId)
+    {
+        return ROOT_MEDIA_DIR + "Pictures/album_" + to_string(albumId);
+    }
+
+    const vector<FilesQuery> HOT_QUERIES {
+        { "path", "SELECT " + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+            MEDIA_DATA_DB_FILE_PATH + " = ?", { GetAlbumPath(7) + "/IMG_4207.jpg" } },
+        { "parent", "SELECT " + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+            MEDIA_DATA_DB_PARENT_ID + " = ?", { "42" } },
+        { "relative_path", "SELECT " + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+            MEDIA_DATA_DB_RELATIVE_PATH + " = ?", { "Pictures/album_42/" } },
+        { "album_count", "SELECT COUNT(*) FROM " + MEDIALIBRARY_TABLE + " WHERE " + MEDIA_DATA_DB_BUCKET_ID +
+            " = ? AND " + MEDIA_DATA_DB_MEDIA_TYPE + " = ? AND " + MEDIA_DATA_DB_DATE_TRASHED + " = 0",
+            { "42", to_string(MEDIA_TYPE_IMAGE) } },
+        { "media_type_by_date", "SELECT " + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+            MEDIA_DATA_DB_MEDIA_TYPE + " = ? AND " + MEDIA_DATA_DB_DATE_TRASHED + " = 0 ORDER BY " +
+            MEDIA_DATA_DB_DATE_ADDED + " DESC LIMIT 50", { to_string(MEDIA_TYPE_VIDEO) } },
+        { "trashed", "SELECT " + MEDIA_DATA_DB_ID + " FROM " + MEDIALIBRARY_TABLE + " WHERE " +
+            MEDIA_DATA_DB_DATE_TRASHED + " > 0", {} },
+    };
+
+    void InsertFilesRows(RdbStore &store)
+    {
+        ASSERT_EQ(store.BeginTransaction(), E_OK);
+        for (int32_t i = 0; i < FILES_ROW_COUNT; i++) {
+            int32_t albumId = i % FILES_ALBUM_COUNT;
+            int32_t mediaType = (i % 4 == 0) ? MEDIA_TYPE_VIDEO : MEDIA_TYPE_IMAGE;
+            ValuesBucket values;
+            values.PutString(MEDIA_DATA_DB_FILE_PATH, GetAlbumPath(albumId) + "/IMG_" + to_string(i) + ".jpg");
+            values.PutString(MEDIA_DATA_DB_RELATIVE_PATH, "Pictures/album_" + to_string(albumId) + "/");
+            values.PutString(MEDIA_DATA_DB_NAME, "IMG_" + to_string(i) + ".jpg");
+            values.PutInt(MEDIA_DATA_DB_PARENT_ID, albumId);
+            values.PutInt(MEDIA_DATA_DB_BUCKET_ID, albumId);
+            values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, mediaType);
+            values.PutLong(MEDIA_DATA_DB_DATE_ADDED, i);
+            values.PutLong(MEDIA_DATA_DB_DATE_MODIFIED, i);
+            values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, (i % FILES_TRASH_RATIO == 0) ? i : 0);
+            int64_t rowId = 0;
+            ASSERT_EQ(store.Insert(rowId, MEDIALIBRARY_TABLE, values), E_OK);
+        }
+        ASSERT_EQ(store.Commit(), E_OK);
+    }
+
+    // First column of every row the query returns
+    vector<int64_t> RunQuery(RdbStore &store, const FilesQuery &query)
+    {
+        vector<int64_t> rows;
+        auto resultSet = store.QuerySql(query.sql, query.args);
+        EXPECT_NE(resultSet, nullptr);
+        if (resultSet == nullptr) {
+            return rows;
+        }
+        while (resultSet->GoToNextRow() == E_OK) {
+            int64_t value = 0;
+            resultSet->GetLong(0, value);
+            rows.push_back(value);
+        }
+        resultSet->Close();
+        return rows;
+    }
+
+    // What the Album view aggregated on every query before AlbumStats
+    const FilesQuery ALBUM_COUNT_GROUP_BY { "album_group_by", "SELECT " + MEDIA_DATA_DB_BUCKET_ID + ", " +
+        MEDIA_DATA_DB_MEDIA_TYPE + ", COUNT(" + MEDIA_DATA_DB_DATE_TRASHED + " = 0 OR NULL) FROM " +
+        MEDIALIBRARY_TABLE + " WHERE " + MEDIA_DATA_DB_MEDIA_TYPE + " <> " + to_string(MEDIA_TYPE_ALBUM) + " AND " +
+        MEDIA_DATA_DB_MEDIA_TYPE + " <> " + to_string(MEDIA_TYPE_FILE) + " GROUP BY " + MEDIA_DATA_DB_BUCKET_ID +
+        ", " + MEDIA_DATA_DB_MEDIA_TYPE + " ORDER BY " + MEDIA_DATA_DB_BUCKET_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE,
+        {} };
+    const FilesQuery ALBUM_COUNT_STATS { "album_stats", "SELECT " + ALBUM_STATS_DB_ALBUM_ID + ", " +
+        MEDIA_DATA_DB_MEDIA_TYPE + ", " + MEDIA_DATA_DB_COUNT + " FROM " + ALBUM_STATS_TABLE + " WHERE " +
+        ALBUM_STATS_DB_TYPE + " = " + to_string(ALBUM_STATS_TYPE_BUCKET) + " ORDER BY " + ALBUM_STATS_DB_ALBUM_ID +
+        ", " + MEDIA_DATA_DB_MEDIA_TYPE, {} };
+
+    vector<vector<int32_t>> QueryAlbumCounts(RdbStore &store, const FilesQuery &query)
+    {
+        vector<vector<int32_t>> rows;
+        auto resultSet = store.QuerySql(query.sql, query.args);
+        EXPECT_NE(resultSet, nullptr);
+        if (resultSet == nullptr) {
+            return rows;
+        }
+        while (resultSet->GoToNextRow() == E_OK) {
+            vector<int32_t> row(3, 0);
+            for (int32_t i = 0; i < static_cast<int32_t>(row.size()); i++) {
+                resultSet->GetInt(i, row[i]);
+            }
+            rows.push_back(move(row));
+        }
+        resultSet->Close();
+        return rows;
+    }
+
+    // Whether SQLite plans the query through an index rather than a scan of the table
+    bool UsesIndex(RdbStore &store, const FilesQuery &query)
+    {
+        auto resultSet = store.QuerySql("EXPLAIN QUERY PLAN " + query.sql, query.args);
+        if (resultSet == nullptr) {
+            return false;
+        }
+        bool usesIndex = false;
+        int32_t detailIndex = -1;
+        resultSet->GetColumnIndex("detail", detailIndex);
+        while ((detailIndex >= 0) && (resultSet->GoToNextRow() == E_OK)) {
+            string detail;
+            resultSet->GetString(detailIndex, detail);
+            usesIndex = usesIndex || (detail.find("INDEX") != string::npos);
+        }
+        resultSet->Close();
+        return usesIndex;
+    }
+
+    int32_t InsertAlbumRow(RdbStore &store, const string &path)
+    {
+        ValuesBucket values;
+        values.PutString(MEDIA_DATA_DB_FILE_PATH, path);
+        values.PutString(MEDIA_DATA_DB_NAME, path.substr(path.rfind('/') + 1));
+        values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, MEDIA_TYPE_ALBUM);
+        int64_t rowId = 0;
+        EXPECT_EQ(store.Insert(rowId, MEDIALIBRARY_TABLE, values), E_OK);
+        return static_cast<int32_t>(rowId);
+    }
+
+    int32_t InsertAssetRow(RdbStore &store, int32_t bucketId, MediaType mediaType, int64_t dateAdded)
+    {
+        string name = "asset_" + to_string(dateAdded) + ((mediaType == MEDIA_TYPE_VIDEO) ? ".mp4" : ".jpg");
+        ValuesBucket values;
+        values.PutString(MEDIA_DATA_DB_FILE_PATH, GetAlbumPath(bucketId) + "/" + name);
+        values.PutString(MEDIA_DATA_DB_NAME, name);
+        values.PutInt(MEDIA_DATA_DB_BUCKET_ID, bucketId);
+        values.PutInt(MEDIA_DATA_DB_PARENT_ID, bucketId);
+        values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, mediaType);
+        values.PutLong(MEDIA_DATA_DB_DATE_ADDED, dateAdded);
+        values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, 0);
+        int64_t rowId = 0;
+        EXPECT_EQ(store.Insert(rowId, MEDIALIBRARY_TABLE, values), E_OK);
+        return static_cast<int32_t>(rowId);
+    }
+
+    // bucket_id, media_type, cover_id and cover_media_type of every row of the Album view
+    vector<vector<int32_t>> QueryAlbumCovers(RdbStore &store)
+    {
+        vector<vector<int32_t>> covers;
+        auto resultSet = store.QuerySql("SELECT " + MEDIA_DATA_DB_BUCKET_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE + ", " +
+            MEDIA_DATA_DB_COVER_ID + ", " + MEDIA_DATA_DB_COVER_MEDIA_TYPE + " FROM " + ABLUM_VIEW_NAME +
+            " ORDER BY " + MEDIA_DATA_DB_BUCKET_ID + ", " + MEDIA_DATA_DB_MEDIA_TYPE);
+        EXPECT_NE(resultSet, nullptr);
+        if (resultSet == nullptr) {
+            return covers;
+        }
+        while (resultSet->GoToNextRow() == E_OK) {
+            vector<int32_t> row(4, 0);
+            for (int32_t i = 0; i < static_cast<int32_t>(row.size()); i++) {
+                resultSet->GetInt(i, row[i]);
+            }
+            covers.push_back(row);
+        }
+        resultSet->Close();
+        return covers;
+    }
+
+    // What the album lookups of the data manager answer for the albums of GetAlbumPath
+    struct AlbumLookup {
+        int32_t id;
+        int32_t lastAncestorId;
+        string displayName;
+
+        bool operator==(const AlbumLookup &other) const
+        {
+            return (id == other.id) && (lastAncestorId == other.lastAncestorId) && (displayName == other.displayName);
+        }
+    };
+
+    vector<AlbumLookup> RunAlbumLookups(const shared_ptr<RdbStore> &store)
+    {
+        vector<AlbumLookup> lookups;
+        for (int32_t i = 0; i < CACHED_ALBUM_COUNT; i++) {
+            AlbumLookup lookup;
+            lookup.id = MediaLibraryDataManagerUtils::GetParentIdFromDb(GetAlbumPath(i), store);
+            lookup.lastAncestorId =
+                MediaLibraryDataManagerUtils::GetLastAlbumExistInDb(GetAlbumPath(i) + "/a/b", store).GetAlbumId();
+            lookup.displayName = MediaLibraryDataManagerUtils::GetParentDisplayNameFromDb(lookup.id, store);
+            lookups.push_back(lookup);
+        }
+        return lookups;
+    }
+
+    vector<ValuesBucket> GetSmartAlbumMapValues(int32_t albumId)
+    {
+        vector<ValuesBucket> values;
+        for (int32_t assetId = 1; assetId <= MAP_BATCH_ASSETS; assetId++) {
+            ValuesBucket value;
+            value.PutInt(SMARTALBUMMAP_DB_ALBUM_ID, albumId);
+            value.PutInt(SMARTALBUMMAP_DB_ASSET_ID, assetId);
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    int32_t CountSmartAlbumMapRows(RdbStore &store, int32_t albumId)
+    {
+        int32_t count = 0;
+        auto resultSet = store.QuerySql("SELECT COUNT(*) FROM " + SMARTALBUM_MAP_TABLE + " WHERE " +
+            SMARTALBUMMAP_DB_ALBUM_ID + " = ?", vector<string> { to_string(albumId) });
+        EXPECT_NE(resultSet, nullptr);
+        if ((resultSet != nullptr) && (resultSet->GoToFirstRow() == E_OK)) {
+            resultSet->GetInt(0, count);
+        }
+        if (resultSet != nullptr) {
+            resultSet->Close();
+        }
+        return count;
+    }
+
+    // Query dispatch before MediaLibraryUriRouter: copies of the uri searched for every keyword in turn
+    MediaLibraryUri LegacyRoute(string uriString)
+    {
+        MediaLibraryUri route;
+        string::size_type pos = uriString.find_last_of('?');
+        if (pos != string::npos) {
+            string query = uriString.substr(pos + 1);
+            uriString = uriString.substr(0, pos);
+            vector<string> keys;
+            string::size_type start = 0;
+            for (string::size_type end = query.find('&'); end != string::npos; end = query.find('&', start)) {
+                keys.push_back(query.substr(start, end - start));
+                start = end + 1;
+            }
+            if (start != query.length()) {
+                keys.push_back(query.substr(start));
+            }
+            for (const auto &key : keys) {
+                string::size_type eq = key.find('=');
+                string name = key.substr(0, eq);
+                string value = key.substr(eq + 1);
+                if (name == MEDIA_DATA_DB_WIDTH) {
+                    route.width = stoi(value);
+                } else if (name == MEDIA_DATA_DB_HEIGHT) {
+                    route.height = stoi(value);
+                } else if (name == MEDIA_OPERN_KEYWORD) {
+                    route.isThumbnail = (value == MEDIA_DATA_DB_THUMBNAIL);
+                }
+            }
+        }
+        string tempUri = uriString.substr(MEDIALIBRARY_DATA_ABILITY_PREFIX.length());
+        pos = tempUri.find_first_of('/');
+        if ((pos != 0) && (pos != string::npos)) {
+            route.networkId = tempUri.substr(0, pos);
+        }
+        pos = uriString.find_last_of('/');
+        route.operation = uriString.substr(pos + 1);
+        if (uriString.find(MEDIA_QUERYOPRN_QUERYVOLUME) != string::npos) {
+            return route;
+        }
+        if (route.operation == MEDIA_ALBUMOPRN_QUERYALBUM) {
+            route.tableType = TYPE_ALBUM_TABLE;
+        } else if (uriString == MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM + "/" +
+            SMARTABLUMASSETS_VIEW_NAME) {
+            route.tableType = TYPE_SMARTALBUMASSETS_TABLE;
+        } else if (uriString == MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM + "/" + ASSETMAP_VIEW_NAME) {
+            route.tableType = TYPE_ASSETSMAP_TABLE;
+        } else if (uriString == MEDIALIBRARY_DATA_URI + "/" + MEDIA_DEVICE_QUERYALLDEVICE) {
+            route.tableType = TYPE_ALL_DEVICE;
+        } else if (uriString == MEDIALIBRARY_DATA_URI + "/" + MEDIA_DEVICE_QUERYACTIVEDEVICE) {
+            route.tableType = TYPE_ACTIVE_DEVICE;
+        } else {
+            route.parent = uriString.substr(0, pos);
+            route.table = route.parent.substr(route.parent.find_last_of('/') + 1);
+        }
+        return route;
+    }
+
+    const vector<string> HOT_QUERY_URIS {
+        MEDIALIBRARY_DATA_URI,
+        MEDIALIBRARY_DATA_URI + "/42?" + MEDIA_OPERN_KEYWORD + "=" + MEDIA_DATA_DB_THUMBNAIL + "&" +
+            MEDIA_DATA_DB_WIDTH + "=256&" + MEDIA_DATA_DB_HEIGHT + "=256",
+        MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM,
+        MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM + "/" + SMARTABLUMASSETS_VIEW_NAME,
+        MEDIALIBRARY_SMARTALBUM_URI + "/3",
+        MEDIALIBRARY_DATA_ABILITY_PREFIX + "test_device" + MEDIALIBRARY_DATA_URI_IDENTIFIER + "/42",
+    };
+
+    string GetPathFromResult(const shared_ptr<AbsSharedResultSet> &resultSet)
+    {
+        string path;
+        int32_t columnIndex = 0;
+        if ((resultSet != nullptr) && (resultSet->GoToFirstRow() == E_OK) &&
+            (resultSet->GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, columnIndex) == E_OK)) {
+            resultSet->GetString(columnIndex, path);
+        }
+        return path;
+    }
+
+    // Path lookup as GetPathFromDb ran it, the id concatenated into a new where clause each call
+    string LegacyPathById(RdbStore &store, const string &id)
+    {
+        AbsRdbPredicates predicates(MEDIALIBRARY_TABLE);
+        predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + id);
+        predicates.SetWhereArgs(vector<string> {});
+        return GetPathFromResult(store.Query(predicates, vector<string> { MEDIA_DATA_DB_FILE_PATH }));
+    }
+
+    struct ContentionResult {
+        int32_t queries = 0;
+        int32_t failed = 0;
+    };
+
+    string GetJournalMode(RdbStore &store)
+    {
+        string journalMode;
+        auto resultSet = store.QuerySql("PRAGMA journal_mode", vector<string> {});
+        if ((resultSet != nullptr) && (resultSet->GoToFirstRow() == E_OK)) {
+            resultSet->GetString(0, journalMode);
+            resultSet->Close();
+        }
+        return journalMode;
+    }
+
+    // Pages through the photo grid, newest first, until the scanner stops writing
+    void RunGridReader(RdbStore &store, const atomic<bool> &stop, ContentionResult &result)
+    {
+        const string sql = "SELECT " + MEDIA_DATA_DB_ID + ", " + MEDIA_DATA_DB_FILE_PATH + ", " + MEDIA_DATA_DB_NAME +
+            ", " + MEDIA_DATA_DB_MEDIA_TYPE + ", " + MEDIA_DATA_DB_DATE_ADDED + " FROM " + MEDIALIBRARY_TABLE +
+            " WHERE " + MEDIA_DATA_DB_MEDIA_TYPE + " IN (?, ?) AND " + MEDIA_DATA_DB_DATE_TRASHED + " = 0 ORDER BY " +
+            MEDIA_DATA_DB_DATE_ADDED + " DESC LIMIT " + to_string(GRID_PAGE_ROWS) + " OFFSET ?";
+        for (int32_t page = 0; !stop.load(); page = (page + 1) % GRID_PAGES) {
+            auto resultSet = store.QuerySql(sql, vector<string> { to_string(MEDIA_TYPE_IMAGE),
+                to_string(MEDIA_TYPE_VIDEO), to_string(page * GRID_PAGE_ROWS) });
+            int32_t rowCount = 0;
+            if ((resultSet == nullptr) || (resultSet->GetRowCount(rowCount) != E_OK) || (rowCount != GRID_PAGE_ROWS)) {
+                result.failed++;
+            }
+            if (resultSet != nullptr) {
+                resultSet->Close();
+            }
+            result.queries++;
+        }
+    }
+
+    // Commits new files in scanner sized transactions, returns the rows committed
+    int32_t InsertScanBatches(RdbStore &store)
+    {
+        int32_t inserted = 0;
+        for (int32_t batch = 0; batch < SCAN_BATCHES; batch++) {
+            if (store.BeginTransaction() != E_OK) {
+                continue;
+            }
+            bool succeeded = true;
+            for (int32_t i = 0; (i < SCAN_BATCH_ASSETS) && succeeded; i++) {
+                int32_t dateAdded = FILES_ROW_COUNT + batch * SCAN_BATCH_ASSETS + i;
+                ValuesBucket values;
+                values.PutString(MEDIA_DATA_DB_FILE_PATH, ROOT_MEDIA_DIR + "Pictures/scan_" + to_string(batch) +
+                    "/IMG_" + to_string(i) + ".jpg");
+                values.PutString(MEDIA_DATA_DB_RELATIVE_PATH, "Pictures/scan_" + to_string(batch) + "/");
+                values.PutString(MEDIA_DATA_DB_NAME, "IMG_" + to_string(i) + ".jpg");
+                values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, MEDIA_TYPE_IMAGE);
+                values.PutLong(MEDIA_DATA_DB_DATE_ADDED, dateAdded);
+                values.PutLong(MEDIA_DATA_DB_DATE_MODIFIED, dateAdded);
+                values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, 0);
+                int64_t rowId = 0;
+                succeeded = (store.Insert(rowId, MEDIALIBRARY_TABLE, values) == E_OK);
+            }
+            if (succeeded && (store.Commit() == E_OK)) {
+                inserted += SCAN_BATCH_ASSETS;
+            } else {
+                store.RollBack();
+            }
+        }
+        return inserted;
+    }
+
+    Metadata GetTestMetadata(const string &name, int32_t fileId)
+    {
+        Metadata metadata;
+        metadata.SetFileId(fileId);
+        metadata.SetFilePath(ROOT_MEDIA_DIR + "Pictures/" + name);
+        metadata.SetRelativePath(string("Pictures/"));
+        metadata.SetFileName(name);
+        metadata.SetFileMimeType(string("image/jpeg"));
+        metadata.SetFileMediaType(MEDIA_TYPE_IMAGE);
+        return metadata;
+    }
+} // namespace
+
+int32_t InitVersionCallback::OnCreate(RdbStore &rdbStore)
+{
+    int32_t errCode = rdbStore.ExecuteSql(CREATE_MEDIA_TABLE);
+    if (errCode == E_OK) {
+        errCode = rdbStore.ExecuteSql(CREATE_SMARTALBUM_TABLE);
+    }
+    if (errCode == E_OK) {
+        errCode = rdbStore.ExecuteSql(CREATE_SMARTALBUMMAP_TABLE);
+    }
+    return errCode;
+}
+
+int32_t InitVersionCallback::OnUpgrade(RdbStore &rdbStore, int32_t oldVersion, int32_t newVersion)
+{
+    return E_OK;
+}
+
+void MediaDataAbilityRdbUnitTest::SetUpTestCase(void)
+{
+    RdbHelper::DeleteRdbStore(FILES_DB_PATH);
+    RdbStoreConfig config(FILES_DB_PATH);
+    InitVersionCallback callback;
+    int32_t errCode = E_OK;
+    g_filesStore = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION_INIT, callback, errCode);
+    ASSERT_NE(g_filesStore, nullptr);
+    InsertFilesRows(*g_filesStore);
+}
+
+void MediaDataAbilityRdbUnitTest::TearDownTestCase(void)
+{
+    g_filesStore = nullptr;
+    RdbHelper::DeleteRdbStore(FILES_DB_PATH);
+}
+
+void MediaDataAbilityRdbUnitTest::SetUp(void) {}
+
+// Cases stop at their first failed assertion, undo what they may have left behind here
+void MediaDataAbilityRdbUnitTest::TearDown(void)
+{
+    RestoreDataManagerStore();
+    RdbHelper::DeleteRdbStore(TEST_DB_PATH);
+}
+
+/*
+ * Feature: MediaScannerDb
+ * Function: BatchUpsertMetadata
+ * SubFunction: NA
+ * FunctionPoints: A scanner batch is written in one transaction
+ * EnvConditions: NA
+ * CaseDescription: Write a batch inserting a file, updating a file and writing back a file deleted meanwhile
+ *                  while the store rejects its last row, check nothing of the batch is kept, then write it
+ *                  again once the store accepts it and check every row lands
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_BatchUpsertMetadata_Test_001, TestSize.Level1)
+{
+    shared_ptr<RdbStore> store = OpenTestStore(TEST_DB_PATH);
+    ASSERT_NE(store, nullptr);
+    ASSERT_EQ(SwapDataManagerStore(store), DATA_ABILITY_SUCCESS);
+    auto scannerDb = MediaScannerDb::GetDatabaseInstance();
+
+    vector<string> uris = scannerDb->BatchUpsertMetadata({ GetTestMetadata("updated.jpg", FILE_ID_DEFAULT),
+        GetTestMetadata("deleted.jpg", FILE_ID_DEFAULT) });
+    ASSERT_EQ(uris.size(), 2u);
+    int32_t updatedId = scannerDb->GetIdFromUri(uris[0]);
+    int32_t deletedId = scannerDb->GetIdFromUri(uris[1]);
+    ASSERT_GT(updatedId, 0);
+    ASSERT_GT(deletedId, 0);
+    int32_t deletedRows = 0;
+    ASSERT_EQ(store->Delete(deletedRows, MEDIALIBRARY_TABLE, MEDIA_DATA_DB_ID + " = ?",
+        vector<string> { to_string(deletedId) }), E_OK);
+    int32_t filesBefore = CountFiles(*store);
+
+    vector<Metadata> batch { GetTestMetadata("inserted.jpg", FILE_ID_DEFAULT),
+        GetTestMetadata("updated_renamed.jpg", updatedId), GetTestMetadata("deleted.jpg", deletedId),
+        GetTestMetadata("rejected.jpg", FILE_ID_DEFAULT) };
+    ASSERT_EQ(store->ExecuteSql("CREATE TEMP TRIGGER reject_test_file BEFORE INSERT ON " + MEDIALIBRARY_TABLE +
+        " WHEN NEW." + MEDIA_DATA_DB_NAME + " = 'rejected.jpg' BEGIN SELECT RAISE(ABORT, 'rejected'); END"), E_OK);
+    uris = scannerDb->BatchUpsertMetadata(batch);
+    ASSERT_EQ(uris.size(), batch.size());
+    for (const auto &uri : uris) {
+        EXPECT_TRUE(uri.empty());
+    }
+    EXPECT_EQ(CountFiles(*store), filesBefore);
+    EXPECT_EQ(QueryFileName(*store, updatedId), "updated.jpg");
+
+    ASSERT_EQ(store->ExecuteSql("DROP TRIGGER reject_test_file"), E_OK);
+    uris = scannerDb->BatchUpsertMetadata(batch);
+    ASSERT_EQ(uris.size(), batch.size());
+    for (const auto &uri : uris) {
+        EXPECT_FALSE(uri.empty());
+    }
+    EXPECT_EQ(CountFiles(*store), filesBefore + 3);
+    EXPECT_EQ(scannerDb->GetIdFromUri(uris[1]), updatedId);
+    EXPECT_EQ(QueryFileName(*store, updatedId), "updated_renamed.jpg");
+    int32_t rewrittenId = scannerDb->GetIdFromUri(uris[2]);
+    EXPECT_GT(rewrittenId, 0);
+    EXPECT_EQ(QueryFileName(*store, rewrittenId), "deleted.jpg");
+}
+
+/*
+ * Feature: MediaLibraryDataCallBack
+ * Function: OnUpgrade
+ * SubFunction: NA
+ * FunctionPoints: Files indexes added by the versioned upgrade
+ * EnvConditions: NA
+ * CaseDescription: Run the hot Files queries before and after upgrading from MEDIA_RDB_VERSION_INIT, check
+ *                  they scan the table before and go through an index after, and return the same rows
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_FilesIndex_Test_001, TestSize.Level1)
+{
+    ASSERT_NE(g_filesStore, nullptr);
+    vector<vector<int64_t>> before;
+    for (const auto &query : HOT_QUERIES) {
+        EXPECT_FALSE(UsesIndex(*g_filesStore, query)) << query.name;
+        before.push_back(RunQuery(*g_filesStore, query));
+        EXPECT_FALSE(before.back().empty()) << query.name;
+    }
+
+    MediaLibraryDataCallBack callback;
+    EXPECT_EQ(callback.OnUpgrade(*g_filesStore, MEDIA_RDB_VERSION_INIT, MEDIA_RDB_VERSION), E_OK);
+    // Upgrade steps must be re-runnable without error
+    EXPECT_EQ(callback.OnUpgrade(*g_filesStore, MEDIA_RDB_VERSION_INIT, MEDIA_RDB_VERSION_FILES_INDEX), E_OK);
+
+    auto indexes = g_filesStore->QuerySql("SELECT name FROM sqlite_master WHERE type = 'index' AND tbl_name = ?",
+        vector<string> { MEDIALIBRARY_TABLE });
+    ASSERT_NE(indexes, nullptr);
+    int32_t indexCount = 0;
+    EXPECT_EQ(indexes->GetRowCount(indexCount), E_OK);
+    EXPECT_GE(indexCount, 8);
+    indexes->Close();
+
+    for (size_t i = 0; i < HOT_QUERIES.size(); i++) {
+        EXPECT_TRUE(UsesIndex(*g_filesStore, HOT_QUERIES[i])) << HOT_QUERIES[i].name;
+        EXPECT_EQ(RunQuery(*g_filesStore, HOT_QUERIES[i]), before[i]) << HOT_QUERIES[i].name;
+    }
+}
+
+/*
+ * Feature: MediaLibraryDataManagerUtils
+ * Function: GetLastAlbumExistInDb
+ * SubFunction: NA
+ * FunctionPoints: Deepest album among the ancestors of a path, matched on whole path components
+ * EnvConditions: NA
+ * CaseDescription: On a store the album cache does not track, look up paths below, at and beside a chain of
+ *                  albums next to an album whose name extends one of them, check the deepest ancestor is
+ *                  returned and the lookup of the ancestor paths goes through an index
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_GetLastAlbumExistInDb_Test_001, TestSize.Level1)
+{
+    shared_ptr<RdbStore> store = OpenTestStore(TEST_DB_PATH);
+    ASSERT_NE(store, nullptr);
+    const string pictures = ROOT_MEDIA_DIR + "Pictures";
+    const string album = pictures + "/a";
+    const string subAlbum = album + "/b";
+    const string sibling = album + "/bc";
+    int32_t picturesId = InsertAlbumRow(*store, pictures);
+    int32_t albumId = InsertAlbumRow(*store, album);
+    int32_t subAlbumId = InsertAlbumRow(*store, subAlbum);
+    int32_t siblingId = InsertAlbumRow(*store, sibling);
+    ASSERT_GT(picturesId, 0);
+    ASSERT_GT(albumId, 0);
+    ASSERT_GT(subAlbumId, 0);
+    ASSERT_GT(siblingId, 0);
+
+    struct LookupCase {
+        string path;
+        int32_t id;
+        string albumPath;
+    };
+    vector<LookupCase> lookupCases = {
+        { subAlbum + "/c/d", subAlbumId, subAlbum },
+        { subAlbum + "/", subAlbumId, subAlbum },
+        { sibling, siblingId, sibling },
+        // bc is no ancestor of bcd
+        { album + "/bcd", albumId, album },
+        { pictures + "/other", picturesId, pictures },
+        { ROOT_MEDIA_DIR + "Movies/x", 0, ROOT_MEDIA_DIR },
+        { ROOT_MEDIA_DIR, 0, ROOT_MEDIA_DIR },
+    };
+    for (const auto &lookupCase : lookupCases) {
+        NativeAlbumAsset parent = MediaLibraryDataManagerUtils::GetLastAlbumExistInDb(lookupCase.path, store);
+        EXPECT_EQ(parent.GetAlbumId(), lookupCase.id) << lookupCase.path;
+        EXPECT_EQ(parent.GetAlbumPath(), lookupCase.albumPath) << lookupCase.path;
+    }
+
+    FilesQuery ancestors { "ancestors", "SELECT " + MEDIA_DATA_DB_FILE_PATH + "," + MEDIA_DATA_DB_ID + " FROM " +
+        MEDIALIBRARY_TABLE + " WHERE " + MEDIA_DATA_DB_FILE_PATH + " IN (?,?,?)", { pictures, album, subAlbum } };
+    EXPECT_TRUE(UsesIndex(*store, ancestors));
+    EXPECT_EQ(RunQuery(*store, ancestors).size(), 3u);
+}
+
+/*
+ * Feature: MediaLibraryAlbumCache
+ * Function: GetAlbum, GetLastAncestor
+ * SubFunction: NA
+ * FunctionPoints: Album resolution served from the in-memory album cache
+ * EnvConditions: NA
+ * CaseDescription: Resolve album ids, names and deepest parent albums against the database and then through
+ *                  the cache, check both agree and that the cache answers without the database, and that erase
+ *                  and invalidate keep it coherent
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_AlbumCache_Test_001, TestSize.Level1)
+{
+    shared_ptr<RdbStore> store = OpenTestStore(TEST_DB_PATH);
+    ASSERT_NE(store, nullptr);
+    for (int32_t i = 0; i < CACHED_ALBUM_COUNT; i++) {
+        ASSERT_GT(InsertAlbumRow(*store, GetAlbumPath(i)), 0);
+    }
+    auto albumCache = MediaLibraryAlbumCache::GetInstance();
+    albumCache->Reset();
+    AlbumCacheEntry album;
+    ASSERT_EQ(albumCache->GetAlbum(GetAlbumPath(7), album, store), AlbumCacheResult::UNAVAILABLE);
+    vector<AlbumLookup> fromDb = RunAlbumLookups(store);
+    for (const auto &lookup : fromDb) {
+        EXPECT_GT(lookup.id, 0);
+        EXPECT_EQ(lookup.lastAncestorId, lookup.id);
+        EXPECT_FALSE(lookup.displayName.empty());
+    }
+
+    // Serving the store loads the cache
+    ASSERT_EQ(SwapDataManagerStore(store), DATA_ABILITY_SUCCESS);
+    ASSERT_EQ(albumCache->GetAlbum(GetAlbumPath(7), album, store), AlbumCacheResult::FOUND);
+    EXPECT_TRUE(RunAlbumLookups(store) == fromDb);
+
+    // A row removed behind the cache's back is still answered, the lookups never reach the database
+    int32_t deletedRows = 0;
+    ASSERT_EQ(store->Delete(deletedRows, MEDIALIBRARY_TABLE, MEDIA_DATA_DB_FILE_PATH + " = ?",
+        vector<string> { GetAlbumPath(3) }), E_OK);
+    ASSERT_EQ(deletedRows, 1);
+    EXPECT_EQ(MediaLibraryDataManagerUtils::GetParentIdFromDb(GetAlbumPath(3), store), fromDb[3].id);
+    albumCache->Invalidate(store);
+    EXPECT_EQ(albumCache->GetAlbum(GetAlbumPath(3), album, store), AlbumCacheResult::NOT_FOUND);
+
+    ASSERT_EQ(albumCache->GetAlbum(GetAlbumPath(7) + "/", album, store), AlbumCacheResult::FOUND);
+    int32_t albumId = album.id;
+    albumCache->Erase(GetAlbumPath(7), store);
+    EXPECT_EQ(albumCache->GetAlbum(GetAlbumPath(7), album, store), AlbumCacheResult::NOT_FOUND);
+    EXPECT_EQ(albumCache->GetAlbum(albumId, album, store), AlbumCacheResult::NOT_FOUND);
+
+    // The row is still in the database, a reload brings it back
+    albumCache->Invalidate(store);
+    EXPECT_EQ(albumCache->GetAlbum(GetAlbumPath(7), album, store), AlbumCacheResult::FOUND);
+    EXPECT_EQ(album.id, albumId);
+
+    albumCache->Reset();
+    EXPECT_EQ(albumCache->GetAlbum(GetAlbumPath(7), album, store), AlbumCacheResult::UNAVAILABLE);
+}
+
+/*
+ * Feature: Album view
+ * Function: CREATE_ABLUM_VIEW
+ * SubFunction: NA
+ * FunctionPoints: Every album row carries the id and media type of its cover
+ * EnvConditions: NA
+ * CaseDescription: Add images and a video to two albums, check each album row names the latest added asset
+ *                  of its media type as cover, then trash the cover and delete the video and check the cover
+ *                  moves to the next latest asset and the empty row goes away
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_AlbumCover_Test_001, TestSize.Level1)
+{
+    shared_ptr<RdbStore> store = OpenTestStore(TEST_DB_PATH);
+    ASSERT_NE(store, nullptr);
+    int32_t albumA = InsertAlbumRow(*store, GetAlbumPath(1));
+    int32_t albumB = InsertAlbumRow(*store, GetAlbumPath(2));
+    ASSERT_GT(albumA, 0);
+    ASSERT_GT(albumB, 0);
+    int32_t olderImage = InsertAssetRow(*store, albumA, MEDIA_TYPE_IMAGE, 10);
+    int32_t video = InsertAssetRow(*store, albumA, MEDIA_TYPE_VIDEO, 20);
+    int32_t latestImage = InsertAssetRow(*store, albumA, MEDIA_TYPE_IMAGE, 30);
+    int32_t otherImage = InsertAssetRow(*store, albumB, MEDIA_TYPE_IMAGE, 40);
+
+    vector<vector<int32_t>> expected = {
+        { albumA, MEDIA_TYPE_IMAGE, latestImage, MEDIA_TYPE_IMAGE },
+        { albumA, MEDIA_TYPE_VIDEO, video, MEDIA_TYPE_VIDEO },
+        { albumB, MEDIA_TYPE_IMAGE, otherImage, MEDIA_TYPE_IMAGE },
+    };
+    EXPECT_EQ(QueryAlbumCovers(*store), expected);
+
+    int32_t changedRows = 0;
+    ValuesBucket values;
+    values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, 1);
+    ASSERT_EQ(store->Update(changedRows, MEDIALIBRARY_TABLE, values, MEDIA_DATA_DB_ID + " = ?",
+        vector<string> { to_string(latestImage) }), E_OK);
+    ASSERT_EQ(changedRows, 1);
+    int32_t deletedRows = 0;
+    ASSERT_EQ(store->Delete(deletedRows, MEDIALIBRARY_TABLE, MEDIA_DATA_DB_ID + " = ?",
+        vector<string> { to_string(video) }), E_OK);
+    ASSERT_EQ(deletedRows, 1);
+    expected = {
+        { albumA, MEDIA_TYPE_IMAGE, olderImage, MEDIA_TYPE_IMAGE },
+        { albumB, MEDIA_TYPE_IMAGE, otherImage, MEDIA_TYPE_IMAGE },
+    };
+    EXPECT_EQ(QueryAlbumCovers(*store), expected);
+}
+
+/*
+ * Feature: MediaLibraryAlbumStats
+ * Function: GetRebuildSqls, GetCreateSqls, GetRecreateTriggerSqls
+ * SubFunction: NA
+ * FunctionPoints: Album counts read from AlbumStats instead of grouping Files
+ * EnvConditions: NA
+ * CaseDescription: Upgrade a filled store, check the maintained counts equal the GROUP BY over Files and are
+ *                  read through the AlbumStats key, check the update triggers only fire on changed values, then
+ *                  trash, restore and delete files and check the counts follow
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_AlbumStats_Test_001, TestSize.Level1)
+{
+    RdbHelper::DeleteRdbStore(TEST_DB_PATH);
+    RdbStoreConfig config(TEST_DB_PATH);
+    InitVersionCallback initCallback;
+    int32_t errCode = E_OK;
+    shared_ptr<RdbStore> store = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION_INIT, initCallback, errCode);
+    ASSERT_NE(store, nullptr);
+    InsertFilesRows(*store);
+    MediaLibraryDataCallBack callback;
+    ASSERT_EQ(callback.OnUpgrade(*store, MEDIA_RDB_VERSION_INIT, MEDIA_RDB_VERSION_ALBUM_STATS_TRIGGERS), E_OK);
+    vector<vector<int32_t>> counts = QueryAlbumCounts(*store, ALBUM_COUNT_GROUP_BY);
+    EXPECT_EQ(counts.size(), static_cast<size_t>(FILES_ALBUM_COUNT));
+    EXPECT_EQ(QueryAlbumCounts(*store, ALBUM_COUNT_STATS), counts);
+    EXPECT_TRUE(UsesIndex(*store, ALBUM_COUNT_STATS));
+    for (const string &trigger : { "album_stats_files_update", "album_stats_map_update" }) {
+        auto resultSet = store->QuerySql("SELECT sql FROM sqlite_master WHERE type = 'trigger' AND name = ?",
+            vector<string> { trigger });
+        ASSERT_NE(resultSet, nullptr);
+        ASSERT_EQ(resultSet->GoToFirstRow(), E_OK);
+        string sql;
+        EXPECT_EQ(resultSet->GetString(0, sql), E_OK);
+        EXPECT_NE(sql.find(" WHEN "), string::npos) << trigger;
+        resultSet->Close();
+    }
+
+    int32_t changedRows = 0;
+    ValuesBucket values;
+    values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, 1);
+    vector<string> whereArgs { "42" };
+    EXPECT_EQ(store->Update(changedRows, MEDIALIBRARY_TABLE, values, MEDIA_DATA_DB_BUCKET_ID + " = ?", whereArgs),
+        E_OK);
+    EXPECT_GT(changedRows, 0);
+    EXPECT_EQ(QueryAlbumCounts(*store, ALBUM_COUNT_STATS), QueryAlbumCounts(*store, ALBUM_COUNT_GROUP_BY));
+
+    values.Clear();
+    values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, 0);
+    EXPECT_EQ(store->Update(changedRows, MEDIALIBRARY_TABLE, values, MEDIA_DATA_DB_BUCKET_ID + " = ?", whereArgs),
+        E_OK);
+    int32_t deletedRows = 0;
+    whereArgs = { "43" };
+    EXPECT_EQ(store->Delete(deletedRows, MEDIALIBRARY_TABLE, MEDIA_DATA_DB_BUCKET_ID + " = ?", whereArgs), E_OK);
+    EXPECT_GT(deletedRows, 0);
+    EXPECT_EQ(QueryAlbumCounts(*store, ALBUM_COUNT_STATS), QueryAlbumCounts(*store, ALBUM_COUNT_GROUP_BY));
+}
+
+/*
+ * Feature: MediaLibrarySyncScheduler
+ * Function: MarkDirty
+ * SubFunction: NA
+ * FunctionPoints: Distributed pushes coalesced per table and window
+ * EnvConditions: NA
+ * CaseDescription: Mark Files dirty 100 times within one window against a push function counting the
+ *                  RdbStore::Sync calls per table, check a single push is issued and the rest coalesced,
+ *                  then check Flush and Stop push the pending tables at once
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_SyncScheduler_Test_001, TestSize.Level1)
+{
+    mutex syncLock;
+    map<string, int32_t> syncCalls;
+    MediaLibrarySyncScheduler scheduler;
+    scheduler.Start([&syncLock, &syncCalls](const string &tableName) {
+        lock_guard<mutex> lock(syncLock);
+        syncCalls[tableName]++;
+        return tableName != SMARTALBUM_MAP_TABLE;
+    }, SYNC_WINDOW);
+    auto getSyncCalls = [&syncLock, &syncCalls](const string &tableName) {
+        lock_guard<mutex> lock(syncLock);
+        return syncCalls[tableName];
+    };
+
+    for (int32_t i = 0; i < DIRTY_MARK_COUNT; i++) {
+        scheduler.MarkDirty(MEDIALIBRARY_TABLE);
+    }
+    EXPECT_EQ(getSyncCalls(MEDIALIBRARY_TABLE), 0);
+    auto deadline = chrono::steady_clock::now() + SYNC_WINDOW * 20;
+    while ((getSyncCalls(MEDIALIBRARY_TABLE) == 0) && (chrono::steady_clock::now() < deadline)) {
+        this_thread::sleep_for(SYNC_WINDOW / 10);
+    }
+    this_thread::sleep_for(SYNC_WINDOW * 2);
+    EXPECT_EQ(getSyncCalls(MEDIALIBRARY_TABLE), 1);
+    SyncPushCounters counters = scheduler.GetCounters();
+    EXPECT_EQ(counters.requested, static_cast<uint64_t>(DIRTY_MARK_COUNT));
+    EXPECT_EQ(counters.pushed, 1u);
+    EXPECT_EQ(counters.coalesced, static_cast<uint64_t>(DIRTY_MARK_COUNT - 1));
+
+    scheduler.MarkDirty(MEDIALIBRARY_TABLE);
+    scheduler.MarkDirty(SMARTALBUM_MAP_TABLE);
+    scheduler.Flush();
+    EXPECT_EQ(getSyncCalls(MEDIALIBRARY_TABLE), 2);
+    EXPECT_EQ(getSyncCalls(SMARTALBUM_MAP_TABLE), 1);
+    counters = scheduler.GetCounters();
+    EXPECT_EQ(counters.pushed, 3u);
+    EXPECT_EQ(counters.failed, 1u);
+
+    scheduler.MarkDirty(SMARTALBUM_TABLE);
+    scheduler.Stop();
+    EXPECT_EQ(getSyncCalls(SMARTALBUM_TABLE), 1);
+    scheduler.MarkDirty(SMARTALBUM_TABLE);
+    EXPECT_EQ(getSyncCalls(SMARTALBUM_TABLE), 1);
+    EXPECT_EQ(scheduler.GetCounters().pushed, 4u);
+}
+
+/*
+ * Feature: MediaLibraryPullCache
+ * Function: Refresh
+ * SubFunction: NA
+ * FunctionPoints: Remote queries answered at once while stale tables are pulled in the background
+ * EnvConditions: NA
+ * CaseDescription: Refresh two tables of one device and a table of another against a slow pull function,
+ *                  check Refresh reports them stale while pulling, repeated calls are coalesced, a device never
+ *                  has two pulls running and the pulled tables are fresh afterwards
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_PullCache_Test_001, TestSize.Level1)
+{
+    const string deviceA = "test_device_a";
+    const string deviceB = "test_device_b";
+    mutex pullLock;
+    map<string, int32_t> runningPulls;
+    map<string, int32_t> maxRunningPulls;
+    MediaLibraryPullCache pullCache;
+    pullCache.Start([&](const string &deviceId, const string &tableName) {
+        {
+            lock_guard<mutex> lock(pullLock);
+            runningPulls[deviceId]++;
+            maxRunningPulls[deviceId] = max(maxRunningPulls[deviceId], runningPulls[deviceId]);
+        }
+        this_thread::sleep_for(SYNC_WINDOW);
+        lock_guard<mutex> lock(pullLock);
+        runningPulls[deviceId]--;
+        return true;
+    }, SYNC_WINDOW * 50, 1, 3);
+
+    for (int32_t i = 0; i < DIRTY_MARK_COUNT; i++) {
+        EXPECT_FALSE(pullCache.Refresh(deviceA, MEDIALIBRARY_TABLE));
+        EXPECT_FALSE(pullCache.Refresh(deviceA, SMARTALBUM_TABLE));
+        EXPECT_FALSE(pullCache.Refresh(deviceB, MEDIALIBRARY_TABLE));
+    }
+
+    // Pulls of deviceA run one after the other, deviceB goes alongside
+    auto deadline = chrono::steady_clock::now() + SYNC_WINDOW * 20;
+    while ((pullCache.GetCounters().pulled < 3u) && (chrono::steady_clock::now() < deadline)) {
+        this_thread::sleep_for(SYNC_WINDOW / 10);
+    }
+    this_thread::sleep_for(SYNC_WINDOW * 2);
+    EXPECT_TRUE(pullCache.Refresh(deviceA, MEDIALIBRARY_TABLE));
+    EXPECT_TRUE(pullCache.Refresh(deviceA, SMARTALBUM_TABLE));
+    EXPECT_TRUE(pullCache.Refresh(deviceB, MEDIALIBRARY_TABLE));
+    {
+        lock_guard<mutex> lock(pullLock);
+        EXPECT_EQ(maxRunningPulls[deviceA], 1);
+        EXPECT_EQ(maxRunningPulls[deviceB], 1);
+    }
+    PullCacheCounters counters = pullCache.GetCounters();
+    EXPECT_EQ(counters.pulled, 3u);
+    EXPECT_EQ(counters.coalesced, static_cast<uint64_t>(DIRTY_MARK_COUNT * 3 - 3));
+    EXPECT_EQ(counters.fresh, 3u);
+    EXPECT_EQ(counters.failed, 0u);
+
+    pullCache.Invalidate(deviceB);
+    EXPECT_FALSE(pullCache.Refresh(deviceB, MEDIALIBRARY_TABLE));
+    pullCache.Stop();
+}
+
+/*
+ * Feature: MediaLibrarySmartAlbumMapOperations
+ * Function: HandleBatchSmartAlbumMapOperations
+ * SubFunction: NA
+ * FunctionPoints: Map rows of many assets added and removed in one transaction
+ * EnvConditions: NA
+ * CaseDescription: Add 500 assets to one smart album row by row and to another in one batch, check the batch
+ *                  writes the same rows, remove them with one statement, check a batch mixing albums is
+ *                  rejected without writing anything
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_SmartAlbumMap_Test_001, TestSize.Level1)
+{
+    shared_ptr<RdbStore> store = OpenTestStore(TEST_DB_PATH);
+    ASSERT_NE(store, nullptr);
+    const int32_t rowAlbumId = 1;
+    const int32_t batchAlbumId = 2;
+    MediaLibrarySmartAlbumMapOperations smartAlbumMapOprn;
+
+    for (const auto &value : GetSmartAlbumMapValues(rowAlbumId)) {
+        EXPECT_GT(smartAlbumMapOprn.HandleSmartAlbumMapOperations(MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM, value,
+            store), 0);
+    }
+    EXPECT_EQ(smartAlbumMapOprn.HandleBatchSmartAlbumMapOperations(MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM,
+        GetSmartAlbumMapValues(batchAlbumId), store), MAP_BATCH_ASSETS);
+    EXPECT_EQ(CountSmartAlbumMapRows(*store, rowAlbumId), MAP_BATCH_ASSETS);
+    EXPECT_EQ(CountSmartAlbumMapRows(*store, batchAlbumId), MAP_BATCH_ASSETS);
+
+    EXPECT_EQ(smartAlbumMapOprn.HandleBatchSmartAlbumMapOperations(MEDIA_SMARTALBUMMAPOPRN_REMOVESMARTALBUM,
+        GetSmartAlbumMapValues(batchAlbumId), store), MAP_BATCH_ASSETS);
+    EXPECT_EQ(CountSmartAlbumMapRows(*store, batchAlbumId), 0);
+    EXPECT_EQ(CountSmartAlbumMapRows(*store, rowAlbumId), MAP_BATCH_ASSETS);
+
+    vector<ValuesBucket> mixed = GetSmartAlbumMapValues(batchAlbumId);
+    mixed.back().PutInt(SMARTALBUMMAP_DB_ALBUM_ID, rowAlbumId);
+    EXPECT_EQ(smartAlbumMapOprn.HandleBatchSmartAlbumMapOperations(MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM, mixed,
+        store), DATA_ABILITY_FAIL);
+    EXPECT_EQ(CountSmartAlbumMapRows(*store, batchAlbumId), 0);
+}
+
+/*
+ * Feature: MediaLibraryUriRouter
+ * Function: Parse
+ * SubFunction: NA
+ * FunctionPoints: Query dispatch on a uri parsed once against precompiled segment tables
+ * EnvConditions: NA
+ * CaseDescription: Route the hot query uris with the router and with the former keyword scans, check both
+ *                  resolve the same table, row, device and thumbnail size
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_UriRouter_Test_001, TestSize.Level1)
+{
+    for (const auto &uri : HOT_QUERY_URIS) {
+        MediaLibraryUri route = MediaLibraryUriRouter::Parse(uri);
+        MediaLibraryUri legacy = LegacyRoute(uri);
+        EXPECT_EQ(route.tableType, legacy.tableType) << uri;
+        EXPECT_EQ(route.operation, legacy.operation) << uri;
+        EXPECT_EQ(route.networkId, legacy.networkId) << uri;
+        EXPECT_EQ(route.isThumbnail, legacy.isThumbnail) << uri;
+        if (route.tableType == TYPE_DATA) {
+            EXPECT_EQ(route.table, legacy.table) << uri;
+        }
+        if (route.isThumbnail) {
+            EXPECT_EQ(route.width, legacy.width);
+            EXPECT_EQ(route.height, legacy.height);
+        }
+    }
+    EXPECT_EQ(MediaLibraryUriRouter::Parse(MEDIALIBRARY_DATA_URI + "/" + MEDIA_SMARTALBUMMAPOPRN + "/" +
+        MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM).group, UriOprnGroup::SMARTALBUMMAP);
+    EXPECT_FALSE(MediaLibraryUriRouter::Parse(MEDIALIBRARY_DATA_URI + "/42?" + MEDIA_OPERN_KEYWORD + "=" +
+        MEDIA_DATA_DB_THUMBNAIL + "&" + MEDIA_DATA_DB_WIDTH + "=0&" + MEDIA_DATA_DB_HEIGHT + "=256").isThumbnail);
+}
+
+/*
+ * Feature: MediaLibraryUriRouter
+ * Function: Parse, Insert
+ * SubFunction: NA
+ * FunctionPoints: Operation uris of no known group refused instead of written to Files
+ * EnvConditions: NA
+ * CaseDescription: Route an operation uri naming an unknown operation group, check it gets the UNKNOWN group
+ *                  and that inserting through it fails without adding a Files row
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_UriRouter_Test_002, TestSize.Level1)
+{
+    const string bogusUri = MEDIALIBRARY_DATA_URI + "/bogus_" + MEDIA_OPERN_KEYWORD + "/" +
+        MEDIA_FILEOPRN_CREATEASSET;
+    MediaLibraryUri route = MediaLibraryUriRouter::Parse(bogusUri);
+    EXPECT_EQ(route.group, UriOprnGroup::UNKNOWN);
+    EXPECT_TRUE(route.IsOprnUri());
+    EXPECT_EQ(MediaLibraryUriRouter::Parse(MEDIALIBRARY_DATA_URI).group, UriOprnGroup::NONE);
+
+    shared_ptr<RdbStore> store = OpenTestStore(TEST_DB_PATH);
+    ASSERT_NE(store, nullptr);
+    ASSERT_EQ(SwapDataManagerStore(store), DATA_ABILITY_SUCCESS);
+    auto countFiles = [&store] {
+        int32_t count = 0;
+        auto resultSet = store->QuerySql("SELECT COUNT(*) FROM " + MEDIALIBRARY_TABLE, vector<string> {});
+        if ((resultSet != nullptr) && (resultSet->GoToFirstRow() == E_OK)) {
+            resultSet->GetInt(0, count);
+            resultSet->Close();
+        }
+        return count;
+    };
+    int32_t before = countFiles();
+    DataShare::DataShareValuesBucket values;
+    values.PutString(MEDIA_DATA_DB_NAME, "bogus.jpg");
+    values.PutString(MEDIA_DATA_DB_RELATIVE_PATH, "Pictures/");
+    values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, MEDIA_TYPE_IMAGE);
+    Uri uri(bogusUri);
+    EXPECT_EQ(MediaLibraryDataManager::GetInstance()->Insert(uri, values), DATA_ABILITY_FAIL);
+    EXPECT_EQ(countFiles(), before);
+}
+
+/*
+ * Feature: MediaLibraryStatementCache
+ * Function: Query, GetCounters
+ * SubFunction: NA
+ * FunctionPoints: Fixed-shape lookups run from cached statement text with their argument bound
+ * EnvConditions: NA
+ * CaseDescription: Look up paths by id through concatenated predicates and through the statement cache,
+ *                  check both return the same paths, the counters add up and a quoted path binds safely
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_StatementCache_Test_001, TestSize.Level1)
+{
+    ASSERT_NE(g_filesStore, nullptr);
+    MediaLibraryStatementCache statementCache;
+    uint64_t found = 0;
+    for (int32_t id = 1; id <= PATH_LOOKUP_ROWS; id++) {
+        string path = GetPathFromResult(statementCache.Query(g_filesStore, StatementId::PATH_BY_ID, to_string(id)));
+        EXPECT_EQ(path, LegacyPathById(*g_filesStore, to_string(id)));
+        found += path.empty() ? 0u : 1u;
+    }
+    EXPECT_EQ(found, static_cast<uint64_t>(PATH_LOOKUP_ROWS));
+
+    StatementCounters counters = statementCache.GetCounters(StatementId::PATH_BY_ID);
+    EXPECT_EQ(counters.calls, static_cast<uint64_t>(PATH_LOOKUP_ROWS));
+    EXPECT_EQ(counters.failed, 0u);
+    EXPECT_EQ(counters.rows, found);
+    EXPECT_LE(counters.maxTime, counters.totalTime);
+
+    auto resultSet = statementCache.Query(g_filesStore, StatementId::ID_BY_PATH, GetAlbumPath(7) + "/IMG_7.jpg");
+    ASSERT_NE(resultSet, nullptr);
+    int32_t rowCount = -1;
+    EXPECT_EQ(resultSet->GetRowCount(rowCount), E_OK);
+    EXPECT_EQ(rowCount, 1);
+    resultSet->Close();
+    resultSet = statementCache.Query(g_filesStore, StatementId::ID_BY_PATH, GetAlbumPath(7) + "/IMG_'7.jpg");
+    ASSERT_NE(resultSet, nullptr);
+    EXPECT_EQ(resultSet->GetRowCount(rowCount), E_OK);
+    EXPECT_EQ(rowCount, 0);
+    resultSet->Close();
+    EXPECT_EQ(statementCache.GetCounters(StatementId::ID_BY_PATH).calls, 2u);
+    EXPECT_EQ(statementCache.GetCounters(StatementId::ID_BY_PATH).failed, 0u);
+
+    statementCache.ResetCounters();
+    EXPECT_EQ(statementCache.GetCounters(StatementId::PATH_BY_ID).calls, 0u);
+}
+
+/*
+ * Feature: MediaLibraryDataManager
+ * Function: InitMediaLibraryRdbStore
+ * SubFunction: NA
+ * FunctionPoints: Grid queries served from read connections of a WAL store while the scanner writes
+ * EnvConditions: NA
+ * CaseDescription: Commit scanner batches into a filled store opened in WAL journal mode while four readers
+ *                  page through the photo grid, check the store runs in WAL, every batch lands, every reader
+ *                  served pages meanwhile and none of them came back short
+ */
+HWTEST_F(MediaDataAbilityRdbUnitTest, MediaDataAbility_WalContention_Test_001, TestSize.Level1)
+{
+    RdbHelper::DeleteRdbStore(TEST_DB_PATH);
+    RdbStoreConfig config(TEST_DB_PATH);
+    config.SetJournalMode(JournalMode::MODE_WAL);
+    InitVersionCallback initCallback;
+    int32_t errCode = E_OK;
+    shared_ptr<RdbStore> store = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION_INIT, initCallback, errCode);
+    ASSERT_NE(store, nullptr);
+    InsertFilesRows(*store);
+    MediaLibraryDataCallBack callback;
+    ASSERT_EQ(callback.OnUpgrade(*store, MEDIA_RDB_VERSION_INIT, MEDIA_RDB_VERSION), E_OK);
+    EXPECT_EQ(GetJournalMode(*store), "wal");
+
+    atomic<bool> stop(false);
+    vector<ContentionResult> readerResults(GRID_READERS);
+    vector<thread> readers;
+    for (auto &readerResult : readerResults) {
+        readers.emplace_back(RunGridReader, ref(*store), cref(stop), ref(readerResult));
+    }
+    int32_t inserted = InsertScanBatches(*store);
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(inserted, SCAN_BATCHES * SCAN_BATCH_ASSETS);
+    for (const auto &readerResult : readerResults) {
+        EXPECT_GT(readerResult.queries, 0);
+        EXPECT_EQ(readerResult.failed, 0);
+    }
+}
+} // namespace Media
+} // namespace OHOS
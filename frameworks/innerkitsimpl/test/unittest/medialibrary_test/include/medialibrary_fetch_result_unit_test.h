@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEDIALIBRARY_FETCH_RESULT_UNIT_TEST_H
+#define MEDIALIBRARY_FETCH_RESULT_UNIT_TEST_H
+
+#include "gtest/gtest.h"
+#include "rdb_open_callback.h"
+#include "rdb_store.h"
+
+namespace OHOS {
+namespace Media {
+// Cases decoding Files rows of a store of their own through FetchResult, as the NAPI does
+class MediaLibraryFetchResultUnitTest : public testing::Test {
+public:
+    static void SetUpTestCase(void);
+    static void TearDownTestCase(void);
+    void SetUp();
+    void TearDown();
+};
+
+class FilesTableCallback : public NativeRdb::RdbOpenCallback {
+public:
+    int32_t OnCreate(NativeRdb::RdbStore &rdbStore) override;
+    int32_t OnUpgrade(NativeRdb::RdbStore &rdbStore, int32_t oldVersion, int32_t newVersion) override;
+};
+} // namespace Media
+} // namespace OHOS
+#endif // MEDIALIBRARY_FETCH_RESULT_UNIT_TEST_H
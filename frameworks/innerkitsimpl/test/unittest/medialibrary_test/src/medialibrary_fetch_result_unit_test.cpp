@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "medialibrary_fetch_result_unit_test.h"
+
+#include "abs_rdb_predicates.h"
+#include "datashare_result_set.h"
+#include "fetch_result.h"
+#include "media_data_ability_const.h"
+#include "media_lib_service_const.h"
+#include "rdb_errno.h"
+#include "rdb_helper.h"
+#include "rdb_utils.h"
+
+using namespace std;
+using namespace OHOS::NativeRdb;
+using namespace OHOS::RdbDataShareAdapter;
+using namespace testing::ext;
+
+namespace OHOS {
+namespace Media {
+namespace {
+    const string FETCH_DB_PATH = "/data/test/medialibrary_fetch_result.db";
+    const int32_t FETCH_ROW_COUNT = 1000;
+    const int32_t FETCH_ALBUM_COUNT = 20;
+    const int32_t FETCH_TRASH_RATIO = 50;
+    const int32_t FETCH_PAGE_ROWS = 100;
+    shared_ptr<RdbStore> g_fetchStore = nullptr;
+
+    string GetAlbumPath(int32_t albumId)
+    {
+        return ROOT_MEDIA_DIR + "Pictures/album_" + to_string(albumId);
+    }
+
+    void InsertFetchRows(RdbStore &store)
+    {
+        ASSERT_EQ(store.BeginTransaction(), E_OK);
+        for (int32_t i = 0; i < FETCH_ROW_COUNT; i++) {
+            int32_t albumId = i % FETCH_ALBUM_COUNT;
+            int32_t mediaType = (i % 4 == 0) ? MEDIA_TYPE_VIDEO : MEDIA_TYPE_IMAGE;
+            ValuesBucket values;
+            values.PutString(MEDIA_DATA_DB_FILE_PATH, GetAlbumPath(albumId) + "/IMG_" + to_string(i) + ".jpg");
+            values.PutString(MEDIA_DATA_DB_RELATIVE_PATH, "Pictures/album_" + to_string(albumId) + "/");
+            values.PutString(MEDIA_DATA_DB_NAME, "IMG_" + to_string(i) + ".jpg");
+            values.PutInt(MEDIA_DATA_DB_PARENT_ID, albumId);
+            values.PutInt(MEDIA_DATA_DB_BUCKET_ID, albumId);
+            values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, mediaType);
+            values.PutLong(MEDIA_DATA_DB_DATE_ADDED, i);
+            values.PutLong(MEDIA_DATA_DB_DATE_MODIFIED, i);
+            values.PutLong(MEDIA_DATA_DB_DATE_TRASHED, (i % FETCH_TRASH_RATIO == 0) ? i : 0);
+            int64_t rowId = 0;
+            ASSERT_EQ(store.Insert(rowId, MEDIALIBRARY_TABLE, values), E_OK);
+        }
+        ASSERT_EQ(store.Commit(), E_OK);
+    }
+
+    shared_ptr<DataShare::DataShareResultSet> QueryFetchAssets(RdbStore &store, const vector<string> &columns = {})
+    {
+        AbsRdbPredicates predicates(MEDIALIBRARY_TABLE);
+        predicates.OrderByAsc(MEDIA_DATA_DB_ID);
+        shared_ptr<AbsSharedResultSet> resultSet = store.Query(predicates, columns);
+        if (resultSet == nullptr) {
+            return nullptr;
+        }
+        return make_shared<DataShare::DataShareResultSet>(RdbUtils::ToResultSetBridge(resultSet));
+    }
+
+    // The fields of a row looked up by column name, as FetchResult::GetObject did before it cached the positions
+    struct RowByName {
+        int32_t id = 0;
+        int32_t mediaType = 0;
+        string path;
+        string displayName;
+        int64_t dateAdded = 0;
+        int64_t dateTrashed = 0;
+    };
+
+    RowByName DecodeRowByName(DataShare::DataShareResultSet &resultSet)
+    {
+        RowByName row;
+        int32_t index = 0;
+        resultSet.GetColumnIndex(MEDIA_DATA_DB_ID, index);
+        resultSet.GetInt(index, row.id);
+        resultSet.GetColumnIndex(MEDIA_DATA_DB_MEDIA_TYPE, index);
+        resultSet.GetInt(index, row.mediaType);
+        resultSet.GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, index);
+        resultSet.GetString(index, row.path);
+        resultSet.GetColumnIndex(MEDIA_DATA_DB_NAME, index);
+        resultSet.GetString(index, row.displayName);
+        resultSet.GetColumnIndex(MEDIA_DATA_DB_DATE_ADDED, index);
+        resultSet.GetLong(index, row.dateAdded);
+        resultSet.GetColumnIndex(MEDIA_DATA_DB_DATE_TRASHED, index);
+        resultSet.GetLong(index, row.dateTrashed);
+        return row;
+    }
+
+    void ExpectSameRow(const FileAsset &fileAsset, const RowByName &row)
+    {
+        EXPECT_EQ(fileAsset.GetId(), row.id);
+        EXPECT_EQ(fileAsset.GetMediaType(), row.mediaType);
+        EXPECT_EQ(fileAsset.GetPath(), row.path);
+        EXPECT_EQ(fileAsset.GetDisplayName(), row.displayName);
+        EXPECT_EQ(fileAsset.GetDateAdded(), row.dateAdded);
+        EXPECT_EQ(fileAsset.GetDateTrashed(), row.dateTrashed);
+    }
+} // namespace
+
+int32_t FilesTableCallback::OnCreate(RdbStore &rdbStore)
+{
+    return rdbStore.ExecuteSql(CREATE_MEDIA_TABLE);
+}
+
+int32_t FilesTableCallback::OnUpgrade(RdbStore &rdbStore, int32_t oldVersion, int32_t newVersion)
+{
+    return E_OK;
+}
+
+void MediaLibraryFetchResultUnitTest::SetUpTestCase(void)
+{
+    RdbHelper::DeleteRdbStore(FETCH_DB_PATH);
+    RdbStoreConfig config(FETCH_DB_PATH);
+    FilesTableCallback callback;
+    int32_t errCode = E_OK;
+    g_fetchStore = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION_INIT, callback, errCode);
+    ASSERT_NE(g_fetchStore, nullptr);
+    InsertFetchRows(*g_fetchStore);
+}
+
+void MediaLibraryFetchResultUnitTest::TearDownTestCase(void)
+{
+    g_fetchStore = nullptr;
+    RdbHelper::DeleteRdbStore(FETCH_DB_PATH);
+}
+
+void MediaLibraryFetchResultUnitTest::SetUp(void) {}
+
+void MediaLibraryFetchResultUnitTest::TearDown(void) {}
+
+/*
+ * Feature: FetchResult
+ * Function: GetObject, SetResultSet
+ * SubFunction: NA
+ * FunctionPoints: Rows decoded through column indexes resolved once per result set
+ * EnvConditions: NA
+ * CaseDescription: Decode every Files row looking the cells up by column name and then through FetchResult,
+ *                  check both agree row by row, then hand the FetchResult a projection with its columns in
+ *                  another order and check the positions are resolved again
+ */
+HWTEST_F(MediaLibraryFetchResultUnitTest, medialibrary_FetchResult_GetObject_test_001, TestSize.Level1)
+{
+    ASSERT_NE(g_fetchStore, nullptr);
+    auto resultSet = QueryFetchAssets(*g_fetchStore);
+    ASSERT_NE(resultSet, nullptr);
+    vector<RowByName> rows;
+    while (resultSet->GoToNextRow() == E_OK) {
+        rows.push_back(DecodeRowByName(*resultSet));
+    }
+    resultSet->Close();
+    ASSERT_EQ(static_cast<int32_t>(rows.size()), FETCH_ROW_COUNT);
+
+    FetchResult fetchResult(QueryFetchAssets(*g_fetchStore));
+    ASSERT_EQ(fetchResult.GetCount(), FETCH_ROW_COUNT);
+    size_t position = 0;
+    for (auto fileAsset = fetchResult.GetFirstObject(); fileAsset != nullptr;
+        fileAsset = fetchResult.GetNextObject()) {
+        ASSERT_LT(position, rows.size());
+        ExpectSameRow(*fileAsset, rows[position]);
+        position++;
+    }
+    EXPECT_EQ(position, rows.size());
+
+    fetchResult.SetResultSet(QueryFetchAssets(*g_fetchStore, { MEDIA_DATA_DB_DATE_TRASHED, MEDIA_DATA_DB_DATE_ADDED,
+        MEDIA_DATA_DB_NAME, MEDIA_DATA_DB_FILE_PATH, MEDIA_DATA_DB_MEDIA_TYPE, MEDIA_DATA_DB_ID }));
+    for (int32_t i : { 0, 1, FETCH_ROW_COUNT - 1 }) {
+        auto fileAsset = fetchResult.GetObjectAtPosition(i);
+        ASSERT_NE(fileAsset, nullptr);
+        ExpectSameRow(*fileAsset, rows[i]);
+    }
+    auto fileAsset = fetchResult.GetObjectAtPosition(1);
+    ASSERT_NE(fileAsset, nullptr);
+    EXPECT_EQ(fileAsset->GetPath(), GetAlbumPath(1) + "/IMG_1.jpg");
+    EXPECT_EQ(fileAsset->GetMediaType(), MEDIA_TYPE_IMAGE);
+    EXPECT_EQ(fileAsset->GetDateAdded(), 1);
+}
+
+/*
+ * Feature: FetchResult
+ * Function: GetObject
+ * SubFunction: NA
+ * FunctionPoints: Columns missing from the projection are skipped
+ * EnvConditions: NA
+ * CaseDescription: Decode rows of a projection without most FileAsset columns, check the projected
+ *                  fields are read and the others keep the FileAsset defaults
+ */
+HWTEST_F(MediaLibraryFetchResultUnitTest, medialibrary_FetchResult_GetObject_test_002, TestSize.Level1)
+{
+    ASSERT_NE(g_fetchStore, nullptr);
+    FetchResult fetchResult(QueryFetchAssets(*g_fetchStore, { MEDIA_DATA_DB_ID, MEDIA_DATA_DB_FILE_PATH,
+        MEDIA_DATA_DB_MEDIA_TYPE }));
+    ASSERT_GT(fetchResult.GetCount(), 1);
+    auto fileAsset = fetchResult.GetObjectAtPosition(1);
+    ASSERT_NE(fileAsset, nullptr);
+    EXPECT_GT(fileAsset->GetId(), 0);
+    EXPECT_EQ(fileAsset->GetPath(), GetAlbumPath(1) + "/IMG_1.jpg");
+    EXPECT_EQ(fileAsset->GetMediaType(), MEDIA_TYPE_IMAGE);
+
+    FileAsset defaults;
+    EXPECT_EQ(fileAsset->GetDisplayName(), defaults.GetDisplayName());
+    EXPECT_EQ(fileAsset->GetRelativePath(), defaults.GetRelativePath());
+    EXPECT_EQ(fileAsset->GetAlbumId(), defaults.GetAlbumId());
+    EXPECT_EQ(fileAsset->GetParent(), defaults.GetParent());
+    EXPECT_EQ(fileAsset->GetSize(), defaults.GetSize());
+    EXPECT_EQ(fileAsset->GetDateAdded(), defaults.GetDateAdded());
+    EXPECT_EQ(fileAsset->GetWidth(), defaults.GetWidth());
+    EXPECT_EQ(fileAsset->GetTitle(), defaults.GetTitle());
+}
+
+/*
+ * Feature: FetchResult
+ * Function: GetObjectRange
+ * SubFunction: NA
+ * FunctionPoints: Paged reads of a large result set
+ * EnvConditions: NA
+ * CaseDescription: Read a page in the middle and the clipped last page of the result set, check the rows
+ *                  match the single row reads and that empty and out of range pages come back empty
+ */
+HWTEST_F(MediaLibraryFetchResultUnitTest, medialibrary_FetchResult_GetObjectRange_test_001, TestSize.Level1)
+{
+    ASSERT_NE(g_fetchStore, nullptr);
+    FetchResult fetchResult(QueryFetchAssets(*g_fetchStore));
+    int32_t count = fetchResult.GetCount();
+    ASSERT_GT(count, FETCH_PAGE_ROWS * 2);
+
+    vector<unique_ptr<FileAsset>> page = fetchResult.GetObjectRange(FETCH_PAGE_ROWS, FETCH_PAGE_ROWS);
+    ASSERT_EQ(static_cast<int32_t>(page.size()), FETCH_PAGE_ROWS);
+    for (int32_t i = 0; i < FETCH_PAGE_ROWS; i++) {
+        auto fileAsset = fetchResult.GetObjectAtPosition(FETCH_PAGE_ROWS + i);
+        ASSERT_NE(fileAsset, nullptr);
+        EXPECT_EQ(page[i]->GetId(), fileAsset->GetId());
+        EXPECT_EQ(page[i]->GetPath(), fileAsset->GetPath());
+    }
+
+    page = fetchResult.GetObjectRange(count - 1, FETCH_PAGE_ROWS);
+    ASSERT_EQ(page.size(), 1u);
+    auto lastAsset = fetchResult.GetLastObject();
+    ASSERT_NE(lastAsset, nullptr);
+    EXPECT_EQ(page[0]->GetId(), lastAsset->GetId());
+    EXPECT_TRUE(fetchResult.GetObjectRange(count, FETCH_PAGE_ROWS).empty());
+    EXPECT_TRUE(fetchResult.GetObjectRange(0, 0).empty());
+    EXPECT_EQ(static_cast<int32_t>(fetchResult.GetObjectRange(0, count).size()), count);
+}
+
+/*
+ * Feature: FetchResult
+ * Function: GetFileAssetColumns
+ * SubFunction: NA
+ * FunctionPoints: Files queries select only the columns a FileAsset is decoded from
+ * EnvConditions: NA
+ * CaseDescription: Query the Files rows with every column and with the FileAsset projection, check the
+ *                  projection drops columns without changing the decoded assets
+ */
+HWTEST_F(MediaLibraryFetchResultUnitTest, medialibrary_FetchResult_GetFileAssetColumns_test_001, TestSize.Level1)
+{
+    ASSERT_NE(g_fetchStore, nullptr);
+    const vector<string> &columns = FetchResult::GetFileAssetColumns();
+    auto allColumns = QueryFetchAssets(*g_fetchStore);
+    auto projected = QueryFetchAssets(*g_fetchStore, columns);
+    ASSERT_NE(allColumns, nullptr);
+    ASSERT_NE(projected, nullptr);
+    int32_t allColumnCount = 0;
+    int32_t projectedColumnCount = 0;
+    allColumns->GetColumnCount(allColumnCount);
+    projected->GetColumnCount(projectedColumnCount);
+    EXPECT_EQ(projectedColumnCount, static_cast<int32_t>(columns.size()));
+    EXPECT_LT(projectedColumnCount, allColumnCount);
+
+    FetchResult allResult(allColumns);
+    FetchResult projectedResult(projected);
+    ASSERT_EQ(projectedResult.GetCount(), allResult.GetCount());
+    vector<unique_ptr<FileAsset>> expectedAssets = allResult.GetObjectRange(0, allResult.GetCount());
+    vector<unique_ptr<FileAsset>> fileAssets = projectedResult.GetObjectRange(0, projectedResult.GetCount());
+    ASSERT_EQ(fileAssets.size(), expectedAssets.size());
+    for (size_t i = 0; i < fileAssets.size(); i++) {
+        const auto &expected = expectedAssets[i];
+        const auto &fileAsset = fileAssets[i];
+        EXPECT_EQ(fileAsset->GetId(), expected->GetId());
+        EXPECT_EQ(fileAsset->GetUri(), expected->GetUri());
+        EXPECT_EQ(fileAsset->GetPath(), expected->GetPath());
+        EXPECT_EQ(fileAsset->GetRelativePath(), expected->GetRelativePath());
+        EXPECT_EQ(fileAsset->GetDisplayName(), expected->GetDisplayName());
+        EXPECT_EQ(fileAsset->GetAlbumId(), expected->GetAlbumId());
+        EXPECT_EQ(fileAsset->GetDateAdded(), expected->GetDateAdded());
+        EXPECT_EQ(fileAsset->GetDateTrashed(), expected->GetDateTrashed());
+    }
+}
+} // namespace Media
+} // namespace OHOS
@@ -0,0 +1,585 @@
+/*
+ * Copyright (C) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mediascanner_inner_unit_test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "media_data_ability_const.h"
+#include "media_scan_executor.h"
+#include "media_scanner.h"
+#include "media_scanner_operation_callback_stub.h"
+#include "media_scanner_watcher.h"
+#include "medialibrary_data_manager.h"
+#include "metadata_extractor.h"
+#include "rdb_errno.h"
+#include "rdb_helper.h"
+#include "scanner_utils.h"
+
+using namespace std;
+using namespace OHOS::NativeRdb;
+using namespace testing::ext;
+
+namespace OHOS {
+namespace Media {
+namespace {
+    const string TEST_ROOT_DIR = "/data/test/mediascanner_inner_test";
+    const string TEST_DB_PATH = "/data/test/mediascanner_inner_test.db";
+    const chrono::milliseconds WATCHER_TIMEOUT(WATCHER_MAX_DELAY_MS * 2);
+    const chrono::seconds SCAN_TIMEOUT(60);
+    const chrono::milliseconds SCAN_POLL_INTERVAL(10);
+    const int32_t SCAN_DIRS = 4;
+    const int32_t SCAN_DIR_FILES = 200;
+    const size_t IMAGE_FILE_SIZE = 64;
+
+    // Store the data manager served before a case swapped in its own one
+    shared_ptr<RdbStore> g_savedRdbStore = nullptr;
+    bool g_isRdbStoreSwapped = false;
+
+    // What the executor handed to its callback, in the order the scans started
+    struct ExecutedScan {
+        int32_t requestId;
+        vector<int32_t> mergedRequestIds;
+        bool isCancelled;
+    };
+    mutex g_scanLock;
+    condition_variable g_scanCond;
+    vector<ExecutedScan> g_executedScans;
+    // The scan of this request holds its worker until released or cancelled
+    int32_t g_heldRequestId = -1;
+    bool g_isScanReleased = false;
+
+    void WriteTestFile(const string &path)
+    {
+        ofstream file(path);
+        file << path;
+    }
+
+    // The header bytes of an image, padded with zeros as if the pixel data followed
+    void WriteImageFile(const string &path, vector<uint8_t> header, size_t size = IMAGE_FILE_SIZE)
+    {
+        header.resize(max(header.size(), size), 0);
+        ofstream file(path, ios::binary);
+        file.write(reinterpret_cast<const char *>(header.data()), header.size());
+    }
+
+    // Removes path and everything below it
+    void RemoveTree(const string &path)
+    {
+        struct stat statInfo;
+        if (lstat(path.c_str(), &statInfo) != 0) {
+            return;
+        }
+        if (!S_ISDIR(statInfo.st_mode)) {
+            unlink(path.c_str());
+            return;
+        }
+        DIR *dir = opendir(path.c_str());
+        if (dir != nullptr) {
+            struct dirent *ent = nullptr;
+            while ((ent = readdir(dir)) != nullptr) {
+                string name = ent->d_name;
+                if ((name != ".") && (name != "..")) {
+                    RemoveTree(path + "/" + name);
+                }
+            }
+            closedir(dir);
+        }
+        rmdir(path.c_str());
+    }
+
+    int32_t SwapDataManagerStore(const shared_ptr<RdbStore> &store)
+    {
+        auto dataManager = MediaLibraryDataManager::GetInstance();
+        g_savedRdbStore = dataManager->GetRdbStore();
+        g_isRdbStoreSwapped = true;
+        return dataManager->InitMediaLibraryRdbStore(store);
+    }
+
+    void RestoreDataManagerStore()
+    {
+        if (!g_isRdbStoreSwapped) {
+            return;
+        }
+        auto dataManager = MediaLibraryDataManager::GetInstance();
+        if (g_savedRdbStore != nullptr) {
+            dataManager->InitMediaLibraryRdbStore(g_savedRdbStore);
+        } else {
+            dataManager->ClearMediaLibraryMgr();
+        }
+        g_savedRdbStore = nullptr;
+        g_isRdbStoreSwapped = false;
+    }
+
+    void RecordScan(ScanRequest request)
+    {
+        unique_lock<mutex> lock(g_scanLock);
+        g_executedScans.push_back({ request.GetRequestId(), request.GetMergedRequestIds(), request.IsCancelled() });
+        g_scanCond.notify_all();
+        // Cancel does not signal g_scanCond, poll for it
+        while ((request.GetRequestId() == g_heldRequestId) && !g_isScanReleased && !request.IsCancelled()) {
+            g_scanCond.wait_for(lock, SCAN_POLL_INTERVAL);
+        }
+    }
+
+    void ResetExecutedScans(int32_t heldRequestId)
+    {
+        lock_guard<mutex> lock(g_scanLock);
+        g_executedScans.clear();
+        g_heldRequestId = heldRequestId;
+        g_isScanReleased = false;
+    }
+
+    void ReleaseHeldScan()
+    {
+        lock_guard<mutex> lock(g_scanLock);
+        g_isScanReleased = true;
+        g_scanCond.notify_all();
+    }
+
+    vector<ExecutedScan> WaitForExecutedScans(size_t count)
+    {
+        unique_lock<mutex> lock(g_scanLock);
+        g_scanCond.wait_for(lock, SCAN_TIMEOUT, [count] { return g_executedScans.size() >= count; });
+        return g_executedScans;
+    }
+
+    vector<int32_t> GetExecutedIds(const vector<ExecutedScan> &scans)
+    {
+        vector<int32_t> ids;
+        for (const auto &scan : scans) {
+            ids.push_back(scan.requestId);
+        }
+        return ids;
+    }
+
+    unique_ptr<ScanRequest> MakeScanRequest(int32_t requestId, const string &path, bool isDir)
+    {
+        auto request = make_unique<ScanRequest>(path);
+        request->SetRequestId(requestId);
+        request->SetIsDirectory(isDir);
+        return request;
+    }
+
+    // Counts the scans that reported back through the operation callback
+    class ScanFinishedCallback : public IMediaScannerAppCallback {
+    public:
+        void OnScanFinished(const int32_t status, const string &uri, const string &path) override
+        {
+            lock_guard<mutex> lock(lock_);
+            statuses_.push_back(status);
+            finishedCond_.notify_all();
+        }
+
+        bool WaitFor(size_t count)
+        {
+            unique_lock<mutex> lock(lock_);
+            return finishedCond_.wait_for(lock, SCAN_TIMEOUT, [&] { return statuses_.size() >= count; });
+        }
+
+        vector<int32_t> GetStatuses()
+        {
+            lock_guard<mutex> lock(lock_);
+            return statuses_;
+        }
+
+    private:
+        mutex lock_;
+        condition_variable finishedCond_;
+        vector<int32_t> statuses_;
+    };
+
+    string GetScanDirPath(int32_t dirId)
+    {
+        return TEST_ROOT_DIR + "/dir_" + to_string(dirId);
+    }
+
+    string GetScanFilePath(int32_t dirId, int32_t fileId)
+    {
+        return GetScanDirPath(dirId) + "/IMG_" + to_string(fileId) + ".jpg";
+    }
+
+    // The scanner takes any .jpg as an image, the content does not matter
+    void CreateScanDir(int32_t dirId)
+    {
+        mkdir(GetScanDirPath(dirId).c_str(), S_IRWXU);
+        for (int32_t i = 0; i < SCAN_DIR_FILES; i++) {
+            WriteTestFile(GetScanFilePath(dirId, i));
+        }
+    }
+
+    // Row id of every path under dir, dir itself included
+    map<string, int32_t> QueryScannedIds(RdbStore &store, const string &dir)
+    {
+        map<string, int32_t> ids;
+        auto resultSet = store.QuerySql("SELECT " + MEDIA_DATA_DB_ID + ", " + MEDIA_DATA_DB_FILE_PATH + " FROM " +
+            MEDIALIBRARY_TABLE + " WHERE " + MEDIA_DATA_DB_FILE_PATH + " = ? OR " + MEDIA_DATA_DB_FILE_PATH +
+            " LIKE ?", vector<string> { dir, dir + "/%" });
+        if (resultSet == nullptr) {
+            return ids;
+        }
+        while (resultSet->GoToNextRow() == E_OK) {
+            int32_t id = 0;
+            string path;
+            resultSet->GetInt(0, id);
+            resultSet->GetString(1, path);
+            ids[path] = id;
+        }
+        resultSet->Close();
+        return ids;
+    }
+
+    // Collects what a watcher reports, path to isDir, and how often each path came
+    class WatcherReports {
+    public:
+        void Add(const string &path, bool isDir)
+        {
+            lock_guard<mutex> lock(lock_);
+            isDir_[path] = isDir;
+            counts_[path]++;
+            reportedCond_.notify_all();
+        }
+
+        bool WaitFor(const string &path)
+        {
+            unique_lock<mutex> lock(lock_);
+            return reportedCond_.wait_for(lock, WATCHER_TIMEOUT, [&] { return counts_.count(path) > 0; });
+        }
+
+        map<string, int32_t> GetCounts()
+        {
+            lock_guard<mutex> lock(lock_);
+            return counts_;
+        }
+
+        bool IsDir(const string &path)
+        {
+            lock_guard<mutex> lock(lock_);
+            return isDir_[path];
+        }
+
+    private:
+        mutex lock_;
+        condition_variable reportedCond_;
+        map<string, bool> isDir_;
+        map<string, int32_t> counts_;
+    };
+} // namespace
+
+void MediaScannerInnerUnitTest::SetUpTestCase(void) {}
+
+void MediaScannerInnerUnitTest::TearDownTestCase(void) {}
+
+void MediaScannerInnerUnitTest::SetUp(void)
+{
+    RemoveTree(TEST_ROOT_DIR);
+    mkdir(TEST_ROOT_DIR.c_str(), S_IRWXU);
+}
+
+// Cases stop at their first failed assertion, undo what they may have left behind here
+void MediaScannerInnerUnitTest::TearDown(void)
+{
+    ReleaseHeldScan();
+    RestoreDataManagerStore();
+    RemoveTree(TEST_ROOT_DIR);
+    RdbHelper::DeleteRdbStore(TEST_DB_PATH);
+}
+
+/*
+ * Feature: MediaScannerWatcher
+ * Function: Start, Stop
+ * SubFunction: NA
+ * FunctionPoints: Changes reported once they settle, paths under a reported directory left out
+ * EnvConditions: NA
+ * CaseDescription: Rewrite a file many times, write a hidden file and create a directory with files while
+ *                  watching the tree, check nothing is reported within the debounce window, then that every
+ *                  path is reported once, the files of the new directory are covered by it and the hidden
+ *                  file is not reported, and that the new directory is watched from then on
+ */
+HWTEST_F(MediaScannerInnerUnitTest, mediascanner_Watcher_test_001, TestSize.Level1)
+{
+    const string subDir = TEST_ROOT_DIR + "/sub";
+    ASSERT_EQ(mkdir(subDir.c_str(), S_IRWXU), 0);
+    WatcherReports reports;
+    MediaScannerWatcher watcher;
+    ASSERT_EQ(watcher.Start(TEST_ROOT_DIR, [&reports](const string &path, bool isDir) {
+        reports.Add(path, isDir);
+    }), ERR_SUCCESS);
+    EXPECT_TRUE(watcher.IsRunning());
+    EXPECT_NE(watcher.Start(TEST_ROOT_DIR, [](const string &path, bool isDir) {}), ERR_SUCCESS);
+
+    const string rewritten = subDir + "/rewritten.jpg";
+    const int32_t rewrites = 10;
+    for (int32_t i = 0; i < rewrites; i++) {
+        WriteTestFile(rewritten);
+    }
+    WriteTestFile(TEST_ROOT_DIR + "/.hidden.jpg");
+    const string newDir = TEST_ROOT_DIR + "/new_dir";
+    ASSERT_EQ(mkdir(newDir.c_str(), S_IRWXU), 0);
+    WriteTestFile(newDir + "/first.jpg");
+    WriteTestFile(newDir + "/second.jpg");
+    this_thread::sleep_for(chrono::milliseconds(WATCHER_DEBOUNCE_MS / 5));
+    EXPECT_TRUE(reports.GetCounts().empty());
+
+    ASSERT_TRUE(reports.WaitFor(rewritten));
+    ASSERT_TRUE(reports.WaitFor(newDir));
+    // Nothing else may follow once the changes settled
+    this_thread::sleep_for(chrono::milliseconds(WATCHER_DEBOUNCE_MS * 2));
+    map<string, int32_t> counts = reports.GetCounts();
+    EXPECT_EQ(counts.size(), 2u);
+    EXPECT_EQ(counts[rewritten], 1);
+    EXPECT_FALSE(reports.IsDir(rewritten));
+    EXPECT_EQ(counts[newDir], 1);
+    EXPECT_TRUE(reports.IsDir(newDir));
+
+    const string later = newDir + "/later.jpg";
+    WriteTestFile(later);
+    ASSERT_TRUE(reports.WaitFor(later));
+    EXPECT_FALSE(reports.IsDir(later));
+
+    watcher.Stop();
+    EXPECT_FALSE(watcher.IsRunning());
+    WriteTestFile(subDir + "/stopped.jpg");
+    this_thread::sleep_for(chrono::milliseconds(WATCHER_DEBOUNCE_MS * 2));
+    EXPECT_EQ(reports.GetCounts().count(subDir + "/stopped.jpg"), 0u);
+}
+
+/*
+ * Feature: MediaScanExecutor
+ * Function: ExecuteScan
+ * SubFunction: NA
+ * FunctionPoints: File scans go ahead of directory scans, queued requests for one path are merged
+ * EnvConditions: NA
+ * CaseDescription: Hold a directory scan on its worker, queue two directory scans of another path and two
+ *                  file scans, check the file scans run on the free worker while the second directory waits,
+ *                  then release the first and check the second runs once with the id of the merged request
+ */
+HWTEST_F(MediaScannerInnerUnitTest, mediascanner_ScanExecutor_test_001, TestSize.Level1)
+{
+    ResetExecutedScans(1);
+    MediaScanExecutor executor;
+    executor.SetCallbackFunction(RecordScan);
+    executor.ExecuteScan(MakeScanRequest(1, TEST_ROOT_DIR + "/held", true));
+    ASSERT_EQ(WaitForExecutedScans(1).size(), 1u);
+
+    executor.ExecuteScan(MakeScanRequest(2, TEST_ROOT_DIR + "/queued", true));
+    executor.ExecuteScan(MakeScanRequest(3, TEST_ROOT_DIR + "/queued", true));
+    executor.ExecuteScan(MakeScanRequest(4, TEST_ROOT_DIR + "/first.jpg", false));
+    executor.ExecuteScan(MakeScanRequest(5, TEST_ROOT_DIR + "/second.jpg", false));
+    vector<ExecutedScan> scans = WaitForExecutedScans(3);
+    ASSERT_EQ(scans.size(), 3u);
+    EXPECT_EQ(GetExecutedIds(scans), vector<int32_t>({ 1, 4, 5 }));
+
+    ReleaseHeldScan();
+    scans = WaitForExecutedScans(4);
+    ASSERT_EQ(scans.size(), 4u);
+    EXPECT_EQ(scans[3].requestId, 2);
+    EXPECT_EQ(scans[3].mergedRequestIds, vector<int32_t>({ 3 }));
+    for (const auto &scan : scans) {
+        EXPECT_FALSE(scan.isCancelled);
+    }
+    executor.Stop();
+    EXPECT_EQ(WaitForExecutedScans(4).size(), 4u);
+}
+
+/*
+ * Feature: MediaScanExecutor
+ * Function: Stop
+ * SubFunction: NA
+ * FunctionPoints: Every request reaches the callback, even those Stop dropped
+ * EnvConditions: NA
+ * CaseDescription: Hold a directory scan on its worker and queue another directory scan, stop the executor
+ *                  and check the running scan is cancelled, the queued one reaches the callback cancelled
+ *                  and a request made after Stop is completed as cancelled at once
+ */
+HWTEST_F(MediaScannerInnerUnitTest, mediascanner_ScanExecutor_test_002, TestSize.Level1)
+{
+    ResetExecutedScans(1);
+    MediaScanExecutor executor;
+    executor.SetCallbackFunction(RecordScan);
+    executor.ExecuteScan(MakeScanRequest(1, TEST_ROOT_DIR + "/held", true));
+    ASSERT_EQ(WaitForExecutedScans(1).size(), 1u);
+    executor.ExecuteScan(MakeScanRequest(2, TEST_ROOT_DIR + "/queued", true));
+
+    // Returns once the held scan saw its cancel flag
+    executor.Stop();
+    vector<ExecutedScan> scans = WaitForExecutedScans(2);
+    ASSERT_EQ(scans.size(), 2u);
+    EXPECT_EQ(scans[1].requestId, 2);
+    EXPECT_TRUE(scans[1].isCancelled);
+
+    executor.ExecuteScan(MakeScanRequest(3, TEST_ROOT_DIR + "/late.jpg", false));
+    scans = WaitForExecutedScans(3);
+    ASSERT_EQ(scans.size(), 3u);
+    EXPECT_EQ(scans[2].requestId, 3);
+    EXPECT_TRUE(scans[2].isCancelled);
+}
+
+/*
+ * Feature: MediaScanner
+ * Function: Directory cleanup of concurrent scans
+ * SubFunction: NA
+ * FunctionPoints: Every scan keeps the ids it visited to itself
+ * EnvConditions: NA
+ * CaseDescription: Scan a tree, remove one of its directories, then scan the root and the removed directory
+ *                  at once and check the untouched files keep their row ids while the removed ones are gone
+ */
+HWTEST_F(MediaScannerInnerUnitTest, mediascanner_ScanDir_Cleanup_test_001, TestSize.Level1)
+{
+    RdbHelper::DeleteRdbStore(TEST_DB_PATH);
+    RdbStoreConfig config(TEST_DB_PATH);
+    MediaLibraryDataCallBack callback;
+    int32_t errCode = E_OK;
+    shared_ptr<RdbStore> store = RdbHelper::GetRdbStore(config, MEDIA_RDB_VERSION, callback, errCode);
+    ASSERT_NE(store, nullptr);
+    ASSERT_EQ(SwapDataManagerStore(store), DATA_ABILITY_SUCCESS);
+
+    for (int32_t i = 0; i < SCAN_DIRS; i++) {
+        CreateScanDir(i);
+    }
+    auto scanCallback = make_shared<ScanFinishedCallback>();
+    sptr<MediaScannerOperationCallbackStub> callbackStub = new MediaScannerOperationCallbackStub();
+    callbackStub->SetApplicationCallback(scanCallback);
+    MediaScannerObj *scanner = MediaScannerObj::GetMediaScannerInstance();
+    string rootPath = TEST_ROOT_DIR;
+    ASSERT_EQ(scanner->ScanDir(rootPath, callbackStub->AsObject()), ERR_SUCCESS);
+    ASSERT_TRUE(scanCallback->WaitFor(1));
+
+    map<string, int32_t> before = QueryScannedIds(*store, TEST_ROOT_DIR);
+    for (int32_t i = 0; i < SCAN_DIRS; i++) {
+        for (int32_t j = 0; j < SCAN_DIR_FILES; j++) {
+            ASSERT_EQ(before.count(GetScanFilePath(i, j)), 1u);
+        }
+    }
+
+    // The walk of the root and the removal of dir_0 run side by side
+    const int32_t removedDir = 0;
+    string removedPath = GetScanDirPath(removedDir);
+    RemoveTree(removedPath);
+    ASSERT_EQ(scanner->ScanDir(rootPath, callbackStub->AsObject()), ERR_SUCCESS);
+    EXPECT_EQ(scanner->ScanDir(removedPath, nullptr), ERR_INCORRECT_PATH);
+    ASSERT_TRUE(scanCallback->WaitFor(2));
+    for (int32_t status : scanCallback->GetStatuses()) {
+        EXPECT_EQ(status, ERR_SUCCESS);
+    }
+
+    // The removal reports to no one, wait for its rows to go
+    auto deadline = chrono::steady_clock::now() + SCAN_TIMEOUT;
+    while (!QueryScannedIds(*store, removedPath).empty() && (chrono::steady_clock::now() < deadline)) {
+        this_thread::sleep_for(SCAN_POLL_INTERVAL);
+    }
+    EXPECT_TRUE(QueryScannedIds(*store, removedPath).empty());
+
+    map<string, int32_t> after = QueryScannedIds(*store, TEST_ROOT_DIR);
+    for (const auto &entry : before) {
+        const string &path = entry.first;
+        if ((path == removedPath) || (path.rfind(removedPath + "/", 0) == 0)) {
+            EXPECT_EQ(after.count(path), 0u);
+            continue;
+        }
+        auto iter = after.find(path);
+        ASSERT_NE(iter, after.end());
+        EXPECT_EQ(iter->second, entry.second);
+    }
+}
+
+/*
+ * Feature: MetadataExtractor
+ * Function: ProbeImageSize
+ * SubFunction: NA
+ * FunctionPoints: Dimensions read from the header of each known format
+ * EnvConditions: NA
+ * CaseDescription: Write the headers of a JPEG with an APP0 segment before its SOF0, a PNG, a GIF, a top-down
+ *                  BMP and WebP files of the VP8, VP8L and VP8X kinds, and check the probed sizes
+ */
+HWTEST_F(MediaScannerInnerUnitTest, mediascanner_ProbeImageSize_test_001, TestSize.Level1)
+{
+    struct ProbeCase {
+        string name;
+        vector<uint8_t> header;
+        int32_t width;
+        int32_t height;
+    };
+    vector<ProbeCase> probeCases = {
+        { "jpeg.jpg", {
+            0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00, 0x01, 0x01, 0x00, 0x00, 0x01, 0x00, 0x01,
+            0x00, 0x00, 0xFF, 0xC0, 0x00, 0x11, 0x08, 0x04, 0x38, 0x07, 0x80 }, 1920, 1080 },
+        { "png.png", {
+            0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0x00, 0x00, 0x00, 0x0D, 'I', 'H', 'D', 'R',
+            0x00, 0x00, 0x02, 0x80, 0x00, 0x00, 0x01, 0xE0 }, 640, 480 },
+        { "gif.gif", { 'G', 'I', 'F', '8', '9', 'a', 0x40, 0x01, 0xC8, 0x00 }, 320, 200 },
+        // Negative height, the rows are stored top-down
+        { "bmp.bmp", {
+            'B', 'M', 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x36, 0x00, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00,
+            0x64, 0x00, 0x00, 0x00, 0xCE, 0xFF, 0xFF, 0xFF }, 100, 50 },
+        { "vp8.webp", {
+            'R', 'I', 'F', 'F', 0x00, 0x00, 0x00, 0x00, 'W', 'E', 'B', 'P', 'V', 'P', '8', ' ', 0x00, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x9D, 0x01, 0x2A, 0x80, 0x02, 0xE0, 0x01 }, 640, 480 },
+        { "vp8l.webp", {
+            'R', 'I', 'F', 'F', 0x00, 0x00, 0x00, 0x00, 'W', 'E', 'B', 'P', 'V', 'P', '8', 'L', 0x00, 0x00, 0x00, 0x00,
+            0x2F, 0x1F, 0xC3, 0x95, 0x00 }, 800, 600 },
+        { "vp8x.webp", {
+            'R', 'I', 'F', 'F', 0x00, 0x00, 0x00, 0x00, 'W', 'E', 'B', 'P', 'V', 'P', '8', 'X', 0x0A, 0x00, 0x00, 0x00,
+            0x00, 0x00, 0x00, 0x00, 0x9F, 0x0F, 0x00, 0xB7, 0x0B, 0x00 }, 4000, 3000 },
+    };
+    for (const auto &probeCase : probeCases) {
+        string path = TEST_ROOT_DIR + "/" + probeCase.name;
+        WriteImageFile(path, probeCase.header);
+        int32_t width = 0;
+        int32_t height = 0;
+        ASSERT_TRUE(MetadataExtractor::ProbeImageSize(path, width, height)) << probeCase.name;
+        EXPECT_EQ(width, probeCase.width) << probeCase.name;
+        EXPECT_EQ(height, probeCase.height) << probeCase.name;
+    }
+}
+
+/*
+ * Feature: MetadataExtractor
+ * Function: ProbeImageSize
+ * SubFunction: NA
+ * FunctionPoints: Headers the probe cannot read leave the size to the image source
+ * EnvConditions: NA
+ * CaseDescription: Probe a missing file, a file of an unknown format, a truncated PNG, a GIF of zero width and
+ *                  a JPEG whose scan starts before any SOF, and check each is refused with the size untouched
+ */
+HWTEST_F(MediaScannerInnerUnitTest, mediascanner_ProbeImageSize_test_002, TestSize.Level1)
+{
+    vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n', 0x00, 0x00, 0x00, 0x0D, 'I', 'H', 'D', 'R',
+        0x00, 0x00, 0x02, 0x80, 0x00, 0x00, 0x01, 0xE0 };
+    WriteImageFile(TEST_ROOT_DIR + "/truncated.png", png, png.size());
+    WriteImageFile(TEST_ROOT_DIR + "/unknown.heic", { 0x00, 0x00, 0x00, 0x18, 'f', 't', 'y', 'p', 'h', 'e', 'i', 'c' });
+    WriteImageFile(TEST_ROOT_DIR + "/empty.gif", { 'G', 'I', 'F', '8', '7', 'a', 0x00, 0x00, 0xC8, 0x00 });
+    WriteImageFile(TEST_ROOT_DIR + "/no_sof.jpg", { 0xFF, 0xD8, 0xFF, 0xDA, 0x00, 0x08 });
+
+    const vector<string> names = { "missing.jpg", "truncated.png", "unknown.heic", "empty.gif", "no_sof.jpg" };
+    for (const auto &name : names) {
+        int32_t width = -1;
+        int32_t height = -1;
+        EXPECT_FALSE(MetadataExtractor::ProbeImageSize(TEST_ROOT_DIR + "/" + name, width, height)) << name;
+        EXPECT_EQ(width, -1) << name;
+        EXPECT_EQ(height, -1) << name;
+    }
+}
+} // namespace Media
+} // namespace OHOS
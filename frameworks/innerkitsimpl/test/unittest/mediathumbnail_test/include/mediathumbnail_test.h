@@ -16,6 +16,8 @@
 #ifndef MEDIATHUMBNAIL_TEST_H
 #define MEDIATHUMBNAIL_TEST_H
 
+#include <functional>
+
 #include "gtest/gtest.h"
 
 #include "medialibrary_thumbnail.h"
@@ -36,6 +38,9 @@ public:
 
     /* TearDown:Execute after each test case */
     void TearDown();
+
+    /* SetFlightHook:Hook run by the requester that owns a new thumbnail flight, before it generates */
+    static void SetFlightHook(MediaLibraryThumbnail &thumbnail, const std::function<void()> &hook);
 };
 } // namespace Media
 } // namespace OHOS
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2022 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mediathumbnail_cache_unit_test.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image_packer.h"
+#include "image_source.h"
+#include "media_data_ability_const.h"
+#include "media_thumbnail_cache.h"
+
+using namespace std;
+using namespace testing::ext;
+
+namespace OHOS {
+namespace Media {
+namespace {
+    const int32_t THUMBNAIL_ROUNDS = 10;
+    const size_t THUMBNAIL_CACHE_ENTRIES = 4;
+    const Size THUMBNAIL_SIZE = {
+        .width = 256,
+        .height = 256
+    };
+
+    unique_ptr<PixelMap> CreateThumbnailPixelMap(uint32_t color)
+    {
+        InitializationOptions opts = {
+            .size = THUMBNAIL_SIZE,
+            .pixelFormat = PixelFormat::BGRA_8888,
+            .alphaType = AlphaType::IMAGE_ALPHA_TYPE_UNPREMUL
+        };
+        vector<uint32_t> colors(THUMBNAIL_SIZE.width * THUMBNAIL_SIZE.height);
+        for (size_t i = 0; i < colors.size(); i++) {
+            colors[i] = color + static_cast<uint32_t>(i);
+        }
+        return PixelMap::Create(colors.data(), colors.size(), opts);
+    }
+
+    // The JPEG as the data extension stores it in the thumbnail KV store
+    vector<uint8_t> EncodeThumbnail(PixelMap &pixelMap)
+    {
+        vector<uint8_t> data(pixelMap.GetByteCount());
+        PackOption option = {
+            .format = "image/jpeg",
+            .quality = 80,
+            .numberHint = 1
+        };
+        ImagePacker imagePacker;
+        int64_t packedSize = 0;
+        if ((imagePacker.StartPacking(data.data(), data.size(), option) != SUCCESS) ||
+            (imagePacker.AddImage(pixelMap) != SUCCESS) || (imagePacker.FinalizePacking(packedSize) != SUCCESS)) {
+            return {};
+        }
+        data.resize(packedSize);
+        return data;
+    }
+
+    // Decode as MediaThumbnailHelper::ResizeImage does on every request without the cache
+    unique_ptr<PixelMap> DecodeThumbnail(const vector<uint8_t> &data, const Size &size)
+    {
+        uint32_t errorCode = SUCCESS;
+        SourceOptions sourceOpts;
+        unique_ptr<ImageSource> imageSource = ImageSource::CreateImageSource(data.data(), data.size(), sourceOpts,
+            errorCode);
+        if ((imageSource == nullptr) || (errorCode != SUCCESS)) {
+            return nullptr;
+        }
+        DecodeOptions decodeOpts;
+        decodeOpts.desiredSize = size;
+        return imageSource->CreatePixelMap(decodeOpts, errorCode);
+    }
+} // namespace
+
+void MediaThumbnailCacheUnitTest::SetUpTestCase(void) {}
+
+void MediaThumbnailCacheUnitTest::TearDownTestCase(void) {}
+
+void MediaThumbnailCacheUnitTest::SetUp(void) {}
+
+void MediaThumbnailCacheUnitTest::TearDown(void) {}
+
+/*
+ * Feature: MediaThumbnailCache
+ * Function: Get, Put
+ * SubFunction: NA
+ * FunctionPoints: Decoded thumbnails reused within the byte budget
+ * EnvConditions: NA
+ * CaseDescription: Serve a decoded thumbnail repeatedly from the cache and check the copies and counters,
+ *                  then check the least recently used entry is evicted at the budget and that a new key for
+ *                  a uri drops the thumbnails of its old key
+ */
+HWTEST_F(MediaThumbnailCacheUnitTest, MediaThumbnailCache_Test_001, TestSize.Level1)
+{
+    unique_ptr<PixelMap> source = CreateThumbnailPixelMap(0);
+    ASSERT_NE(source, nullptr);
+    vector<uint8_t> jpeg = EncodeThumbnail(*source);
+    ASSERT_FALSE(jpeg.empty());
+    Size size = THUMBNAIL_SIZE;
+    size_t thumbnailBytes = static_cast<size_t>(source->GetByteCount());
+    MediaThumbnailCache thumbnailCache(thumbnailBytes * THUMBNAIL_CACHE_ENTRIES);
+    const string uri = MEDIALIBRARY_IMAGE_URI + "/42";
+
+    EXPECT_EQ(thumbnailCache.Get("key_0", size), nullptr);
+    unique_ptr<PixelMap> decoded = DecodeThumbnail(jpeg, size);
+    ASSERT_NE(decoded, nullptr);
+    thumbnailCache.Put("key_0", size, uri, *decoded);
+    for (int32_t round = 0; round < THUMBNAIL_ROUNDS; round++) {
+        unique_ptr<PixelMap> cached = thumbnailCache.Get("key_0", size);
+        ASSERT_NE(cached, nullptr);
+        EXPECT_NE(cached.get(), decoded.get());
+        EXPECT_EQ(cached->GetWidth(), decoded->GetWidth());
+        EXPECT_EQ(cached->GetHeight(), decoded->GetHeight());
+        EXPECT_EQ(cached->GetByteCount(), decoded->GetByteCount());
+    }
+    EXPECT_EQ(thumbnailCache.Get("key_0", { .width = size.width / 2, .height = size.height / 2 }), nullptr);
+
+    ThumbnailCacheCounters counters = thumbnailCache.GetCounters();
+    EXPECT_EQ(counters.hits, static_cast<uint64_t>(THUMBNAIL_ROUNDS));
+    EXPECT_EQ(counters.misses, 2u);
+    EXPECT_EQ(counters.entries, 1u);
+
+    for (size_t i = 1; i <= THUMBNAIL_CACHE_ENTRIES; i++) {
+        thumbnailCache.Put("key_" + to_string(i), size, uri + to_string(i), *source);
+    }
+    counters = thumbnailCache.GetCounters();
+    EXPECT_EQ(counters.evictions, 1u);
+    EXPECT_EQ(counters.entries, THUMBNAIL_CACHE_ENTRIES);
+    EXPECT_LE(counters.bytes, thumbnailBytes * THUMBNAIL_CACHE_ENTRIES);
+    EXPECT_EQ(thumbnailCache.Get("key_0", size), nullptr);
+    EXPECT_NE(thumbnailCache.Get("key_1", size), nullptr);
+
+    // The asset at uri 1 was modified, its thumbnail got a new key
+    thumbnailCache.Put("key_1_modified", size, uri + "1", *source);
+    counters = thumbnailCache.GetCounters();
+    EXPECT_EQ(counters.invalidations, 1u);
+    EXPECT_EQ(thumbnailCache.Get("key_1", size), nullptr);
+    EXPECT_NE(thumbnailCache.Get("key_1_modified", size), nullptr);
+
+    thumbnailCache.Clear();
+    thumbnailCache.ResetCounters();
+    counters = thumbnailCache.GetCounters();
+    EXPECT_EQ(counters.entries, 0u);
+    EXPECT_EQ(counters.bytes, 0u);
+    EXPECT_EQ(counters.hits, 0u);
+}
+} // namespace Media
+} // namespace OHOS
@@ -15,7 +15,11 @@
 
 #include "mediathumbnail_test.h"
 
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "data_ability_helper.h"
 #include "system_ability_definition.h"
@@ -113,6 +117,11 @@ void MediaThumbnailTest::TearDown(void)
     RdbHelper::ClearCache();
 }
 
+void MediaThumbnailTest::SetFlightHook(MediaLibraryThumbnail &thumbnail, const std::function<void()> &hook)
+{
+    thumbnail.SetFlightHook(hook);
+}
+
 static int InsertRdbStore(int64_t &id, const string path)
 {
     std::shared_ptr<RdbStore> &mstore = store;
@@ -536,6 +545,86 @@ HWTEST_F(MediaThumbnailTest, MediaThumbnailTest_002_6, TestSize.Level0)
     EXPECT_EQ(res, false);
     EXPECT_EQ(key.empty(), true);
 }
+
+HWTEST_F(MediaThumbnailTest, MediaThumbnailTest_002_7, TestSize.Level0)
+{
+    std::shared_ptr<RdbStore> &mstore = store;
+    int64_t id = 0;
+
+    int ret = InsertRdbStore(id, TEST_PIC_PATH);
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_NE(0, id);
+
+    ThumbRdbOpt opts = {
+        .store = mstore,
+        .table = MEDIALIBRARY_TABLE,
+        .row = to_string(id),
+    };
+
+    std::string thumbnailKey, lcdKey;
+    bool res = g_mediaThumbnail.CreateRenditions(opts, thumbnailKey, lcdKey);
+
+    EXPECT_NE(res, false);
+    EXPECT_EQ(thumbnailKey.empty(), false);
+    EXPECT_EQ(lcdKey.empty(), false);
+}
+
+HWTEST_F(MediaThumbnailTest, MediaThumbnailTest_002_8, TestSize.Level0)
+{
+    const int32_t requesters = 8;
+    std::shared_ptr<RdbStore> &mstore = store;
+    int64_t id = 0;
+
+    int ret = InsertRdbStore(id, TEST_PIC_PATH);
+    EXPECT_EQ(ret, E_OK);
+    EXPECT_NE(0, id);
+
+    ThumbRdbOpt opts = {
+        .store = mstore,
+        .table = MEDIALIBRARY_TABLE,
+        .row = to_string(id),
+    };
+
+    ThumbnailFlightCounters before = g_mediaThumbnail.GetFlightCounters();
+    // The first requester holds its flight open until every other one has joined it
+    SetFlightHook(g_mediaThumbnail, [&before] {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while ((g_mediaThumbnail.GetFlightCounters().coalesced - before.coalesced <
+            static_cast<uint64_t>(requesters - 1)) && (std::chrono::steady_clock::now() < deadline)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    std::atomic<bool> go(false);
+    std::vector<std::string> keys(requesters);
+    std::vector<int32_t> results(requesters, 0);
+    std::vector<std::thread> threads;
+    for (int32_t i = 0; i < requesters; i++) {
+        threads.emplace_back([&, i] {
+            while (!go) {
+                std::this_thread::yield();
+            }
+            ThumbRdbOpt requestOpts = opts;
+            results[i] = g_mediaThumbnail.CreateThumbnail(requestOpts, keys[i]) ? 1 : 0;
+        });
+    }
+    go = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    SetFlightHook(g_mediaThumbnail, nullptr);
+    ThumbnailFlightCounters after = g_mediaThumbnail.GetFlightCounters();
+
+    for (int32_t i = 0; i < requesters; i++) {
+        EXPECT_EQ(results[i], 1);
+        EXPECT_EQ(keys[i], keys[0]);
+    }
+    EXPECT_EQ(keys[0].empty(), false);
+    uint64_t generated = after.generated - before.generated;
+    uint64_t coalesced = after.coalesced - before.coalesced;
+    EXPECT_EQ(generated, 1u);
+    EXPECT_EQ(coalesced, static_cast<uint64_t>(requesters - 1));
+}
+
 HWTEST_F(MediaThumbnailTest, MediaThumbnailTest_003, TestSize.Level0)
 {
     Size size = {
@@ -644,7 +644,7 @@ static void GetFileAssetsNative(AlbumNapiAsyncContext *context)
     predicates.SetWhereClause(context->selection);
     predicates.SetWhereArgs(context->selectionArgs);
     predicates.SetOrder(context->order);
-    std::vector<std::string> columns;
+    std::vector<std::string> columns = FetchResult::GetFileAssetColumns();
     NAPI_DEBUG_LOG("GetNetworkId is = %{private}s", context->objectInfo->GetNetworkId().c_str());
     string queryUri = MEDIALIBRARY_DATA_ABILITY_PREFIX +
         context->objectInfo->GetNetworkId() + MEDIALIBRARY_DATA_URI_IDENTIFIER;
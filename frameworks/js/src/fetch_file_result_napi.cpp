@@ -62,6 +62,7 @@ napi_value FetchFileResultNapi::Init(napi_env env, napi_value exports)
         DECLARE_NAPI_FUNCTION("getLastObject", JSGetLastObject),
         DECLARE_NAPI_FUNCTION("getPositionObject", JSGetPositionObject),
         DECLARE_NAPI_FUNCTION("getAllObject", JSGetAllObject),
+        DECLARE_NAPI_FUNCTION("getObjectRange", JSGetObjectRange),
         DECLARE_NAPI_FUNCTION("close", JSClose)
     };
 
@@ -97,8 +98,8 @@ napi_value FetchFileResultNapi::FetchFileResultNapiConstructor(napi_env env, nap
             obj->env_ = env;
 
             if (sFetchFileResult_ != nullptr) {
-                unique_ptr<FetchResult> fetchRes = make_unique<FetchResult>(
-                    move(sFetchFileResult_->resultset_));
+                unique_ptr<FetchResult> fetchRes = make_unique<FetchResult>(sFetchFileResult_->GetResultSet());
+                sFetchFileResult_->SetResultSet(nullptr);
                 obj->fetchFileResult_ = std::move(fetchRes);
                 obj->fetchFileResult_->isContain_ = sFetchFileResult_->isContain_;
                 obj->fetchFileResult_->isClosed_ = sFetchFileResult_->isClosed_;
@@ -534,6 +535,108 @@ napi_value FetchFileResultNapi::JSGetAllObject(napi_env env, napi_callback_info
     return result;
 }
 
+// Only the requested window is decoded and turned into js objects, an empty window is not an error
+static void GetObjectRangeCompleteCallback(napi_env env, napi_status status, FetchFileResultAsyncContext* context)
+{
+    napi_value jsFileArray = nullptr;
+
+    CHECK_NULL_PTR_RETURN_VOID(context, "Async context is null");
+
+    unique_ptr<JSAsyncContextOutput> jsContext = make_unique<JSAsyncContextOutput>();
+    jsContext->status = false;
+
+    if (napi_create_array_with_length(env, context->fileAssetArray.size(), &jsFileArray) == napi_ok) {
+        size_t len = context->fileAssetArray.size();
+        size_t i = 0;
+        for (i = 0; i < len; i++) {
+            napi_value jsFileAsset = FileAssetNapi::CreateFileAsset(env, *(context->fileAssetArray[i]),
+                context->objectInfo->GetMediaDataHelper());
+            if (jsFileAsset == nullptr || napi_set_element(env, jsFileArray, i, jsFileAsset) != napi_ok) {
+                NAPI_ERR_LOG("Failed to get file asset napi object");
+                napi_get_undefined(env, &jsContext->data);
+                MediaLibraryNapiUtils::CreateNapiErrorObject(env, jsContext->error, ERR_MEM_ALLOCATION,
+                    "Failed to create js object for FileAsset");
+                break;
+            }
+        }
+
+        if (i == len) {
+            jsContext->data = jsFileArray;
+            napi_get_undefined(env, &jsContext->error);
+            jsContext->status = true;
+        }
+    } else {
+        NAPI_ERR_LOG("Failed to create js array");
+        napi_get_undefined(env, &jsContext->data);
+        MediaLibraryNapiUtils::CreateNapiErrorObject(env, jsContext->error, ERR_MEM_ALLOCATION,
+            "Failed to create js array for FileAsset");
+    }
+
+    if (context->work != nullptr) {
+        MediaLibraryNapiUtils::InvokeJSAsyncMethod(env, context->deferred, context->callbackRef,
+                                                   context->work, *jsContext);
+    }
+    delete context;
+}
+
+napi_value FetchFileResultNapi::JSGetObjectRange(napi_env env, napi_callback_info info)
+{
+    napi_status status;
+    napi_value result = nullptr;
+    const int32_t refCount = 1;
+    napi_valuetype offsetType = napi_undefined;
+    napi_valuetype countType = napi_undefined;
+    napi_value resource = nullptr;
+    size_t argc = ARGS_THREE;
+    napi_value argv[ARGS_THREE] = {0};
+    napi_value thisVar = nullptr;
+
+    GET_JS_ARGS(env, info, argc, argv, thisVar);
+    NAPI_ASSERT(env, (argc == ARGS_TWO || argc == ARGS_THREE), "requires 3 parameters maximum");
+
+    napi_get_undefined(env, &result);
+    unique_ptr<FetchFileResultAsyncContext> asyncContext = make_unique<FetchFileResultAsyncContext>();
+    status = napi_unwrap(env, thisVar, reinterpret_cast<void**>(&asyncContext->objectInfo));
+    if (status == napi_ok && asyncContext->objectInfo != nullptr) {
+        // Check the arguments and their types
+        napi_typeof(env, argv[PARAM0], &offsetType);
+        napi_typeof(env, argv[PARAM1], &countType);
+        if (offsetType == napi_number && countType == napi_number) {
+            napi_get_value_int32(env, argv[PARAM0], &(asyncContext->position));
+            napi_get_value_int32(env, argv[PARAM1], &(asyncContext->rangeCount));
+        } else {
+            NAPI_ERR_LOG("Argument mismatch, type: %{private}d %{private}d", offsetType, countType);
+            return result;
+        }
+
+        if (argc == ARGS_THREE) {
+            GET_JS_ASYNC_CB_REF(env, argv[PARAM2], refCount, asyncContext->callbackRef);
+        }
+
+        NAPI_CREATE_PROMISE(env, asyncContext->callbackRef, asyncContext->deferred, result);
+        NAPI_CREATE_RESOURCE_NAME(env, resource, "JSGetObjectRange");
+        status = napi_create_async_work(
+            env, nullptr, resource, [](napi_env env, void* data) {
+                auto context = static_cast<FetchFileResultAsyncContext*>(data);
+                context->fileAssetArray = context->objectInfo->fetchFileResult_->GetObjectRange(context->position,
+                    context->rangeCount);
+            },
+            reinterpret_cast<napi_async_complete_callback>(GetObjectRangeCompleteCallback),
+            static_cast<void*>(asyncContext.get()), &asyncContext->work);
+        if (status != napi_ok) {
+            napi_get_undefined(env, &result);
+        } else {
+            napi_queue_async_work(env, asyncContext->work);
+            asyncContext.release();
+        }
+    } else {
+        NAPI_ERR_LOG("JSGetObjectRange obj == nullptr, status: %{private}d", status);
+        NAPI_ASSERT(env, false, "JSGetObjectRange obj == nullptr");
+    }
+
+    return result;
+}
+
 napi_value FetchFileResultNapi::JSClose(napi_env env, napi_callback_info info)
 {
     napi_status status;
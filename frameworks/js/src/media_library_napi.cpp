@@ -567,7 +567,7 @@ napi_value MediaLibraryNapi::JSGetPublicDirectory(napi_env env, napi_callback_in
 static void GetFileAssetsExecute(MediaLibraryAsyncContext *context)
 {
     CHECK_NULL_PTR_RETURN_VOID(context, "Async context is null");
-    vector<string> columns;
+    vector<string> columns = FetchResult::GetFileAssetColumns();
     DataShare::DataSharePredicates predicates;
     if (!context->uri.empty()) {
         NAPI_ERR_LOG("context->uri is = %{private}s", context->uri.c_str());
@@ -767,7 +767,8 @@ static void SetAlbumCoverUri(MediaLibraryAsyncContext *context, unique_ptr<Album
     predicates.SetWhereClause(MEDIA_DATA_DB_BUCKET_ID + " = " + std::to_string(album->GetAlbumId()));
     predicates.OrderByDesc(MEDIA_DATA_DB_DATE_ADDED);
     predicates.Limit(1, 0);
-    vector<string> columns;
+    // Only the uri of the cover is kept
+    vector<string> columns = { MEDIA_DATA_DB_ID, MEDIA_DATA_DB_MEDIA_TYPE };
     string queryUri = MEDIALIBRARY_DATA_URI;
     if (!context->networkId.empty()) {
         queryUri = MEDIALIBRARY_DATA_ABILITY_PREFIX + context->networkId + MEDIALIBRARY_DATA_URI_IDENTIFIER;
@@ -808,6 +809,38 @@ void SetAlbumData(AlbumAsset* albumData, shared_ptr<DataShare::DataShareResultSe
                                                                   resultSet, TYPE_INT64)));
 }
 
+// Columns SetAlbumData and SetAlbumCoverFromResult read from the album query
+static const vector<string> &GetAlbumColumns()
+{
+    static const vector<string> albumColumns = {
+        MEDIA_DATA_DB_BUCKET_ID, MEDIA_DATA_DB_TITLE, MEDIA_DATA_DB_COUNT, MEDIA_DATA_DB_RELATIVE_PATH,
+        MEDIA_DATA_DB_DATE_MODIFIED, MEDIA_DATA_DB_COVER_ID, MEDIA_DATA_DB_COVER_MEDIA_TYPE
+    };
+    return albumColumns;
+}
+
+// The album query carries the id and media type of the latest asset of every album
+static bool SetAlbumCoverFromResult(AlbumAsset *albumData, shared_ptr<DataShare::DataShareResultSet> &resultSet,
+    const string &networkId)
+{
+    int32_t coverIdIndex = -1;
+    int32_t coverMediaTypeIndex = -1;
+    if ((resultSet->GetColumnIndex(MEDIA_DATA_DB_COVER_ID, coverIdIndex) != NativeRdb::E_OK) ||
+        (resultSet->GetColumnIndex(MEDIA_DATA_DB_COVER_MEDIA_TYPE, coverMediaTypeIndex) != NativeRdb::E_OK)) {
+        return false;
+    }
+
+    int32_t coverId = 0;
+    int32_t coverMediaType = MEDIA_TYPE_FILE;
+    resultSet->GetInt(coverIdIndex, coverId);
+    resultSet->GetInt(coverMediaTypeIndex, coverMediaType);
+    if (coverId > 0) {
+        albumData->SetCoverUri(GetFileMediaTypeUri(static_cast<MediaType>(coverMediaType), networkId) +
+            "/" + to_string(coverId));
+    }
+    return true;
+}
+
 static void GetResultDataExecute(MediaLibraryAsyncContext *context)
 {
     NAPI_ERR_LOG("GetResultDataExecute IN");
@@ -828,7 +861,7 @@ static void GetResultDataExecute(MediaLibraryAsyncContext *context)
         sharePredicates.SetOrder(context->order);
     }
 
-    vector<string> columns;
+    vector<string> columns = GetAlbumColumns();
     string queryUri = MEDIALIBRARY_DATA_URI + "/" + MEDIA_ALBUMOPRN_QUERYALBUM;
     if (!context->networkId.empty()) {
         queryUri = MEDIALIBRARY_DATA_ABILITY_PREFIX + context->networkId +
@@ -848,7 +881,9 @@ static void GetResultDataExecute(MediaLibraryAsyncContext *context)
         unique_ptr<AlbumAsset> albumData = make_unique<AlbumAsset>();
         if (albumData != nullptr) {
              SetAlbumData(albumData.get(), resultSet, context->networkId);
-             SetAlbumCoverUri(context, albumData);
+             if (!SetAlbumCoverFromResult(albumData.get(), resultSet, context->networkId)) {
+                 SetAlbumCoverUri(context, albumData);
+             }
              context->albumNativeArray.push_back(move(albumData));
 	}
     }
@@ -933,7 +968,7 @@ napi_value MediaLibraryNapi::JSGetAlbums(napi_env env, napi_callback_info info)
 static void getFileAssetById(int32_t id, const string& networkId, MediaLibraryAsyncContext *context)
 {
     CHECK_NULL_PTR_RETURN_VOID(context, "Async context is null");
-    vector<string> columns;
+    vector<string> columns = FetchResult::GetFileAssetColumns();
     DataShare::DataSharePredicates predicates;
 
     predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + to_string(id));
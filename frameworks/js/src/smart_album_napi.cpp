@@ -14,6 +14,11 @@
  */
 
 #include "smart_album_napi.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include "medialibrary_data_manager_utils.h"
 #include "medialibrary_napi_log.h"
 #include "media_file_utils.h"
 
@@ -454,6 +459,19 @@ static void CommitModifyNative(const SmartAlbumNapiAsyncContext &albumContext)
     }
     context->changedRows = changedRows;
 }
+// One statement for all the assets of the call: file_id IN (?,?,...)
+static void SetAssetIdsPredicates(const vector<int32_t> &assetIds, DataShare::DataSharePredicates &predicates)
+{
+    string placeholders;
+    vector<string> whereArgs;
+    for (auto assetId : assetIds) {
+        placeholders += placeholders.empty() ? "?" : ",?";
+        whereArgs.push_back(to_string(assetId));
+    }
+    predicates.SetWhereClause(MEDIA_DATA_DB_ID + " IN (" + placeholders + ")");
+    predicates.SetWhereArgs(whereArgs);
+}
+
 static void SetFileFav(bool isFavourite, SmartAlbumNapiAsyncContext *context)
 {
     NAPI_DEBUG_LOG("SetFileFav IN");
@@ -463,14 +481,9 @@ static void SetFileFav(bool isFavourite, SmartAlbumNapiAsyncContext *context)
     int32_t changedRows;
     values.PutBool(MEDIA_DATA_DB_IS_FAV, isFavourite);
     Uri uri(abilityUri);
-    DataShare::DataShareValueObject valueObject;
-    int32_t fileId = 0;
-    context->valuesBucket.GetObject(SMARTALBUMMAP_DB_ASSET_ID, valueObject);
-    valueObject.GetInt(fileId);
 
     DataShare::DataSharePredicates predicates;
-
-    predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + std::to_string(fileId));
+    SetAssetIdsPredicates(context->assetIds, predicates);
     changedRows = context->objectInfo->GetMediaDataHelper()->Update(uri, predicates, values);
     context->changedRows = changedRows;
     NAPI_DEBUG_LOG("SetFileFav OUT  = %{private}d", changedRows);
@@ -491,40 +504,35 @@ static void SetFileTrash(bool isTrash, SmartAlbumNapiAsyncContext *context)
     }
 
     Uri uri(abilityUri);
-    DataShare::DataShareValueObject valueObject;
-    int32_t fileId = 0;
-    context->valuesBucket.GetObject(SMARTALBUMMAP_DB_ASSET_ID, valueObject);
-    valueObject.GetInt(fileId);
 
     DataShare::DataSharePredicates predicates;
-
-    predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + std::to_string(fileId));
+    SetAssetIdsPredicates(context->assetIds, predicates);
     changedRows = context->objectInfo->GetMediaDataHelper()->Update(uri, predicates, values);
     context->changedRows = changedRows;
     NAPI_DEBUG_LOG("SetFileTrash OUT  = %{private}d", changedRows);
 }
 
-static void AddAssetNative(SmartAlbumNapiAsyncContext *context)
+// All the map rows of the call go in one BatchInsert, the service writes them in one transaction
+static void SmartAlbumMapBatchNative(const string &oprn, SmartAlbumNapiAsyncContext *context)
 {
     CHECK_NULL_PTR_RETURN_VOID(context, "Async context is null");
-    context->valuesBucket.PutInt(SMARTALBUMMAP_DB_ALBUM_ID, context->objectInfo->GetSmartAlbumId());
-    int32_t changedRows;
-    Uri AddAsseturi(MEDIALIBRARY_DATA_URI + "/"
-    + MEDIA_SMARTALBUMMAPOPRN + "/" + MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM);
-    changedRows =
-        context->objectInfo->GetMediaDataHelper()->Insert(AddAsseturi, context->valuesBucket);
-    context->changedRows = changedRows;
+    vector<DataShare::DataShareValuesBucket> values;
+    for (auto assetId : context->assetIds) {
+        DataShare::DataShareValuesBucket value;
+        value.PutInt(SMARTALBUMMAP_DB_ALBUM_ID, context->objectInfo->GetSmartAlbumId());
+        value.PutInt(SMARTALBUMMAP_DB_ASSET_ID, assetId);
+        values.push_back(value);
+    }
+    Uri batchUri(MEDIALIBRARY_DATA_URI + "/" + MEDIA_SMARTALBUMMAPOPRN + "/" + oprn);
+    context->changedRows = context->objectInfo->GetMediaDataHelper()->BatchInsert(batchUri, values);
+}
+static void AddAssetNative(SmartAlbumNapiAsyncContext *context)
+{
+    SmartAlbumMapBatchNative(MEDIA_SMARTALBUMMAPOPRN_ADDSMARTALBUM, context);
 }
 static void RemoveAssetNative(SmartAlbumNapiAsyncContext *context)
 {
-    CHECK_NULL_PTR_RETURN_VOID(context, "Async context is null");
-    context->valuesBucket.PutInt(SMARTALBUMMAP_DB_ALBUM_ID, context->objectInfo->GetSmartAlbumId());
-    int32_t changedRows;
-    Uri RemoveAsseturi(MEDIALIBRARY_DATA_URI + "/"
-    + MEDIA_SMARTALBUMMAPOPRN + "/" + MEDIA_SMARTALBUMMAPOPRN_REMOVESMARTALBUM);
-    changedRows =
-        context->objectInfo->GetMediaDataHelper()->Insert(RemoveAsseturi, context->valuesBucket);
-    context->changedRows = changedRows;
+    SmartAlbumMapBatchNative(MEDIA_SMARTALBUMMAPOPRN_REMOVESMARTALBUM, context);
 }
 static void JSCommitModifyCompleteCallback(napi_env env, napi_status status, SmartAlbumNapiAsyncContext *context)
 {
@@ -575,6 +583,9 @@ static void JSAddAssetCompleteCallback(napi_env env, napi_status status, SmartAl
         napi_create_int32(env, context->changedRows, &jsContext->data);
         napi_get_undefined(env, &jsContext->error);
         jsContext->status = true;
+        // One notification for all the assets of the call
+        Uri notifyUri(MEDIALIBRARY_SMARTALBUM_CHANGE_URI);
+        context->objectInfo->GetMediaDataHelper()->NotifyChange(notifyUri);
     } else {
         napi_get_undefined(env, &jsContext->data);
         MediaLibraryNapiUtils::CreateNapiErrorObject(env, jsContext->error, ERR_INVALID_OUTPUT,
@@ -597,6 +608,9 @@ static void JSRemoveAssetCompleteCallback(napi_env env, napi_status status, Smar
         napi_create_int32(env, context->changedRows, &jsContext->data);
         napi_get_undefined(env, &jsContext->error);
         jsContext->status = true;
+        // One notification for all the assets of the call
+        Uri notifyUri(MEDIALIBRARY_SMARTALBUM_CHANGE_URI);
+        context->objectInfo->GetMediaDataHelper()->NotifyChange(notifyUri);
     } else {
         napi_get_undefined(env, &jsContext->data);
         MediaLibraryNapiUtils::CreateNapiErrorObject(env, jsContext->error, ERR_INVALID_OUTPUT,
@@ -632,6 +646,41 @@ static napi_value ConvertCommitJSArgsToNative(napi_env env, size_t argc, const n
     napi_get_boolean(env, true, &result);
     return result;
 }
+static bool GetAssetIdFromUri(const string &assetUri, int32_t &assetId)
+{
+    string::size_type pos = assetUri.find_last_of('/');
+    string strRow = (pos == string::npos) ? assetUri : assetUri.substr(pos + 1);
+    if (!MediaLibraryDataManagerUtils::IsNumber(strRow)) {
+        NAPI_ERR_LOG("Invalid asset uri %{private}s", assetUri.c_str());
+        return false;
+    }
+    errno = 0;
+    long rowId = strtol(strRow.c_str(), nullptr, 10); /* 10 means decimal */
+    if ((errno == ERANGE) || (rowId <= 0) || (rowId > INT32_MAX)) {
+        NAPI_ERR_LOG("Asset id out of range %{private}s", assetUri.c_str());
+        return false;
+    }
+    assetId = static_cast<int32_t>(rowId);
+    return true;
+}
+static bool GetAssetIdsFromArray(napi_env env, napi_value array, SmartAlbumNapiAsyncContext &asyncContext)
+{
+    uint32_t len = 0;
+    size_t res = 0;
+    char buffer[PATH_MAX];
+    napi_value stringItem = nullptr;
+    napi_get_array_length(env, array, &len);
+    for (uint32_t i = 0; i < len; i++) {
+        int32_t assetId = 0;
+        if ((napi_get_element(env, array, i, &stringItem) != napi_ok) ||
+            (napi_get_value_string_utf8(env, stringItem, buffer, PATH_MAX, &res) != napi_ok) ||
+            !GetAssetIdFromUri(string(buffer), assetId)) {
+            return false;
+        }
+        asyncContext.assetIds.push_back(assetId);
+    }
+    return true;
+}
 napi_value GetJSArgsForAsset(napi_env env, size_t argc,
                              const napi_value argv[],
                              SmartAlbumNapiAsyncContext &asyncContext)
@@ -641,6 +690,7 @@ napi_value GetJSArgsForAsset(napi_env env, size_t argc,
     auto context = &asyncContext;
     size_t res = 0;
     char buffer[PATH_MAX];
+    bool isArray = false;
 
     NAPI_ASSERT(env, argv != nullptr, "Argument list is empty");
 
@@ -650,6 +700,11 @@ napi_value GetJSArgsForAsset(napi_env env, size_t argc,
 
         if (i == PARAM0 && valueType == napi_string) {
             napi_get_value_string_utf8(env, argv[i], buffer, PATH_MAX, &res);
+            int32_t assetId = 0;
+            NAPI_ASSERT(env, GetAssetIdFromUri(string(buffer), assetId), "Invalid asset uri");
+            context->assetIds.push_back(assetId);
+        } else if (i == PARAM0 && napi_is_array(env, argv[i], &isArray) == napi_ok && isArray) {
+            NAPI_ASSERT(env, GetAssetIdsFromArray(env, argv[i], asyncContext), "Invalid asset uri list");
         } else if (i == PARAM1 && valueType == napi_function) {
             napi_create_reference(env, argv[i], refCount, &context->callbackRef);
             break;
@@ -657,11 +712,7 @@ napi_value GetJSArgsForAsset(napi_env env, size_t argc,
             NAPI_ASSERT(env, false, "type mismatch");
         }
     }
-    std::string coverUri = string(buffer);
-    std::string strRow;
-    string::size_type pos = coverUri.find_last_of('/');
-    strRow = coverUri.substr(pos + 1);
-    context->valuesBucket.PutInt(SMARTALBUMMAP_DB_ASSET_ID, std::stoi(strRow));
+    NAPI_ASSERT(env, !context->assetIds.empty(), "No asset to add or remove");
     // Return true napi_value if params are successfully obtained
     napi_get_boolean(env, true, &result);
     return result;
@@ -900,7 +951,7 @@ static void GetTrashFileAssetsNative(SmartAlbumNapiAsyncContext *context)
     predicates.SetWhereArgs(context->selectionArgs);
     predicates.SetOrder(context->order);
 
-    std::vector<std::string> columns;
+    std::vector<std::string> columns = FetchResult::GetFileAssetColumns();
     Uri uri(MEDIALIBRARY_DATA_URI);
     std::shared_ptr<OHOS::DataShare::DataShareResultSet> resultSet =
         context->objectInfo->GetMediaDataHelper()->Query(uri, predicates, columns);
@@ -921,7 +972,7 @@ static void GetFavFileAssetsNative(SmartAlbumNapiAsyncContext *context)
     predicates.SetWhereClause(context->selection);
     predicates.SetWhereArgs(context->selectionArgs);
     predicates.SetOrder(context->order);
-    std::vector<std::string> columns;
+    std::vector<std::string> columns = FetchResult::GetFileAssetColumns();
     Uri uri(MEDIALIBRARY_DATA_URI);
 
     std::shared_ptr<OHOS::DataShare::DataShareResultSet> resultSet =
@@ -942,7 +993,7 @@ static void GetFileAssetsNative(SmartAlbumNapiAsyncContext *context)
     predicates.SetWhereClause(context->selection);
     predicates.SetWhereArgs(context->selectionArgs);
     predicates.SetOrder(context->order);
-    std::vector<std::string> columns;
+    std::vector<std::string> columns = FetchResult::GetFileAssetColumns();
     Uri uri(MEDIALIBRARY_DATA_URI + "/"
                + MEDIA_ALBUMOPRN_QUERYALBUM + "/"
                + ASSETMAP_VIEW_NAME);
@@ -16,6 +16,7 @@
 #include "medialibrary_data_ability.h"
 
 #include <unordered_set>
+#include <vector>
 
 #include "accesstoken_kit.h"
 #include "bytrace.h"
@@ -24,6 +25,7 @@
 #include "ipc_singleton.h"
 #include "ipc_skeleton.h"
 #include "media_file_utils.h"
+#include "medialibrary_album_stats.h"
 #include "medialibrary_sync_table.h"
 #include "media_log.h"
 #include "sa_mgr_client.h"
@@ -49,6 +51,18 @@ const std::unordered_set<std::string> SYSTEM_BUNDLE_FREE_CHECK {
     "com.ohos.screenshot"
 };
 std::mutex bundleMgrMutex;
+
+int32_t ExecuteSqls(RdbStore &store, const std::vector<std::string> &sqls)
+{
+    for (const auto &sql : sqls) {
+        int32_t errCode = store.ExecuteSql(sql);
+        if (errCode != NativeRdb::E_OK) {
+            MEDIA_ERR_LOG("Execute sql failed %{public}d, sql: %{private}s", errCode, sql.c_str());
+            return errCode;
+        }
+    }
+    return NativeRdb::E_OK;
+}
 }
 const std::string MediaLibraryDataAbility::PERMISSION_NAME_READ_MEDIA = "ohos.permission.READ_MEDIA";
 const std::string MediaLibraryDataAbility::PERMISSION_NAME_WRITE_MEDIA = "ohos.permission.WRITE_MEDIA";
@@ -137,6 +151,10 @@ int32_t MediaLibraryDataCallBack::OnCreate(RdbStore &store)
     if (error_code == NativeRdb::E_OK) {
         error_code = store.ExecuteSql(CREATE_CATEGORY_SMARTALBUMMAP_TABLE);
     }
+    if (error_code == NativeRdb::E_OK) {
+        // The Album and SmartAlbumAssets views read the counts from AlbumStats
+        error_code = ExecuteSqls(store, MediaLibraryAlbumStats::GetCreateSqls());
+    }
     if (error_code == NativeRdb::E_OK) {
         error_code = store.ExecuteSql(CREATE_IMAGE_VIEW);
     }
@@ -163,6 +181,21 @@ int32_t MediaLibraryDataCallBack::OnCreate(RdbStore &store)
 
 int32_t MediaLibraryDataCallBack::OnUpgrade(RdbStore &store, int32_t oldVersion, int32_t newVersion)
 {
+    int32_t errCode = NativeRdb::E_OK;
+    if (oldVersion < MEDIA_RDB_VERSION_ALBUM_STATS) {
+        // The Album and SmartAlbumAssets views of this version read AlbumStats, fill it and create them again
+        errCode = ExecuteSqls(store, MediaLibraryAlbumStats::GetRebuildSqls());
+        if (errCode == NativeRdb::E_OK) {
+            errCode = ExecuteSqls(store, { "DROP VIEW IF EXISTS " + ABLUM_VIEW_NAME, CREATE_ABLUM_VIEW,
+                "DROP VIEW IF EXISTS " + SMARTABLUMASSETS_VIEW_NAME, CREATE_SMARTABLUMASSETS_VIEW });
+        }
+    } else if (oldVersion < MEDIA_RDB_VERSION_ALBUM_STATS_TRIGGERS) {
+        errCode = ExecuteSqls(store, MediaLibraryAlbumStats::GetRecreateTriggerSqls());
+    }
+    if (errCode != NativeRdb::E_OK) {
+        MEDIA_ERR_LOG("Upgrade album stats error %{private}d", errCode);
+        return errCode;
+    }
 #ifdef RDB_UPGRADE_MOCK
     const std::string ALTER_MOCK_COLUMN = "ALTER TABLE " + MEDIALIBRARY_TABLE +
                                           " ADD COLUMN upgrade_test_column INT DEFAULT 0";
@@ -16,17 +16,35 @@
 #ifndef MEDIA_SCAN_EXECUTOR_H
 #define MEDIA_SCAN_EXECUTOR_H
 
-#include <string>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 namespace OHOS {
 namespace Media {
 using namespace std;
 
+// Single file scans are usually issued right after an app wrote the file and someone waits
+// for the result, so they always go ahead of the bulk directory scans. Removed paths only
+// drop their rows, which is as cheap as a file scan.
+enum ScanPriority : int32_t {
+    SCAN_PRIORITY_INTERACTIVE = 0,
+    SCAN_PRIORITY_BULK,
+    SCAN_PRIORITY_COUNT
+};
+
 class ScanRequest {
 public:
-    ScanRequest(string path) : requestId_(0), path_(path), isDir_(false) {}
+    ScanRequest(string path)
+        : requestId_(0), path_(path), isDir_(false), isRemoved_(false),
+        isCancelled_(make_shared<atomic<bool>>(false)) {}
     ScanRequest() : ScanRequest("") {}
     ~ScanRequest() = default;
 
@@ -55,29 +73,86 @@ public:
         return isDir_;
     }
 
+    // The path was gone when the request was made
+    void SetIsRemoved(bool isRemoved)
+    {
+        isRemoved_ = isRemoved;
+    }
+
+    bool GetIsRemoved() const
+    {
+        return isRemoved_;
+    }
+
+    ScanPriority GetPriority() const
+    {
+        return (isDir_ && !isRemoved_) ? SCAN_PRIORITY_BULK : SCAN_PRIORITY_INTERACTIVE;
+    }
+
+    // Ids of later requests for the same path that were folded into this one while it was queued
+    const vector<int32_t> &GetMergedRequestIds() const
+    {
+        return mergedRequestIds_;
+    }
+
+    void AddMergedRequestId(int32_t requestId)
+    {
+        mergedRequestIds_.push_back(requestId);
+    }
+
+    // The flag is shared by all copies of the request, so a running scan sees a later cancel
+    void Cancel() const
+    {
+        isCancelled_->store(true);
+    }
+
+    bool IsCancelled() const
+    {
+        return isCancelled_->load();
+    }
+
+    const atomic<bool> &GetCancelFlag() const
+    {
+        return *isCancelled_;
+    }
+
 private:
     int32_t requestId_;
     string path_;
     bool isDir_;
+    bool isRemoved_;
+    vector<int32_t> mergedRequestIds_;
+    shared_ptr<atomic<bool>> isCancelled_;
 };
 
 class MediaScanExecutor {
 typedef void (*callback_func)(ScanRequest);
 public:
     MediaScanExecutor() = default;
-    ~MediaScanExecutor() = default;
+    ~MediaScanExecutor();
 
     void ExecuteScan(unique_ptr<ScanRequest> request);
     void SetCallbackFunction(callback_func cb_function);
+    void Stop();
 
 private:
-    const size_t MAX_THREAD = 1;
-    size_t activeThread_ = 0;
-    std::queue<unique_ptr<ScanRequest>> scanRequestQueue_;
+    const size_t MAX_THREAD = 2;
+    // Directory scans may occupy at most this many workers, the others stay free for file scans
+    const size_t MAX_BULK_THREAD = 1;
+
+    mutex queueLock_;
+    condition_variable queueCond_;
+    deque<unique_ptr<ScanRequest>> scanRequestQueue_[SCAN_PRIORITY_COUNT];
+    unordered_map<int32_t, ScanRequest> runningRequests_;
+    vector<thread> workers_;
+    size_t activeBulkThread_ = 0;
+    bool isStopped_ = false;
     callback_func cb_function_ = nullptr;
 
     void HandleScanExecution();
     void PrepareScanExecution();
+    unique_ptr<ScanRequest> PopScanRequest(unique_lock<mutex> &lock);
+    bool MergeDuplicateRequest(const ScanRequest &request);
 };
 } // namespace Media
 } // namespace OHOS
@@ -17,7 +17,10 @@
 #define MEDIA_SCANNER_OBJ_H
 
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <condition_variable>
+#include <deque>
 #include <dirent.h>
 #include <fcntl.h>
 #include <fstream>
@@ -25,6 +28,7 @@
 #include <iostream>
 #include <iterator>
 #include <limits.h>
+#include <mutex>
 #include <securec.h>
 #include <stdlib.h>
 #include <string>
@@ -38,6 +42,7 @@
 #include "media_scan_executor.h"
 #include "media_scanner_const.h"
 #include "media_scanner_db.h"
+#include "media_scanner_watcher.h"
 #include "metadata.h"
 #include "metadata_extractor.h"
 #include "scanner_utils.h"
@@ -52,6 +57,41 @@
 
 namespace OHOS {
 namespace Media {
+// A directory waiting to be walked, together with the album id of its parent
+struct WalkTask {
+    std::string path;
+    int32_t parentId;
+};
+
+// Per-worker state of the parallel walker: a task deque that other workers can steal
+// from and a local metadata batch merged into batchUpdate_ once it is full
+struct WalkWorker {
+    std::mutex taskLock;
+    std::deque<WalkTask> tasks;
+    std::vector<Metadata> batch;
+};
+
+// State of one scan request. Concurrent requests each have their own, so the rows one of them
+// visited are never mistaken for stale rows by the cleanup of another.
+struct WalkContext {
+    std::vector<std::unique_ptr<WalkWorker>> workers;
+    std::atomic<int32_t> pendingTasks {0};
+    std::atomic<bool> isAborted {false};
+    std::atomic<int32_t> errCode {ERR_SUCCESS};
+    std::mutex idleLock;
+    std::condition_variable idleCond;
+    // State of the files already in the db for the walked subtree, read only while walking
+    const FileSnapshotMap *snapshot = nullptr;
+    // Albums of the walked subtree by path, read only while walking
+    std::unordered_map<std::string, Metadata> albumMap;
+    // Cancel flag of the scan request being served, checked between directories
+    const std::atomic<bool> *isCancelled = nullptr;
+    // Rows under the scanned path before the walk, the ones left out of scannedIds are deleted afterwards
+    std::unordered_map<int32_t, MediaType> prevIds;
+    std::mutex scannedIdsLock;
+    std::unordered_set<int32_t> scannedIds;
+};
+
 /**
  * Media Scanner class for scanning files and folders in MediaLibrary Database
  * and updating the metadata for each media file
@@ -65,6 +105,8 @@ public:
     int32_t ScanFile(std::string &path, const sptr<IRemoteObject> &callback);
     int32_t ScanDir(std::string &path, const sptr<IRemoteObject> &callback);
     bool IsScannerRunning();
+    int32_t StartWatching(const std::string &rootPath);
+    void StopWatching();
     void SetAbilityContext(void);
     void ReleaseAbilityHelper();
 
@@ -78,38 +120,50 @@ private:
 
     void InitSkipList();
     void CheckIfFolderScanCompleted(const int32_t reqId);
-    void CleanupDirectory(const std::string &path);
+    void CleanupDirectory(WalkContext &context);
     void ExecuteScannerClientCallback(int32_t reqId, int32_t status, const std::string &uri, const string &path);
     void StoreCallbackObjInMap(int32_t reqId, sptr<IMediaScannerOperationCallback> &callback);
 
     bool CheckSkipScanList(const std::string &path);
-    bool IsFileScanned(Metadata &fileMetadata);
+    bool IsFileScanned(Metadata &fileMetadata, WalkContext &context);
     bool IsDirHidden(const std::string &path);
     bool IsDirHiddenRecursive(const std::string &path);
     bool InitScanner(void);
 
-    int32_t VisitFile(const Metadata &fileMetadata);
-    int32_t WalkFileTree(const std::string &path, int32_t parentId);
-    int32_t ScanFileContent(const std::string &path, const int32_t parentId);
+    int32_t VisitFile(const Metadata &fileMetadata, std::vector<Metadata> &batch, WalkContext &context);
+    int32_t WalkFileTree(const std::string &path, int32_t parentId, WalkContext &context);
+    int32_t WalkDirectory(WalkContext &context, size_t workerIndex, const WalkTask &task);
+    void WalkWorkerLoop(WalkContext &context, size_t workerIndex);
+    void PushWalkTask(WalkContext &context, size_t workerIndex, WalkTask task);
+    bool PopWalkTask(WalkContext &context, size_t workerIndex, WalkTask &task);
+    int32_t ScanFileContent(const std::string &path, const int32_t parentId, std::vector<Metadata> &batch,
+        WalkContext &context);
     int32_t ScanFileInternal(const std::string &path);
-    int32_t ScanDirInternal(const std::string &path);
-    int32_t StartBatchProcessingToDB();
-    int32_t StartBatchProcessIfFull();
-    int32_t BatchUpdateRequest(Metadata &fileMetadata);
+    int32_t ScanDirInternal(const std::string &path, const std::atomic<bool> &isCancelled);
+    int32_t RemoveFileInternal(const std::string &path);
+    int32_t RemoveDirInternal(const std::string &path);
+    int32_t StartBatchProcessingToDB(WalkContext &context);
+    int32_t MergeBatch(std::vector<Metadata> &batch, WalkContext &context);
+    int32_t BatchUpdateRequest(Metadata &fileMetadata, std::vector<Metadata> &batch, WalkContext &context);
     int32_t RetrieveMetadata(Metadata &fileMetadata);
     int32_t GetAvailableRequestId();
-    int32_t InsertAlbumInfo(std::string &albumPath, int32_t parentId, string &albumName);
+    int32_t InsertAlbumInfo(std::string &albumPath, int32_t parentId, string &albumName, WalkContext &context);
+    int32_t QueueScanRequest(const std::string &path, bool isDir, bool isRemoved,
+        const sptr<IRemoteObject> &remoteCallback);
+    void OnWatchedPathChanged(const std::string &path, bool isDir);
 
     bool isScannerInitDone_;
     MediaScanExecutor scanExector_;
+    MediaScannerWatcher watcher_;
     MetadataExtractor metadataExtract_;
-    std::unordered_map<std::string, Metadata> albumMap_;
 
-    std::string mediaUri_;
+    // Guards batchUpdate_, written by the walker workers and concurrent file scans
+    std::mutex scanLock_;
+    std::once_flag skipListFlag_;
     std::vector<size_t> skipList_;
-    std::unordered_set<int32_t> scannedIds_;
     std::vector<Metadata> batchUpdate_;
     std::unique_ptr<MediaScannerDb> mediaScannerDb_;
+    std::mutex cbMapLock_;
     std::unordered_map<int32_t, sptr<IMediaScannerOperationCallback>> scanResultCbMap_;
 };
 } // namespace Media
@@ -38,6 +38,18 @@ namespace Media {
 using namespace std;
 using namespace DataShare;
 
+// Last scanned state of a file, looked up by the hash of its path while a directory is scanned
+struct FileSnapshot {
+    int32_t fileId;
+    int32_t parentId;
+    std::string name;
+    int64_t size;
+    int64_t dateModified;
+    // Set when two paths of the subtree hash alike, the file is then checked against the db
+    bool isHashCollided;
+};
+using FileSnapshotMap = unordered_map<size_t, FileSnapshot>;
+
 class MediaScannerDb {
 public:
     MediaScannerDb();
@@ -53,13 +65,14 @@ public:
     string InsertMetadata(const Metadata &metadata);
     string UpdateMetadata(const Metadata &metadata);
     string GetFileDBUriFromPath(const string &path);
-    vector<string> BatchInsert(const vector<Metadata> &metadataList);
+    vector<string> BatchUpsertMetadata(const vector<Metadata> &metadataList);
 
     int32_t UpdateMetadata(const vector<Metadata> &metadataList);
     int32_t GetIdFromUri(const string &path) const;
     int32_t InsertAlbum(const Metadata &metadata);
     int32_t UpdateAlbum(const Metadata &metadata);
     void ReadAlbums(const string &path, unordered_map<string, Metadata> &albumMap);
+    void ReadFileSnapshots(const string &path, FileSnapshotMap &snapshotMap);
     int32_t ReadAlbumId(const string &path);
     unique_ptr<Metadata> ReadMetadata(const string &path);
     unique_ptr<Metadata> GetFileModifiedInfo(const string &path);
@@ -69,6 +82,7 @@ public:
 
 private:
     std::string GetMediaTypeUri(MediaType mediaType);
+    void SetValuesFromMetaData(const Metadata &metadata, DataShareValuesBucket &values);
     std::unique_ptr<Metadata> FillMetadata(const shared_ptr<DataShare::DataShareResultSet> &resultSet);
 };
 } // namespace Media
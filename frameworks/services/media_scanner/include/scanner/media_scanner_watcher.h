@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEDIA_SCANNER_WATCHER_H
+#define MEDIA_SCANNER_WATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct inotify_event;
+
+namespace OHOS {
+namespace Media {
+/**
+ * Watches a directory tree with inotify and reports the touched paths once the
+ * changes have settled, so the scanner only rescans what actually changed
+ *
+ * @since 1.0
+ * @version 1.0
+ */
+class MediaScannerWatcher {
+public:
+    // Called from the watcher thread with a changed path, isDir asks for a directory scan
+    using ChangeCallback = std::function<void(const std::string &path, bool isDir)>;
+
+    MediaScannerWatcher() = default;
+    ~MediaScannerWatcher();
+    MediaScannerWatcher(const MediaScannerWatcher &) = delete;
+    MediaScannerWatcher &operator=(const MediaScannerWatcher &) = delete;
+
+    int32_t Start(const std::string &rootPath, ChangeCallback callback);
+    void Stop();
+    bool IsRunning() const;
+
+private:
+    void WatchLoop();
+    void AddWatchRecursive(const std::string &path);
+    void RemoveWatchRecursive(const std::string &path);
+    void HandleEvent(const struct inotify_event &event);
+    void AddPendingChange(const std::string &path, bool isDir);
+    void FlushPendingChanges();
+    int32_t GetPollTimeout() const;
+
+    int32_t inotifyFd_ = -1;
+    int32_t stopFd_ = -1;
+    std::string rootPath_;
+    std::thread watchThread_;
+    std::atomic<bool> isRunning_ {false};
+    ChangeCallback callback_;
+
+    // Only touched by the watcher thread once it is started
+    std::unordered_map<int32_t, std::string> watchedDirs_;
+    std::unordered_map<std::string, bool> pendingChanges_;
+    std::chrono::steady_clock::time_point firstPendingTime_;
+    std::chrono::steady_clock::time_point lastPendingTime_;
+};
+} // namespace Media
+} // namespace OHOS
+
+#endif // MEDIA_SCANNER_WATCHER_H
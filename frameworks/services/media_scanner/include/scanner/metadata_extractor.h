@@ -17,9 +17,11 @@
 #define METADATA_EXTRACTOR_H
 
 #include <fcntl.h>
+#include <mutex>
 #include <sstream>
 #include <string.h>
 #include <unistd.h>
+#include <vector>
 
 #include "avmetadatahelper.h"
 #include "image_source.h"
@@ -38,6 +40,15 @@ public:
     int32_t ConvertStringToInteger(const std::string &str);
     void FillExtractedMetadata(const std::unordered_map<int32_t, std::string> &metadataMap,
                                Metadata &fileMetadata);
+    static bool ProbeImageSize(const std::string &path, int32_t &width, int32_t &height);
+
+private:
+    std::shared_ptr<AVMetadataHelper> AcquireMetadataHelper();
+    void RecycleMetadataHelper(std::shared_ptr<AVMetadataHelper> &avMetadataHelper);
+
+    // Helpers are reused across files, the walker workers extract concurrently
+    std::mutex helperLock_;
+    std::vector<std::shared_ptr<AVMetadataHelper>> idleHelpers_;
 };
 } // namespace Media
 } // namespace OHOS
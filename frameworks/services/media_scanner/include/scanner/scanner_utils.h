@@ -35,10 +35,20 @@ enum ErrorCodes {
     ERR_INCORRECT_PATH,
     ERR_MEM_ALLOC_FAIL,
     ERR_MIMETYPE_NOTSUPPORT,
-    ERR_SCAN_NOT_INIT
+    ERR_SCAN_NOT_INIT,
+    ERR_SCAN_CANCELLED
 };
 
 const int32_t MAX_BATCH_SIZE = 5;
+const uint32_t MAX_WALKER_THREADS = 4;
+const int32_t WALKER_IDLE_WAIT_MS = 10;
+const size_t MAX_METADATA_HELPERS = MAX_WALKER_THREADS;
+
+// Const for the file change watcher
+const int32_t WATCHER_DEBOUNCE_MS = 500;
+const int32_t WATCHER_MAX_DELAY_MS = 5000;
+const size_t WATCHER_MAX_PENDING = 1024;
+const size_t WATCHER_EVENT_BUF_SIZE = 4096;
 
 // Const for File Metadata defaults
 const std::string FILE_PATH_DEFAULT = "";
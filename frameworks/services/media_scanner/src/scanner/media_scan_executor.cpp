@@ -14,12 +14,16 @@
  */
 
 #include "media_scan_executor.h"
-#include <thread>
 
 namespace OHOS {
 namespace Media {
 using namespace std;
 
+MediaScanExecutor::~MediaScanExecutor()
+{
+    Stop();
+}
+
 void MediaScanExecutor::SetCallbackFunction(callback_func cb_function)
 {
     cb_function_ = cb_function;
@@ -27,29 +31,129 @@ void MediaScanExecutor::SetCallbackFunction(callback_func cb_function)
 
 void MediaScanExecutor::ExecuteScan(unique_ptr<ScanRequest> request)
 {
-    scanRequestQueue_.push(move(request));
-    PrepareScanExecution();
+    {
+        lock_guard<mutex> lock(queueLock_);
+        if (!isStopped_) {
+            if (!MergeDuplicateRequest(*request)) {
+                scanRequestQueue_[request->GetPriority()].push_back(move(request));
+                PrepareScanExecution();
+            }
+            request = nullptr;
+        }
+    }
+    if (request != nullptr) {
+        // Too late to run, the requester still gets its callback
+        request->Cancel();
+        cb_function_(*request);
+        return;
+    }
+    queueCond_.notify_one();
+}
+
+// A queued request for the same path has not started yet, so it will also pick up the
+// changes the new request is about. Only its callbacks need to be fired as well.
+bool MediaScanExecutor::MergeDuplicateRequest(const ScanRequest &request)
+{
+    for (auto &queued : scanRequestQueue_[request.GetPriority()]) {
+        if (!queued->IsCancelled() && (queued->GetPath() == request.GetPath()) &&
+            (queued->GetIsDirectory() == request.GetIsDirectory())) {
+            queued->AddMergedRequestId(request.GetRequestId());
+            for (int32_t requestId : request.GetMergedRequestIds()) {
+                queued->AddMergedRequestId(requestId);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Running requests stop at their next cancellation check. Queued ones never run, they are
+// completed as cancelled so that every requester still gets its callback.
+void MediaScanExecutor::Stop()
+{
+    vector<unique_ptr<ScanRequest>> dropped;
+    {
+        lock_guard<mutex> lock(queueLock_);
+        isStopped_ = true;
+        for (auto &running : runningRequests_) {
+            running.second.Cancel();
+        }
+        for (auto &queue : scanRequestQueue_) {
+            for (auto &queued : queue) {
+                queued->Cancel();
+                dropped.push_back(move(queued));
+            }
+            queue.clear();
+        }
+    }
+    queueCond_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    for (auto &request : dropped) {
+        cb_function_(*request);
+    }
+}
+
+// Called with queueLock_ held. Waits until a request may run: interactive ones whenever a worker
+// is free, bulk ones only while fewer than MAX_BULK_THREAD workers are busy with directories.
+unique_ptr<ScanRequest> MediaScanExecutor::PopScanRequest(unique_lock<mutex> &lock)
+{
+    auto &interactiveQueue = scanRequestQueue_[SCAN_PRIORITY_INTERACTIVE];
+    auto &bulkQueue = scanRequestQueue_[SCAN_PRIORITY_BULK];
+    queueCond_.wait(lock, [&]() {
+        return isStopped_ || !interactiveQueue.empty() || (!bulkQueue.empty() && activeBulkThread_ < MAX_BULK_THREAD);
+    });
+    if (isStopped_) {
+        return nullptr;
+    }
+
+    unique_ptr<ScanRequest> request = nullptr;
+    if (!interactiveQueue.empty()) {
+        request = move(interactiveQueue.front());
+        interactiveQueue.pop_front();
+    } else {
+        request = move(bulkQueue.front());
+        bulkQueue.pop_front();
+        activeBulkThread_++;
+    }
+    runningRequests_.emplace(request->GetRequestId(), *request);
+    return request;
 }
 
 void MediaScanExecutor::HandleScanExecution()
 {
-    while (!scanRequestQueue_.empty()) {
-        unique_ptr<ScanRequest> sr = std::move(scanRequestQueue_.front());
-        scanRequestQueue_.pop();
+    unique_lock<mutex> lock(queueLock_);
+    while (true) {
+        unique_ptr<ScanRequest> sr = PopScanRequest(lock);
+        if (sr == nullptr) {
+            break;
+        }
+
+        lock.unlock();
         cb_function_(*sr);
+        lock.lock();
+
+        runningRequests_.erase(sr->GetRequestId());
+        if (sr->GetPriority() == SCAN_PRIORITY_BULK) {
+            activeBulkThread_--;
+            queueCond_.notify_one();
+        }
     }
-    activeThread_--;
     return;
 }
 
+// Called with queueLock_ held. The workers are started on the first request and then kept
+// waiting on queueCond_, instead of spawning a thread per burst of requests.
 void MediaScanExecutor::PrepareScanExecution()
 {
-    size_t c = MAX_THREAD - activeThread_;
-    for (size_t i = 0; i < c; i++) {
-        if (!scanRequestQueue_.empty() && (activeThread_ < scanRequestQueue_.size())) {
-            std::thread(&MediaScanExecutor::HandleScanExecution, this).detach();
-            activeThread_++;
-        }
+    while (workers_.size() < MAX_THREAD) {
+        workers_.emplace_back(&MediaScanExecutor::HandleScanExecution, this);
     }
 }
 } // namespace Media
@@ -14,8 +14,11 @@
  */
 
 #include "media_scanner.h"
+#include <functional>
+#include <thread>
 #include "bytrace.h"
 #include "media_log.h"
+#include "medialibrary_album_cache.h"
 
 namespace OHOS {
 namespace Media {
@@ -71,21 +74,33 @@ void MediaScannerObj::ScanQueueCB(ScanRequest scanReq)
 
         string fileUri("");
         string path = scanReq.GetPath();
-        if (scanReq.GetIsDirectory()) {
+        if (scanReq.IsCancelled()) {
+            MEDIA_INFO_LOG("%{public}s: request %{public}d cancelled", __func__, scanReq.GetRequestId());
+            errCode = ERR_SCAN_CANCELLED;
+        } else if (!ScannerUtils::IsExists(path)) {
+            MEDIA_DEBUG_LOG("%{public}s: removed %{private}s", __func__, path.c_str());
+            errCode = scanReq.GetIsDirectory() ? scanner->RemoveDirInternal(path) : scanner->RemoveFileInternal(path);
+        } else if (scanReq.GetIsDirectory()) {
             StartTrace(BYTRACE_TAG_OHOS, "ScanDirInternal");
             MEDIA_DEBUG_LOG("%{public}s: dir %{private}s", __func__, path.c_str());
-            errCode = scanner->ScanDirInternal(const_cast<string &>(path));
+            errCode = scanner->ScanDirInternal(path, scanReq.GetCancelFlag());
             FinishTrace(BYTRACE_TAG_OHOS);
         } else {
             StartTrace(BYTRACE_TAG_OHOS, "ScanFileInternal");
             MEDIA_DEBUG_LOG("%{public}s: file %{private}s", __func__, path.c_str());
             errCode = scanner->ScanFileInternal(const_cast<string &>(path));
             FinishTrace(BYTRACE_TAG_OHOS);
-            fileUri = scanner->mediaUri_;
+            // File scans run alongside directory scans, so read the uri back instead of sharing the last one written
+            if (errCode == ERR_SUCCESS) {
+                fileUri = scanner->mediaScannerDb_->GetFileDBUriFromPath(path);
+            }
         }
 
         MEDIA_DEBUG_LOG("%{public}s: before callback", __func__);
         scanner->ExecuteScannerClientCallback(scanReq.GetRequestId(), errCode, fileUri, path);
+        for (int32_t reqId : scanReq.GetMergedRequestIds()) {
+            scanner->ExecuteScannerClientCallback(reqId, errCode, fileUri, path);
+        }
     }
 
      MEDIA_INFO_LOG("%{public}s:end", __func__);
@@ -125,7 +140,6 @@ vector<string> MediaScannerObj::GetSupportedMimeTypes()
 int32_t MediaScannerObj::ScanFile(string &path, const sptr<IRemoteObject> &remoteCallback)
 {
     MEDIA_INFO_LOG("%{private}s: %{private}s", __func__, path.c_str());
-    int32_t errCode = ERR_MEM_ALLOC_FAIL;
     bool isDir = false;
 
     if (path.empty()) {
@@ -135,13 +149,8 @@ int32_t MediaScannerObj::ScanFile(string &path, const sptr<IRemoteObject> &remot
 
     if (ScannerUtils::GetAbsolutePath(path) != ERR_SUCCESS) {
         MEDIA_ERR_LOG("Scanfile: Incorrect path or insufficient permission %{private}s", path.c_str());
-        unique_ptr<Metadata> metaData = mediaScannerDb_->ReadMetadata(path);
-        if (metaData != nullptr && !metaData->GetFilePath().empty()) {
-            vector<string> idList = {to_string(metaData->GetFileId())};
-            if (mediaScannerDb_->DeleteMetadata(idList)) {
-                mediaScannerDb_->NotifyDatabaseChange(metaData->GetFileMediaType());
-            }
-        }
+        // If the path is not available, a worker clears the same from database too if present
+        QueueScanRequest(path, isDir, true, nullptr);
         return ERR_INCORRECT_PATH;
     }
 
@@ -150,29 +159,11 @@ int32_t MediaScannerObj::ScanFile(string &path, const sptr<IRemoteObject> &remot
         return ERR_INCORRECT_PATH;
     }
 
-    unique_ptr<ScanRequest> scanReq = make_unique<ScanRequest>(path);
-    if (scanReq != nullptr) {
-        scanReq->SetIsDirectory(isDir);
-
-        int32_t reqId = GetAvailableRequestId();
-        scanReq->SetRequestId(reqId);
-
-        scanExector_.ExecuteScan(move(scanReq));
-
-        // After path validation and queue_ addition is success, add the callback object to callback map
-        sptr<IMediaScannerOperationCallback> callback = iface_cast<IMediaScannerOperationCallback>(remoteCallback);
-        if (callback != nullptr) {
-            StoreCallbackObjInMap(reqId, callback);
-            errCode = ERR_SUCCESS;
-        }
-    }
-
-    return errCode;
+    return QueueScanRequest(path, isDir, false, remoteCallback);
 }
 
 int32_t MediaScannerObj::ScanDir(string &path, const sptr<IRemoteObject> &remoteCallback)
 {
-    int32_t errCode = ERR_MEM_ALLOC_FAIL;
     bool isDir = true;
 
     MEDIA_INFO_LOG("[MediaScannerObj::ScanDir] start, path = %{public}s", path.c_str());
@@ -184,8 +175,8 @@ int32_t MediaScannerObj::ScanDir(string &path, const sptr<IRemoteObject> &remote
     // Get Absolute path
     if (ScannerUtils::GetAbsolutePath(path) != ERR_SUCCESS) {
         MEDIA_ERR_LOG("ScanDir: Incorrect path or insufficient permission %{private}s", path.c_str());
-        // If the path is not available, clear the same from database too if present
-        CleanupDirectory(path);
+        // If the path is not available, a worker clears the same from database too if present
+        QueueScanRequest(path, isDir, true, nullptr);
         return ERR_INCORRECT_PATH;
     }
 
@@ -194,47 +185,83 @@ int32_t MediaScannerObj::ScanDir(string &path, const sptr<IRemoteObject> &remote
         return ERR_INCORRECT_PATH;
     }
 
-    std::unique_ptr<ScanRequest> scanReq = std::make_unique<ScanRequest>(path);
+    return QueueScanRequest(path, isDir, false, remoteCallback);
+}
+
+// Every scan and every cleanup of a removed path runs on the executor workers, each with its own
+// WalkContext, never on the thread asking for it
+int32_t MediaScannerObj::QueueScanRequest(const string &path, bool isDir, bool isRemoved,
+    const sptr<IRemoteObject> &remoteCallback)
+{
+    int32_t errCode = ERR_MEM_ALLOC_FAIL;
+
+    unique_ptr<ScanRequest> scanReq = make_unique<ScanRequest>(path);
     if (scanReq != nullptr) {
         scanReq->SetIsDirectory(isDir);
+        scanReq->SetIsRemoved(isRemoved);
 
         int32_t reqId = GetAvailableRequestId();
         scanReq->SetRequestId(reqId);
 
-        scanExector_.ExecuteScan(move(scanReq));
-
-        // After path validation and queue_ addition is success, add the callback object to callback map
+        // Add the callback object to callback map before queueing, a worker may finish the request right away
         sptr<IMediaScannerOperationCallback> callback = iface_cast<IMediaScannerOperationCallback>(remoteCallback);
         if (callback != nullptr) {
             StoreCallbackObjInMap(reqId, callback);
             errCode = ERR_SUCCESS;
         }
+
+        scanExector_.ExecuteScan(move(scanReq));
     }
 
     return errCode;
 }
 
-void MediaScannerObj::CleanupDirectory(const string &path)
+// Keep the library fresh between explicit scans by rescanning only the paths changed under rootPath
+int32_t MediaScannerObj::StartWatching(const string &rootPath)
 {
-    vector<int32_t> toBeDeletedIds = {};
-    unordered_set<MediaType> mediaTypeSet = {};
-    unordered_map<int32_t, MediaType> prevIdMap = {};
+    return watcher_.Start(rootPath, [this](const string &path, bool isDir) {
+        OnWatchedPathChanged(path, isDir);
+    });
+}
 
-    prevIdMap = mediaScannerDb_->GetIdsFromFilePath(path);
-    for (auto itr : prevIdMap) {
-        auto it = scannedIds_.find(itr.first);
-        if (it != scannedIds_.end()) {
-            scannedIds_.erase(it);
-        } else {
-            toBeDeletedIds.push_back(itr.first);
-            mediaTypeSet.insert(itr.second);
-        }
-    }
+void MediaScannerObj::StopWatching()
+{
+    watcher_.Stop();
+}
+
+// Called on the watcher thread, the change is only queued. Removed paths drop their stale rows
+// on a worker like any other request.
+void MediaScannerObj::OnWatchedPathChanged(const string &path, bool isDir)
+{
+    string scanPath = path;
+    bool isRemoved = (ScannerUtils::GetAbsolutePath(scanPath) != ERR_SUCCESS);
+    int32_t errCode = QueueScanRequest(scanPath, isDir, isRemoved, nullptr);
+    MEDIA_DEBUG_LOG("Watched path changed %{private}s, isDir %{public}d, ret %{public}d", path.c_str(), isDir,
+        errCode);
+}
+
+static void MarkScanned(WalkContext &context, int32_t fileId)
+{
+    lock_guard<mutex> lock(context.scannedIdsLock);
+    context.scannedIds.insert(fileId);
+}
+
+// Delete the rows that were under the scanned path before the walk and that the walk did not
+// visit. Rows written meanwhile by other requests are not in prevIds and are left alone.
+void MediaScannerObj::CleanupDirectory(WalkContext &context)
+{
+    unordered_set<MediaType> mediaTypeSet = {};
 
     // convert deleted id list to vector of strings
     vector<string> deleteIdList;
-    for (auto id : toBeDeletedIds) {
-        deleteIdList.push_back(to_string(id));
+    {
+        lock_guard<mutex> lock(context.scannedIdsLock);
+        for (const auto &itr : context.prevIds) {
+            if (context.scannedIds.find(itr.first) == context.scannedIds.end()) {
+                deleteIdList.push_back(to_string(itr.first));
+                mediaTypeSet.insert(itr.second);
+            }
+        }
     }
 
     if (!deleteIdList.empty()) {
@@ -245,28 +272,39 @@ void MediaScannerObj::CleanupDirectory(const string &path)
     for (const MediaType &mediaType : mediaTypeSet) {
         mediaScannerDb_->NotifyDatabaseChange(mediaType);
     }
-
-    scannedIds_.clear();
 }
 
-int32_t MediaScannerObj::StartBatchProcessingToDB()
+int32_t MediaScannerObj::StartBatchProcessingToDB(WalkContext &context)
 {
     unordered_set<MediaType> mediaTypeSet = {};
-    string uri = "";
-    Metadata metaData;
 
-    for (uint32_t i = 0; i < batchUpdate_.size(); i++) {
-        metaData = (Metadata)batchUpdate_[i];
-        mediaTypeSet.insert(metaData.GetFileMediaType());
+    if (batchUpdate_.empty()) {
+        return ERR_SUCCESS;
+    }
 
-        if (metaData.GetFileId() != FILE_ID_DEFAULT) {
-            uri = mediaScannerDb_->UpdateMetadata(metaData);
-            scannedIds_.insert(metaData.GetFileId());
-        } else {
-            uri = mediaScannerDb_->InsertMetadata(metaData);
-            scannedIds_.insert(mediaScannerDb_->GetIdFromUri(uri));
+    // The whole batch is written in one transaction, new rows get their ids back in order
+    vector<string> uriList = mediaScannerDb_->BatchUpsertMetadata(batchUpdate_);
+    if (find(uriList.begin(), uriList.end(), "") != uriList.end()) {
+        // One bad row rolls the whole batch back, write the rows one by one to keep the good ones
+        MEDIA_ERR_LOG("Failed to write a batch of %{public}zu files, retry row by row", batchUpdate_.size());
+        for (size_t i = 0; i < batchUpdate_.size(); i++) {
+            uriList[i] = mediaScannerDb_->BatchUpsertMetadata({ batchUpdate_[i] }).front();
+        }
+    }
+
+    int32_t errCode = ERR_SUCCESS;
+    {
+        lock_guard<mutex> lock(context.scannedIdsLock);
+        for (size_t i = 0; i < batchUpdate_.size(); i++) {
+            if (uriList[i].empty()) {
+                MEDIA_ERR_LOG("Failed to write %{private}s", batchUpdate_[i].GetFilePath().c_str());
+                errCode = ERR_FAIL;
+                continue;
+            }
+            mediaTypeSet.insert(batchUpdate_[i].GetFileMediaType());
+            // The uri carries the id the row has now, an update of a row deleted meanwhile inserts a new one
+            context.scannedIds.insert(mediaScannerDb_->GetIdFromUri(uriList[i]));
         }
-        this->mediaUri_ = uri;
     }
     batchUpdate_.clear();
 
@@ -275,34 +313,67 @@ int32_t MediaScannerObj::StartBatchProcessingToDB()
         mediaScannerDb_->NotifyDatabaseChange(mediaType);
     }
 
-    return ERR_SUCCESS;
+    if (errCode != ERR_SUCCESS) {
+        // The rows of the failed files are not in scannedIds, stop before the cleanup deletes them
+        context.errCode = errCode;
+        context.isAborted = true;
+    }
+    return errCode;
 }
 
-int32_t MediaScannerObj::StartBatchProcessIfFull()
+// Move a full local batch into batchUpdate_ and flush it. Called by the walker workers as
+// well as by the single file scan path, so the DB writes are serialized by scanLock_.
+int32_t MediaScannerObj::MergeBatch(vector<Metadata> &batch, WalkContext &context)
 {
-    if (batchUpdate_.size() >= MAX_BATCH_SIZE) {
-        return StartBatchProcessingToDB();
-    }
-    return ERR_SUCCESS;
+    lock_guard<mutex> lock(scanLock_);
+    batchUpdate_.insert(batchUpdate_.end(), make_move_iterator(batch.begin()), make_move_iterator(batch.end()));
+    batch.clear();
+    return StartBatchProcessingToDB(context);
 }
 
-int32_t MediaScannerObj::BatchUpdateRequest(Metadata &fileMetadata)
+int32_t MediaScannerObj::BatchUpdateRequest(Metadata &fileMetadata, vector<Metadata> &batch, WalkContext &context)
 {
-    batchUpdate_.push_back(fileMetadata);
-    return StartBatchProcessIfFull();
+    batch.push_back(fileMetadata);
+    if (batch.size() >= MAX_BATCH_SIZE) {
+        return MergeBatch(batch, context);
+    }
+    return ERR_SUCCESS;
 }
 
 // Check if the file entry already exists in the DB. Compare filename, size,
-// path, and modified date.
-bool MediaScannerObj::IsFileScanned(Metadata &fileMetadata)
+// path, and modified date. A directory scan passes the snapshot of its subtree so
+// unchanged files are resolved without a db query. The snapshot holds every
+// descendant, so its entry must also sit under the directory being walked.
+bool MediaScannerObj::IsFileScanned(Metadata &fileMetadata, WalkContext &context)
 {
     string filePath = fileMetadata.GetFilePath();
+    const FileSnapshotMap *snapshot = context.snapshot;
+    if (snapshot != nullptr) {
+        auto iter = snapshot->find(hash<string>()(filePath));
+        if (iter == snapshot->end()) {
+            return false;
+        }
+
+        const FileSnapshot &fileSnapshot = iter->second;
+        if (!fileSnapshot.isHashCollided) {
+            if (fileSnapshot.dateModified == fileMetadata.GetFileDateModified() &&
+                fileSnapshot.name == fileMetadata.GetFileName() &&
+                fileSnapshot.parentId == fileMetadata.GetParentId() &&
+                fileSnapshot.size == fileMetadata.GetFileSize()) {
+                MarkScanned(context, fileSnapshot.fileId);
+                return true;
+            }
+            fileMetadata.SetFileId(fileSnapshot.fileId);
+            return false;
+        }
+    }
+
     unique_ptr<Metadata> md = mediaScannerDb_->GetFileModifiedInfo(filePath);
     if (md != nullptr &&
         md->GetFileDateModified() == fileMetadata.GetFileDateModified() &&
         md->GetFileName() == fileMetadata.GetFileName() &&
         md->GetFileSize() == fileMetadata.GetFileSize()) {
-        scannedIds_.insert(md->GetFileId());
+        MarkScanned(context, md->GetFileId());
         return true;
     }
 
@@ -326,7 +397,7 @@ int32_t MediaScannerObj::RetrieveMetadata(Metadata &fileMetadata)
 }
 
 // Visit the File
-int32_t MediaScannerObj::VisitFile(const Metadata &fileMD)
+int32_t MediaScannerObj::VisitFile(const Metadata &fileMD, vector<Metadata> &batch, WalkContext &context)
 {
     StartTrace(BYTRACE_TAG_OHOS, "VisitFile");
 
@@ -339,10 +410,10 @@ int32_t MediaScannerObj::VisitFile(const Metadata &fileMD)
     supportedMimeTypes = GetSupportedMimeTypes();
     if (find(supportedMimeTypes.begin(), supportedMimeTypes.end(), mimeType) != supportedMimeTypes.end()) {
         errCode = ERR_SUCCESS;
-        if (!IsFileScanned(*fileMetadata)) {
+        if (!IsFileScanned(*fileMetadata, context)) {
             errCode = RetrieveMetadata(*fileMetadata);
             if (errCode == ERR_SUCCESS) {
-                errCode = BatchUpdateRequest(*fileMetadata);
+                errCode = BatchUpdateRequest(*fileMetadata, batch, context);
             }
         }
     }
@@ -413,14 +484,15 @@ unique_ptr<Metadata> MediaScannerObj::GetFileMetadata(const string &path, const
 
 
 // Get the internal details of the file
-int32_t MediaScannerObj::ScanFileContent(const string &path, const int32_t parentId)
+int32_t MediaScannerObj::ScanFileContent(const string &path, const int32_t parentId, vector<Metadata> &batch,
+    WalkContext &context)
 {
     unique_ptr<Metadata> fileMetadata = nullptr;
     int32_t errCode = ERR_FAIL;
 
     fileMetadata = GetFileMetadata(path, parentId);
     if (fileMetadata != nullptr) {
-        errCode = VisitFile(*fileMetadata);
+        errCode = VisitFile(*fileMetadata, batch, context);
     } else {
         MEDIA_ERR_LOG("Failed to allocate memory for file metadata");
         return ERR_MEM_ALLOC_FAIL;
@@ -442,30 +514,61 @@ int32_t MediaScannerObj::ScanFileInternal(const string &path)
 
     int32_t parentId = mediaScannerDb_->ReadAlbumId(parentFolder);
 
-    errCode = ScanFileContent(path, parentId);
+    WalkContext context;
+    vector<Metadata> batch;
+    errCode = ScanFileContent(path, parentId, batch, context);
     if (errCode == ERR_SUCCESS) {
         // to write the remaining to DB
-        errCode = StartBatchProcessingToDB();
+        errCode = MergeBatch(batch, context);
     }
 
     return errCode;
 }
 
-int32_t MediaScannerObj::InsertAlbumInfo(string &albumPath, int32_t parentId, string &albumName)
+// The file is gone, drop its row
+int32_t MediaScannerObj::RemoveFileInternal(const string &path)
+{
+    unique_ptr<Metadata> metaData = mediaScannerDb_->ReadMetadata(path);
+    if (metaData != nullptr && !metaData->GetFilePath().empty()) {
+        vector<string> idList = {to_string(metaData->GetFileId())};
+        if (mediaScannerDb_->DeleteMetadata(idList)) {
+            mediaScannerDb_->NotifyDatabaseChange(metaData->GetFileMediaType());
+        }
+    }
+
+    return ERR_INCORRECT_PATH;
+}
+
+// The directory is gone, drop its own row and the rows of everything that was under it
+int32_t MediaScannerObj::RemoveDirInternal(const string &path)
+{
+    WalkContext context;
+    context.prevIds = mediaScannerDb_->GetIdsFromFilePath(path);
+    unique_ptr<Metadata> metaData = mediaScannerDb_->ReadMetadata(path);
+    if (metaData != nullptr && !metaData->GetFilePath().empty()) {
+        context.prevIds.emplace(metaData->GetFileId(), metaData->GetFileMediaType());
+    }
+    CleanupDirectory(context);
+
+    return ERR_INCORRECT_PATH;
+}
+
+int32_t MediaScannerObj::InsertAlbumInfo(string &albumPath, int32_t parentId, string &albumName,
+    WalkContext &context)
 {
     int32_t albumId = ERR_FAIL;
 
     bool update = false;
 
-    if (albumMap_.find(albumPath) != albumMap_.end()) {
+    if (context.albumMap.find(albumPath) != context.albumMap.end()) {
         // It Exists
-        Metadata albumInfo = albumMap_.at(albumPath);
+        Metadata albumInfo = context.albumMap.at(albumPath);
         struct stat statInfo {};
         albumId = albumInfo.GetFileId();
 
         if (stat(albumPath.c_str(), &statInfo) == ERR_SUCCESS) {
             if (albumInfo.GetFileDateModified() == statInfo.st_mtime) {
-                scannedIds_.insert(albumId);
+                MarkScanned(context, albumId);
                 return albumId;
             } else {
                 update = true;
@@ -484,19 +587,89 @@ int32_t MediaScannerObj::InsertAlbumInfo(string &albumPath, int32_t parentId, st
         } else {
             albumId = mediaScannerDb_->InsertAlbum(*fileMetadata);
         }
-        scannedIds_.insert(albumId);
+        MarkScanned(context, albumId);
     }
 
     return albumId;
 }
 
-int32_t MediaScannerObj::WalkFileTree(const string &path, int32_t parentId)
+void MediaScannerObj::PushWalkTask(WalkContext &context, size_t workerIndex, WalkTask task)
+{
+    context.pendingTasks++;
+    {
+        lock_guard<mutex> lock(context.workers[workerIndex]->taskLock);
+        context.workers[workerIndex]->tasks.push_back(move(task));
+    }
+    context.idleCond.notify_one();
+}
+
+// Take the most recently pushed directory from the own deque (depth first, keeps the
+// dentry cache warm) and fall back to stealing the oldest directory of another worker
+bool MediaScannerObj::PopWalkTask(WalkContext &context, size_t workerIndex, WalkTask &task)
+{
+    auto &self = context.workers[workerIndex];
+    {
+        lock_guard<mutex> lock(self->taskLock);
+        if (!self->tasks.empty()) {
+            task = move(self->tasks.back());
+            self->tasks.pop_back();
+            return true;
+        }
+    }
+
+    size_t workerCount = context.workers.size();
+    for (size_t i = 1; i < workerCount; i++) {
+        auto &victim = context.workers[(workerIndex + i) % workerCount];
+        lock_guard<mutex> lock(victim->taskLock);
+        if (!victim->tasks.empty()) {
+            task = move(victim->tasks.front());
+            victim->tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MediaScannerObj::WalkWorkerLoop(WalkContext &context, size_t workerIndex)
+{
+    WalkTask task;
+    while (!context.isAborted) {
+        if (context.isCancelled != nullptr && *context.isCancelled) {
+            context.errCode = ERR_SCAN_CANCELLED;
+            context.isAborted = true;
+            break;
+        }
+        if (PopWalkTask(context, workerIndex, task)) {
+            int32_t errCode = WalkDirectory(context, workerIndex, task);
+            if (errCode == ERR_FAIL || errCode == ERR_MEM_ALLOC_FAIL) {
+                context.errCode = errCode;
+                context.isAborted = true;
+            }
+            if (--context.pendingTasks == 0) {
+                context.idleCond.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> lock(context.idleLock);
+        if (context.pendingTasks == 0) {
+            break;
+        }
+        context.idleCond.wait_for(lock, chrono::milliseconds(WALKER_IDLE_WAIT_MS));
+    }
+    context.idleCond.notify_all();
+}
+
+int32_t MediaScannerObj::WalkDirectory(WalkContext &context, size_t workerIndex, const WalkTask &task)
 {
     int32_t errCode = ERR_SUCCESS;
     DIR *dirPath = nullptr;
     struct dirent *ent = nullptr;
+    const string &path = task.path;
     size_t len = path.length();
     struct stat statInfo;
+    auto &batch = context.workers[workerIndex]->batch;
 
     if (len >= FILENAME_MAX - 1) {
         return ERR_INCORRECT_PATH;
@@ -519,7 +692,7 @@ int32_t MediaScannerObj::WalkFileTree(const string &path, int32_t parentId)
         return ERR_NOT_ACCESSIBLE;
     }
 
-    while ((ent = readdir(dirPath)) != nullptr && errCode != ERR_MEM_ALLOC_FAIL) {
+    while ((ent = readdir(dirPath)) != nullptr && !context.isAborted) {
         if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) {
             continue;
         }
@@ -535,16 +708,19 @@ int32_t MediaScannerObj::WalkFileTree(const string &path, int32_t parentId)
         string currentPath = fName;
         if (S_ISDIR(statInfo.st_mode)) {
             string albumName = ent->d_name;
-            int32_t albumId = InsertAlbumInfo(currentPath, parentId, albumName);
+            int32_t albumId = InsertAlbumInfo(currentPath, task.parentId, albumName, context);
             if (albumId == ERR_FAIL) {
                 errCode = ERR_FAIL;
                 break;
             }
             if (!IsDirHidden(currentPath)) {
-                errCode = WalkFileTree(currentPath, albumId);
+                PushWalkTask(context, workerIndex, { currentPath, albumId });
             }
         } else if (!ScannerUtils::IsFileHidden(currentPath)) {
-            errCode = ScanFileContent(currentPath, parentId);
+            errCode = ScanFileContent(currentPath, task.parentId, batch, context);
+            if (errCode == ERR_MEM_ALLOC_FAIL) {
+                break;
+            }
         }
     }
 
@@ -554,6 +730,44 @@ int32_t MediaScannerObj::WalkFileTree(const string &path, int32_t parentId)
     return errCode;
 }
 
+// Walk the tree with a bounded pool of workers. Every sub directory becomes a task which
+// idle workers steal, so the readdir/lstat and metadata extraction cost spreads over cores.
+int32_t MediaScannerObj::WalkFileTree(const string &path, int32_t parentId, WalkContext &context)
+{
+    uint32_t workerCount = min(max(thread::hardware_concurrency(), 1u), MAX_WALKER_THREADS);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        context.workers.push_back(make_unique<WalkWorker>());
+    }
+
+    // The skip list is read concurrently by the workers, load it before they start
+    call_once(skipListFlag_, [this]() { InitSkipList(); });
+    PushWalkTask(context, 0, { path, parentId });
+
+    vector<thread> threads;
+    for (uint32_t i = 1; i < workerCount; i++) {
+        threads.emplace_back(&MediaScannerObj::WalkWorkerLoop, this, ref(context), i);
+    }
+    WalkWorkerLoop(context, 0);
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    if (context.isAborted) {
+        return context.errCode;
+    }
+
+    for (auto &worker : context.workers) {
+        if (!worker->batch.empty()) {
+            int32_t errCode = MergeBatch(worker->batch, context);
+            if (errCode != ERR_SUCCESS) {
+                return errCode;
+            }
+        }
+    }
+
+    return ERR_SUCCESS;
+}
+
 // Initialize the skip list
 void MediaScannerObj::InitSkipList()
 {
@@ -579,9 +793,7 @@ bool MediaScannerObj::CheckSkipScanList(const string &path)
     hash<string> hashStr;
     size_t hashPath;
 
-    if (skipList_.empty()) {
-        InitSkipList();
-    }
+    call_once(skipListFlag_, [this]() { InitSkipList(); });
 
     hashPath = hashStr(path);
     if (find(skipList_.begin(), skipList_.end(), hashPath) != skipList_.end()) {
@@ -642,7 +854,7 @@ bool MediaScannerObj::IsDirHiddenRecursive(const string &path)
 }
 
 // Scan the directory path recursively
-int32_t MediaScannerObj::ScanDirInternal(const string &path)
+int32_t MediaScannerObj::ScanDirInternal(const string &path, const atomic<bool> &isCancelled)
 {
     int32_t errCode = ERR_FAIL;
 
@@ -652,35 +864,47 @@ int32_t MediaScannerObj::ScanDirInternal(const string &path)
         return ERR_NOT_ACCESSIBLE;
     }
 
-    mediaScannerDb_->ReadAlbums(path, albumMap_);
+    WalkContext context;
+    context.isCancelled = &isCancelled;
+    mediaScannerDb_->ReadAlbums(path, context.albumMap);
+    // Only the rows present before the walk may turn out stale, not the ones other requests add meanwhile
+    context.prevIds = mediaScannerDb_->GetIdsFromFilePath(path);
 
-    // Walk the folder tree
-    errCode = WalkFileTree(path, NO_PARENT);
+    // One query for the whole subtree, unchanged files then cost only a stat while walking
+    FileSnapshotMap snapshot;
+    mediaScannerDb_->ReadFileSnapshots(path, snapshot);
+    context.snapshot = &snapshot;
+
+    // Walk the folder tree, the remaining per-worker batches are written to DB before it returns.
+    // The albums it creates reach the album cache as one batch
+    MediaLibraryAlbumCache::GetInstance()->BeginBatch();
+    errCode = WalkFileTree(path, NO_PARENT, context);
+    MediaLibraryAlbumCache::GetInstance()->EndBatch();
     if (errCode == ERR_SUCCESS) {
-        // write the remaining metadata to DB
-        errCode = StartBatchProcessingToDB();
-        if (errCode == ERR_SUCCESS) {
-            CleanupDirectory(path);
-        }
+        CleanupDirectory(context);
     }
 
-    albumMap_.clear();
-
     return errCode;
 }
 
 void MediaScannerObj::ExecuteScannerClientCallback(int32_t reqId, int32_t status, const string &uri, const string &path)
 {
-    auto iter = scanResultCbMap_.find(reqId);
-    if (iter != scanResultCbMap_.end()) {
-        auto activeCb = iter->second;
-        activeCb->OnScanFinishedCallback(status, uri, path);
+    sptr<IMediaScannerOperationCallback> activeCb = nullptr;
+    {
+        lock_guard<mutex> lock(cbMapLock_);
+        auto iter = scanResultCbMap_.find(reqId);
+        if (iter == scanResultCbMap_.end()) {
+            return;
+        }
+        activeCb = iter->second;
         scanResultCbMap_.erase(iter);
     }
+    activeCb->OnScanFinishedCallback(status, uri, path);
 }
 
 void MediaScannerObj::StoreCallbackObjInMap(int32_t reqId, sptr<IMediaScannerOperationCallback>& callback)
 {
+    lock_guard<mutex> lock(cbMapLock_);
     auto itr = scanResultCbMap_.find(reqId);
     if (itr == scanResultCbMap_.end()) {
         scanResultCbMap_.insert(std::make_pair(reqId, callback));
@@ -689,7 +913,7 @@ void MediaScannerObj::StoreCallbackObjInMap(int32_t reqId, sptr<IMediaScannerOpe
 
 int32_t MediaScannerObj::GetAvailableRequestId()
 {
-    static int32_t i = 0;
+    static atomic<int32_t> i(0);
 
     return ++i;
 }
@@ -718,6 +942,7 @@ void MediaScannerObj::ReleaseAbilityHelper()
 
 bool MediaScannerObj::IsScannerRunning()
 {
+    lock_guard<mutex> lock(cbMapLock_);
     return !scanResultCbMap_.empty();
 }
 } // namespace Media
@@ -15,13 +15,17 @@
 
 #include "media_scanner_db.h"
 #include "media_log.h"
+#include "medialibrary_album_cache.h"
 #include "medialibrary_data_manager.h"
+#include "medialibrary_statement_cache.h"
+#include "rdb_utils.h"
 
 namespace OHOS {
 namespace Media {
 using namespace std;
 using namespace OHOS::NativeRdb;
 using namespace OHOS::DataShare;
+using namespace OHOS::RdbDataShareAdapter;
 
 MediaScannerDb::MediaScannerDb() {}
 
@@ -35,11 +39,8 @@ void MediaScannerDb::SetRdbHelper(void)
 {
 }
 
-string MediaScannerDb::InsertMetadata(const Metadata &metadata)
+void MediaScannerDb::SetValuesFromMetaData(const Metadata &metadata, DataShareValuesBucket &values)
 {
-    int32_t rowNum(0);
-    DataShareValuesBucket values;
-
     MediaType mediaType = metadata.GetFileMediaType();
     string mediaTypeUri = GetMediaTypeUri(mediaType);
 
@@ -65,6 +66,15 @@ string MediaScannerDb::InsertMetadata(const Metadata &metadata)
     values.PutString(MEDIA_DATA_DB_BUCKET_NAME, metadata.GetAlbumName());
     values.PutInt(MEDIA_DATA_DB_PARENT_ID, metadata.GetParentId());
     values.PutInt(MEDIA_DATA_DB_BUCKET_ID, metadata.GetParentId());
+}
+
+string MediaScannerDb::InsertMetadata(const Metadata &metadata)
+{
+    int32_t rowNum(0);
+    DataShareValuesBucket values;
+
+    string mediaTypeUri = GetMediaTypeUri(metadata.GetFileMediaType());
+    SetValuesFromMetaData(metadata, values);
 
     Uri abilityUri(MEDIALIBRARY_DATA_URI);
     rowNum = MediaLibraryDataManager::GetInstance()->Insert(abilityUri, values);
@@ -77,14 +87,40 @@ string MediaScannerDb::InsertMetadata(const Metadata &metadata)
     return (!mediaTypeUri.empty() ? (mediaTypeUri + "/" + to_string(rowNum)) : mediaTypeUri);
 }
 
-vector<string> MediaScannerDb::BatchInsert(const vector<Metadata> &metadataList)
+/**
+ * @brief Insert new and update known metadata of a whole batch in one transaction
+ *
+ * @param metadataList The metadata to write, entries with a file id update the existing row, or insert it
+ *        again when it was deleted meanwhile
+ * @return vector<string> The mediatypeUri of every entry in order, empty for entries that failed
+ */
+vector<string> MediaScannerDb::BatchUpsertMetadata(const vector<Metadata> &metadataList)
 {
-    vector<string> insertUriList;
-    for (auto itr : metadataList) {
-        insertUriList.push_back(InsertMetadata(itr));
+    vector<string> uriList(metadataList.size(), "");
+    vector<DataShareValuesBucket> valuesList;
+    for (const auto &metadata : metadataList) {
+        DataShareValuesBucket values;
+        SetValuesFromMetaData(metadata, values);
+        if (metadata.GetFileId() != FILE_ID_DEFAULT) {
+            values.PutInt(MEDIA_DATA_DB_ID, metadata.GetFileId());
+        }
+        valuesList.push_back(values);
+    }
+
+    vector<int64_t> rowIds;
+    int32_t ret = MediaLibraryDataManager::GetInstance()->BatchUpsert(valuesList, rowIds);
+    if (ret < 0 || rowIds.size() != metadataList.size()) {
+        MEDIA_ERR_LOG("MediaDataAbility BatchUpsert functionality is failed, return %{private}d", ret);
+        return uriList;
     }
 
-    return insertUriList;
+    for (size_t i = 0; i < metadataList.size(); i++) {
+        if (rowIds[i] > 0) {
+            uriList[i] = GetMediaTypeUri(metadataList[i].GetFileMediaType()) + "/" + to_string(rowIds[i]);
+        }
+    }
+
+    return uriList;
 }
 
 unique_ptr<Metadata> MediaScannerDb::ReadMetadata(const string &path)
@@ -117,33 +153,8 @@ string MediaScannerDb::UpdateMetadata(const Metadata &metadata)
     DataShare::DataSharePredicates predicates;
     predicates.SetWhereClause(MEDIA_DATA_DB_ID + " = " + FormatSqlPath(to_string(metadata.GetFileId())));
 
-    MediaType mediaType = metadata.GetFileMediaType();
-    string mediaTypeUri = GetMediaTypeUri(mediaType);
-
-    values.PutString(MEDIA_DATA_DB_URI, mediaTypeUri);
-    values.PutString(MEDIA_DATA_DB_FILE_PATH, metadata.GetFilePath());
-    values.PutString(MEDIA_DATA_DB_RELATIVE_PATH, metadata.GetRelativePath());
-
-    values.PutString(MEDIA_DATA_DB_MIME_TYPE, metadata.GetFileMimeType());
-    values.PutInt(MEDIA_DATA_DB_MEDIA_TYPE, mediaType);
-    values.PutString(MEDIA_DATA_DB_NAME, metadata.GetFileName());
-
-    values.PutLong(MEDIA_DATA_DB_SIZE, metadata.GetFileSize());
-    values.PutLong(MEDIA_DATA_DB_DATE_ADDED, metadata.GetFileDateAdded());
-    values.PutLong(MEDIA_DATA_DB_DATE_MODIFIED, metadata.GetFileDateModified());
-
-    values.PutString(MEDIA_DATA_DB_TITLE, ScannerUtils::GetFileTitle(metadata.GetFileName()));
-    values.PutString(MEDIA_DATA_DB_AUDIO_ALBUM, metadata.GetAlbum());
-    values.PutString(MEDIA_DATA_DB_ARTIST, metadata.GetFileArtist());
-
-    values.PutInt(MEDIA_DATA_DB_HEIGHT, metadata.GetFileHeight());
-    values.PutInt(MEDIA_DATA_DB_WIDTH, metadata.GetFileWidth());
-    values.PutInt(MEDIA_DATA_DB_ORIENTATION, metadata.GetOrientation());
-    values.PutInt(MEDIA_DATA_DB_DURATION, metadata.GetFileDuration());
-
-    values.PutString(MEDIA_DATA_DB_BUCKET_NAME, metadata.GetAlbumName());
-    values.PutInt(MEDIA_DATA_DB_PARENT_ID, metadata.GetParentId());
-    values.PutInt(MEDIA_DATA_DB_BUCKET_ID, metadata.GetParentId());
+    string mediaTypeUri = GetMediaTypeUri(metadata.GetFileMediaType());
+    SetValuesFromMetaData(metadata, values);
 
     Uri uri(MEDIALIBRARY_DATA_URI);
     updateCount = MediaLibraryDataManager::GetInstance()->Update(uri, values, predicates);
@@ -205,21 +216,11 @@ bool MediaScannerDb::DeleteMetadata(const vector<string> &idList)
  */
 unique_ptr<Metadata> MediaScannerDb::GetFileModifiedInfo(const string &path)
 {
-    // Columns to be returned in resultset
-    vector<string> columns = {};
-    columns.push_back(MEDIA_DATA_DB_ID);
-    columns.push_back(MEDIA_DATA_DB_SIZE);
-    columns.push_back(MEDIA_DATA_DB_DATE_MODIFIED);
-    columns.push_back(MEDIA_DATA_DB_NAME);
-
-    DataShare::DataSharePredicates predicates;
-    predicates.SetWhereClause(MEDIA_DATA_DB_FILE_PATH + " = " + FormatSqlPath(path));
-
-    Uri abilityUri(MEDIALIBRARY_DATA_URI);
-    auto resultSetBridge = MediaLibraryDataManager::GetInstance()->Query(abilityUri, columns, predicates);
-
-    CHECK_AND_RETURN_RET_LOG(resultSetBridge != nullptr, nullptr, "No result found for %{private}s", path.c_str());
-    auto resultSet = std::make_shared<DataShare::DataShareResultSet>(resultSetBridge);
+    // Selects id, size, date_modified and name with the path bound
+    auto absResultSet = MediaLibraryStatementCache::GetInstance()->Query(
+        MediaLibraryDataManager::GetInstance()->GetRdbStore(), StatementId::FILE_MODIFIED_INFO, path);
+    CHECK_AND_RETURN_RET_LOG(absResultSet != nullptr, nullptr, "No result found for %{private}s", path.c_str());
+    auto resultSet = std::make_shared<DataShare::DataShareResultSet>(RdbUtils::ToResultSetBridge(absResultSet));
 
     int ret = resultSet->GoToFirstRow();
     CHECK_AND_RETURN_RET_LOG(ret == NativeRdb::E_OK, nullptr, "Failed to fetch first record");
@@ -324,14 +325,14 @@ int32_t MediaScannerDb::ReadAlbumId(const string &path)
     int32_t albumId = 0;
     int32_t columnIndex = -1;
 
-    DataShare::DataSharePredicates predicates;
-    predicates.SetWhereClause(MEDIA_DATA_DB_FILE_PATH + " = " + FormatSqlPath(path));
+    AlbumCacheEntry album;
+    AlbumCacheResult cacheResult = MediaLibraryAlbumCache::GetInstance()->GetAlbum(path, album);
+    if (cacheResult != AlbumCacheResult::UNAVAILABLE) {
+        return (cacheResult == AlbumCacheResult::FOUND) ? album.id : albumId;
+    }
 
-    Uri uri(MEDIALIBRARY_DATA_URI);
-    vector<string> columns = {MEDIA_DATA_DB_ID};
-    auto resultSetBridge = MediaLibraryDataManager::GetInstance()->Query(uri, columns, predicates);
-    CHECK_AND_RETURN_RET_LOG(resultSetBridge != nullptr, albumId, "No result found for %{private}s", path.c_str());
-    auto resultSet = std::make_shared<DataShare::DataShareResultSet>(resultSetBridge);
+    auto resultSet = MediaLibraryStatementCache::GetInstance()->Query(
+        MediaLibraryDataManager::GetInstance()->GetRdbStore(), StatementId::ID_BY_PATH, path);
 
     if ((resultSet == nullptr) || (resultSet->GoToFirstRow() != NativeRdb::E_OK)) {
         MEDIA_ERR_LOG("MediaScannerDb:: No Data found for the given path %{private}s", path.c_str());
@@ -391,6 +392,60 @@ void MediaScannerDb::ReadAlbums(const string &path, unordered_map<string, Metada
     return;
 }
 
+/**
+ * @brief Load the id, parent, name, size and modified date of every file under a directory in one query
+ *
+ * @param path The directory whose files are about to be scanned
+ * @param snapshotMap The map to fill, keyed by the hash of the file path
+ */
+void MediaScannerDb::ReadFileSnapshots(const string &path, FileSnapshotMap &snapshotMap)
+{
+    vector<string> columns = {MEDIA_DATA_DB_ID, MEDIA_DATA_DB_PARENT_ID, MEDIA_DATA_DB_NAME, MEDIA_DATA_DB_FILE_PATH,
+        MEDIA_DATA_DB_SIZE, MEDIA_DATA_DB_DATE_MODIFIED};
+
+    DataShare::DataSharePredicates predicates;
+    // Append % to end of the path for using LIKE statement
+    auto modifiedPath = path;
+    modifiedPath = modifiedPath.back() != '/' ? modifiedPath + "/%" : modifiedPath + "%";
+    predicates.SetWhereClause(MEDIA_DATA_DB_FILE_PATH + " like " + FormatSqlPath(modifiedPath) + " AND " +
+        MEDIA_DATA_DB_MEDIA_TYPE + " <> " + to_string(static_cast<int32_t>(MediaType::MEDIA_TYPE_ALBUM)));
+
+    Uri uri(MEDIALIBRARY_DATA_URI);
+    auto resultSetBridge = MediaLibraryDataManager::GetInstance()->Query(uri, columns, predicates);
+    CHECK_AND_RETURN_LOG(resultSetBridge != nullptr, "No result found for %{private}s", path.c_str());
+    auto resultSet = std::make_shared<DataShare::DataShareResultSet>(resultSetBridge);
+
+    int32_t columnIndexId(0);
+    int32_t columnIndexParentId(0);
+    int32_t columnIndexName(0);
+    int32_t columnIndexPath(0);
+    int32_t columnIndexSize(0);
+    int32_t columnIndexDateModified(0);
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_ID, columnIndexId);
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_PARENT_ID, columnIndexParentId);
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_NAME, columnIndexName);
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_FILE_PATH, columnIndexPath);
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_SIZE, columnIndexSize);
+    resultSet->GetColumnIndex(MEDIA_DATA_DB_DATE_MODIFIED, columnIndexDateModified);
+
+    hash<string> hashStr;
+    string filePath("");
+    while (resultSet->GoToNextRow() == NativeRdb::E_OK) {
+        FileSnapshot snapshot = { 0, 0, "", 0, 0, false };
+        resultSet->GetInt(columnIndexId, snapshot.fileId);
+        resultSet->GetInt(columnIndexParentId, snapshot.parentId);
+        resultSet->GetString(columnIndexName, snapshot.name);
+        resultSet->GetString(columnIndexPath, filePath);
+        resultSet->GetLong(columnIndexSize, snapshot.size);
+        resultSet->GetLong(columnIndexDateModified, snapshot.dateModified);
+
+        auto result = snapshotMap.emplace(hashStr(filePath), snapshot);
+        if (!result.second) {
+            result.first->second.isHashCollided = true;
+        }
+    }
+}
+
 int32_t MediaScannerDb::InsertAlbum(const Metadata &metadata)
 {
     int32_t id = 0;
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "media_scanner_watcher.h"
+
+#include <cerrno>
+#include <dirent.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "media_log.h"
+#include "scanner_utils.h"
+
+namespace OHOS {
+namespace Media {
+using namespace std;
+
+namespace {
+    const uint32_t WATCH_EVENT_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+        IN_DONT_FOLLOW;
+    const size_t WATCH_FD_COUNT = 2;
+
+    bool IsHiddenName(const char *name)
+    {
+        return name[0] == '.';
+    }
+} // namespace
+
+MediaScannerWatcher::~MediaScannerWatcher()
+{
+    Stop();
+}
+
+int32_t MediaScannerWatcher::Start(const string &rootPath, ChangeCallback callback)
+{
+    if (isRunning_) {
+        MEDIA_ERR_LOG("Watcher is already running on %{private}s", rootPath_.c_str());
+        return ERR_FAIL;
+    }
+    if (rootPath.empty() || callback == nullptr) {
+        return ERR_EMPTY_ARGS;
+    }
+
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ < 0) {
+        MEDIA_ERR_LOG("inotify_init1 failed, errno %{public}d", errno);
+        return ERR_FAIL;
+    }
+    stopFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stopFd_ < 0) {
+        MEDIA_ERR_LOG("eventfd failed, errno %{public}d", errno);
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+        return ERR_FAIL;
+    }
+
+    rootPath_ = rootPath;
+    callback_ = move(callback);
+    AddWatchRecursive(rootPath_);
+    if (watchedDirs_.empty()) {
+        MEDIA_ERR_LOG("Failed to watch %{private}s", rootPath_.c_str());
+        Stop();
+        return ERR_NOT_ACCESSIBLE;
+    }
+
+    isRunning_ = true;
+    watchThread_ = thread(&MediaScannerWatcher::WatchLoop, this);
+    MEDIA_INFO_LOG("Watching %{public}d directories", static_cast<int32_t>(watchedDirs_.size()));
+    return ERR_SUCCESS;
+}
+
+void MediaScannerWatcher::Stop()
+{
+    isRunning_ = false;
+    if (stopFd_ >= 0) {
+        uint64_t value = 1;
+        if (write(stopFd_, &value, sizeof(value)) < 0) {
+            MEDIA_ERR_LOG("Failed to wake up watcher, errno %{public}d", errno);
+        }
+    }
+    if (watchThread_.joinable()) {
+        watchThread_.join();
+    }
+
+    if (inotifyFd_ >= 0) {
+        close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+    if (stopFd_ >= 0) {
+        close(stopFd_);
+        stopFd_ = -1;
+    }
+    watchedDirs_.clear();
+    pendingChanges_.clear();
+}
+
+bool MediaScannerWatcher::IsRunning() const
+{
+    return isRunning_;
+}
+
+void MediaScannerWatcher::AddWatchRecursive(const string &path)
+{
+    vector<string> dirs = { path };
+    while (!dirs.empty()) {
+        string dir = move(dirs.back());
+        dirs.pop_back();
+
+        int32_t wd = inotify_add_watch(inotifyFd_, dir.c_str(), WATCH_EVENT_MASK);
+        if (wd < 0) {
+            // ENOSPC means max_user_watches is exhausted, changes below dir are then only seen by full scans
+            MEDIA_ERR_LOG("Failed to watch %{private}s, errno %{public}d", dir.c_str(), errno);
+            continue;
+        }
+        watchedDirs_[wd] = dir;
+
+        DIR *dirPath = opendir(dir.c_str());
+        if (dirPath == nullptr) {
+            continue;
+        }
+        struct dirent *ent = nullptr;
+        struct stat statInfo;
+        while ((ent = readdir(dirPath)) != nullptr) {
+            if (IsHiddenName(ent->d_name)) {
+                continue;
+            }
+            string childPath = dir + "/" + ent->d_name;
+            if (lstat(childPath.c_str(), &statInfo) == 0 && S_ISDIR(statInfo.st_mode)) {
+                dirs.push_back(move(childPath));
+            }
+        }
+        closedir(dirPath);
+    }
+}
+
+void MediaScannerWatcher::RemoveWatchRecursive(const string &path)
+{
+    string prefix = path + "/";
+    for (auto iter = watchedDirs_.begin(); iter != watchedDirs_.end();) {
+        const string &dir = iter->second;
+        if (dir == path || dir.compare(0, prefix.length(), prefix) == 0) {
+            inotify_rm_watch(inotifyFd_, iter->first);
+            iter = watchedDirs_.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+void MediaScannerWatcher::HandleEvent(const struct inotify_event &event)
+{
+    if (event.mask & IN_Q_OVERFLOW) {
+        // Events were dropped, only a full rescan is reliable now
+        MEDIA_ERR_LOG("Watcher event queue overflow");
+        AddPendingChange(rootPath_, true);
+        return;
+    }
+
+    auto iter = watchedDirs_.find(event.wd);
+    if (iter == watchedDirs_.end()) {
+        return;
+    }
+    if (event.mask & IN_IGNORED) {
+        watchedDirs_.erase(iter);
+        return;
+    }
+    if (event.len == 0 || IsHiddenName(event.name)) {
+        return;
+    }
+
+    string path = iter->second + "/" + event.name;
+    if (event.mask & IN_ISDIR) {
+        if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+            AddWatchRecursive(path);
+        } else if (event.mask & IN_MOVED_FROM) {
+            RemoveWatchRecursive(path);
+        }
+        AddPendingChange(path, true);
+    } else if (event.mask & (IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) {
+        // A new file is reported once its writer closes it, not on IN_CREATE
+        AddPendingChange(path, false);
+    }
+}
+
+void MediaScannerWatcher::AddPendingChange(const string &path, bool isDir)
+{
+    auto now = chrono::steady_clock::now();
+    if (pendingChanges_.empty()) {
+        firstPendingTime_ = now;
+    }
+    lastPendingTime_ = now;
+
+    auto result = pendingChanges_.emplace(path, isDir);
+    if (!result.second && isDir) {
+        result.first->second = true;
+    }
+    if (pendingChanges_.size() >= WATCHER_MAX_PENDING) {
+        FlushPendingChanges();
+    }
+}
+
+// Report the settled changes. Paths below a directory that is rescanned anyway are dropped.
+void MediaScannerWatcher::FlushPendingChanges()
+{
+    unordered_map<string, bool> changes;
+    changes.swap(pendingChanges_);
+
+    for (const auto &change : changes) {
+        bool isCovered = false;
+        string parent = change.first;
+        for (size_t pos = parent.find_last_of('/'); pos != string::npos && pos > 0;
+            pos = parent.find_last_of('/')) {
+            parent.resize(pos);
+            auto iter = changes.find(parent);
+            if (iter != changes.end() && iter->second) {
+                isCovered = true;
+                break;
+            }
+        }
+        if (!isCovered) {
+            callback_(change.first, change.second);
+        }
+    }
+}
+
+// Flush once no event came in for the debounce window, or the oldest change waited too long
+int32_t MediaScannerWatcher::GetPollTimeout() const
+{
+    if (pendingChanges_.empty()) {
+        return -1;
+    }
+
+    auto deadline = min(lastPendingTime_ + chrono::milliseconds(WATCHER_DEBOUNCE_MS),
+        firstPendingTime_ + chrono::milliseconds(WATCHER_MAX_DELAY_MS));
+    auto remaining = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+    return remaining > 0 ? static_cast<int32_t>(remaining) : 0;
+}
+
+void MediaScannerWatcher::WatchLoop()
+{
+    struct pollfd fds[WATCH_FD_COUNT] = {
+        { inotifyFd_, POLLIN, 0 },
+        { stopFd_, POLLIN, 0 }
+    };
+    alignas(struct inotify_event) char buffer[WATCHER_EVENT_BUF_SIZE];
+
+    while (isRunning_) {
+        int32_t ret = poll(fds, WATCH_FD_COUNT, GetPollTimeout());
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            MEDIA_ERR_LOG("Watcher poll failed, errno %{public}d", errno);
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            ssize_t len = 0;
+            while ((len = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+                for (char *ptr = buffer; ptr < buffer + len;) {
+                    auto event = reinterpret_cast<const struct inotify_event *>(ptr);
+                    HandleEvent(*event);
+                    ptr += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+
+        if (GetPollTimeout() == 0) {
+            FlushPendingChanges();
+        }
+    }
+    isRunning_ = false;
+}
+} // namespace Media
+} // namespace OHOS
@@ -20,6 +20,199 @@ namespace OHOS {
 namespace Media {
 using namespace std;
 
+namespace {
+    const size_t PROBE_HEADER_SIZE = 32;
+    const int32_t PROBE_MAX_JPEG_SEGMENTS = 512;
+    const uint8_t JPEG_MARKER_PREFIX = 0xFF;
+    const uint8_t JPEG_SOI = 0xD8;
+    const uint8_t JPEG_SOF0 = 0xC0;
+    const uint8_t JPEG_SOF15 = 0xCF;
+    const uint8_t JPEG_DHT = 0xC4;
+    const uint8_t JPEG_JPG = 0xC8;
+    const uint8_t JPEG_DAC = 0xCC;
+    const uint8_t JPEG_RST0 = 0xD0;
+    const uint8_t JPEG_EOI = 0xD9;
+    const uint8_t JPEG_SOS = 0xDA;
+    const uint8_t JPEG_TEM = 0x01;
+    const uint8_t PNG_SIGNATURE[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    const uint8_t WEBP_VP8_START_CODE[] = { 0x9D, 0x01, 0x2A };
+    const uint8_t WEBP_VP8L_SIGNATURE = 0x2F;
+    const uint32_t BMP_CORE_HEADER_SIZE = 12;
+
+    uint32_t ReadBigEndian16(const uint8_t *buf)
+    {
+        return (static_cast<uint32_t>(buf[0]) << 8) | buf[1];
+    }
+
+    uint32_t ReadBigEndian32(const uint8_t *buf)
+    {
+        return (ReadBigEndian16(buf) << 16) | ReadBigEndian16(buf + 2);
+    }
+
+    uint32_t ReadLittleEndian16(const uint8_t *buf)
+    {
+        return (static_cast<uint32_t>(buf[1]) << 8) | buf[0];
+    }
+
+    uint32_t ReadLittleEndian24(const uint8_t *buf)
+    {
+        return (static_cast<uint32_t>(buf[2]) << 16) | ReadLittleEndian16(buf);
+    }
+
+    uint32_t ReadLittleEndian32(const uint8_t *buf)
+    {
+        return (ReadLittleEndian16(buf + 2) << 16) | ReadLittleEndian16(buf);
+    }
+
+    bool ReadFully(int32_t fd, off_t offset, uint8_t *buf, size_t size)
+    {
+        return pread(fd, buf, size, offset) == static_cast<ssize_t>(size);
+    }
+
+    bool IsJpegSofMarker(uint8_t marker)
+    {
+        return marker >= JPEG_SOF0 && marker <= JPEG_SOF15 && marker != JPEG_DHT && marker != JPEG_JPG &&
+            marker != JPEG_DAC;
+    }
+
+    // Walk the segment headers up to the first SOFn, skipping the payload of APPn, DQT, DHT...
+    bool ProbeJpegSize(int32_t fd, uint32_t &width, uint32_t &height)
+    {
+        const size_t markerSize = 2;
+        const size_t sofSize = 7;
+        off_t offset = markerSize;
+        uint8_t buf[sofSize] = { 0 };
+        for (int32_t i = 0; i < PROBE_MAX_JPEG_SEGMENTS; i++) {
+            if (!ReadFully(fd, offset, buf, markerSize) || buf[0] != JPEG_MARKER_PREFIX) {
+                return false;
+            }
+            uint8_t marker = buf[1];
+            offset += markerSize;
+            if (marker == JPEG_MARKER_PREFIX) {
+                // Fill byte, the marker code follows
+                offset--;
+                continue;
+            }
+            if (marker == JPEG_TEM || (marker >= JPEG_RST0 && marker < JPEG_EOI)) {
+                continue;
+            }
+            if (marker == JPEG_EOI || marker == JPEG_SOS) {
+                return false;
+            }
+
+            // Segment length(2) precision(1) height(2) width(2)
+            if (!ReadFully(fd, offset, buf, IsJpegSofMarker(marker) ? sofSize : markerSize)) {
+                return false;
+            }
+            if (IsJpegSofMarker(marker)) {
+                height = ReadBigEndian16(buf + 3);
+                width = ReadBigEndian16(buf + 5);
+                return true;
+            }
+            uint32_t length = ReadBigEndian16(buf);
+            if (length < markerSize) {
+                return false;
+            }
+            offset += length;
+        }
+        return false;
+    }
+
+    bool ProbeWebpSize(const uint8_t *buf, uint32_t &width, uint32_t &height)
+    {
+        const uint8_t *chunk = buf + 12;
+        const uint8_t *payload = chunk + 8;
+        if (memcmp(chunk, "VP8 ", 4) == 0) {
+            // Frame tag(3) start code(3) width(2) height(2), the top 2 bits are scaling
+            if (memcmp(payload + 3, WEBP_VP8_START_CODE, sizeof(WEBP_VP8_START_CODE)) != 0) {
+                return false;
+            }
+            width = ReadLittleEndian16(payload + 6) & 0x3FFF;
+            height = ReadLittleEndian16(payload + 8) & 0x3FFF;
+            return true;
+        }
+        if (memcmp(chunk, "VP8L", 4) == 0) {
+            // Signature(1) then 14 bits width - 1 and 14 bits height - 1
+            if (payload[0] != WEBP_VP8L_SIGNATURE) {
+                return false;
+            }
+            uint32_t bits = ReadLittleEndian32(payload + 1);
+            width = (bits & 0x3FFF) + 1;
+            height = ((bits >> 14) & 0x3FFF) + 1;
+            return true;
+        }
+        if (memcmp(chunk, "VP8X", 4) == 0) {
+            // Flags(4) then 24 bits canvas width - 1 and height - 1
+            width = ReadLittleEndian24(payload + 4) + 1;
+            height = ReadLittleEndian24(payload + 7) + 1;
+            return true;
+        }
+        return false;
+    }
+
+    bool ProbeBmpSize(const uint8_t *buf, uint32_t &width, uint32_t &height)
+    {
+        uint32_t headerSize = ReadLittleEndian32(buf + 14);
+        if (headerSize == BMP_CORE_HEADER_SIZE) {
+            width = ReadLittleEndian16(buf + 18);
+            height = ReadLittleEndian16(buf + 20);
+            return true;
+        }
+        width = ReadLittleEndian32(buf + 18);
+        // Negative height marks a top-down bitmap
+        int32_t signedHeight = static_cast<int32_t>(ReadLittleEndian32(buf + 22));
+        height = static_cast<uint32_t>(signedHeight < 0 ? -static_cast<int64_t>(signedHeight) : signedHeight);
+        return true;
+    }
+} // namespace
+
+/**
+ * @brief Read the image dimensions from the file header of JPEG, PNG, WebP, GIF and BMP
+ * files, without creating a decoder
+ *
+ * @param path The image file path
+ * @param width The width found in the header
+ * @param height The height found in the header
+ * @return bool False if the format is not recognized or the header is truncated
+ */
+bool MetadataExtractor::ProbeImageSize(const string &path, int32_t &width, int32_t &height)
+{
+    int32_t fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    uint8_t buf[PROBE_HEADER_SIZE] = { 0 };
+    uint32_t probeWidth = 0;
+    uint32_t probeHeight = 0;
+    bool isFound = false;
+    if (ReadFully(fd, 0, buf, sizeof(buf))) {
+        if (buf[0] == JPEG_MARKER_PREFIX && buf[1] == JPEG_SOI) {
+            isFound = ProbeJpegSize(fd, probeWidth, probeHeight);
+        } else if (memcmp(buf, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0 && memcmp(buf + 12, "IHDR", 4) == 0) {
+            probeWidth = ReadBigEndian32(buf + 16);
+            probeHeight = ReadBigEndian32(buf + 20);
+            isFound = true;
+        } else if (memcmp(buf, "RIFF", 4) == 0 && memcmp(buf + 8, "WEBP", 4) == 0) {
+            isFound = ProbeWebpSize(buf, probeWidth, probeHeight);
+        } else if (memcmp(buf, "GIF87a", 6) == 0 || memcmp(buf, "GIF89a", 6) == 0) {
+            probeWidth = ReadLittleEndian16(buf + 6);
+            probeHeight = ReadLittleEndian16(buf + 8);
+            isFound = true;
+        } else if (memcmp(buf, "BM", 2) == 0) {
+            isFound = ProbeBmpSize(buf, probeWidth, probeHeight);
+        }
+    }
+    (void)close(fd);
+
+    if (!isFound || probeWidth == 0 || probeHeight == 0 || probeWidth > INT32_MAX || probeHeight > INT32_MAX) {
+        return false;
+    }
+    width = static_cast<int32_t>(probeWidth);
+    height = static_cast<int32_t>(probeHeight);
+    return true;
+}
+
 int32_t MetadataExtractor::ConvertStringToInteger(const string &str)
 {
     int32_t integer = 0;
@@ -30,6 +223,15 @@ int32_t MetadataExtractor::ConvertStringToInteger(const string &str)
 
 int32_t MetadataExtractor::ExtractImageMetadata(Metadata &fileMetadata)
 {
+    int32_t width = 0;
+    int32_t height = 0;
+    if (ProbeImageSize(fileMetadata.GetFilePath(), width, height)) {
+        fileMetadata.SetFileWidth(width);
+        fileMetadata.SetFileHeight(height);
+        return ERR_SUCCESS;
+    }
+
+    // Formats the header probe does not know, such as HEIF, still go through the image source
     uint32_t errorCode = 0;
     SourceOptions opts;
     opts.formatHint = "image/" + fileMetadata.GetFileExtension();
@@ -78,6 +280,34 @@ void MetadataExtractor::FillExtractedMetadata(const std::unordered_map<int32_t,
     fileMetadata.SetFileMimeType(strTemp);
 }
 
+shared_ptr<AVMetadataHelper> MetadataExtractor::AcquireMetadataHelper()
+{
+    {
+        lock_guard<mutex> lock(helperLock_);
+        if (!idleHelpers_.empty()) {
+            auto avMetadataHelper = move(idleHelpers_.back());
+            idleHelpers_.pop_back();
+            return avMetadataHelper;
+        }
+    }
+    return AVMetadataHelperFactory::CreateAVMetadataHelper();
+}
+
+// Keep the helper for the next file, SetSource replaces its source. Helpers beyond what the
+// concurrent walkers can use are released.
+void MetadataExtractor::RecycleMetadataHelper(shared_ptr<AVMetadataHelper> &avMetadataHelper)
+{
+    {
+        lock_guard<mutex> lock(helperLock_);
+        if (idleHelpers_.size() < MAX_METADATA_HELPERS) {
+            idleHelpers_.push_back(move(avMetadataHelper));
+            return;
+        }
+    }
+    avMetadataHelper->Release();
+    avMetadataHelper = nullptr;
+}
+
 int32_t MetadataExtractor::Extract(Metadata &fileMetadata, const string &uri)
 {
     int32_t errCode = ERR_FAIL;
@@ -99,12 +329,6 @@ int32_t MetadataExtractor::Extract(Metadata &fileMetadata, const string &uri)
         return ExtractImageMetadata(fileMetadata);
     }
 
-    avMetadataHelper = AVMetadataHelperFactory::CreateAVMetadataHelper();
-    if (avMetadataHelper == nullptr) {
-        MEDIA_ERR_LOG("AV metadata helper is null");
-        return errCode;
-    }
-
     int32_t fd = open(uri.c_str(), O_RDONLY);
     if (fd <= 0) {
         MEDIA_ERR_LOG("Open file descriptor failed");
@@ -118,11 +342,20 @@ int32_t MetadataExtractor::Extract(Metadata &fileMetadata, const string &uri)
         return errCode;
     }
 
+    avMetadataHelper = AcquireMetadataHelper();
+    if (avMetadataHelper == nullptr) {
+        MEDIA_ERR_LOG("AV metadata helper is null");
+        (void)close(fd);
+        return errCode;
+    }
+
     int64_t length = static_cast<int64_t>(st.st_size);
     errCode = avMetadataHelper->SetSource(fd, 0, length, AV_META_USAGE_META_ONLY);
     if (errCode != ERR_SUCCESS) {
         MEDIA_ERR_LOG("SetSource failed for the given file descriptor");
         (void)close(fd);
+        // The helper state is unknown after a failed SetSource, do not hand it out again
+        avMetadataHelper->Release();
         return errCode;
     } else {
         metadataMap = avMetadataHelper->ResolveMetadata();
@@ -132,7 +365,7 @@ int32_t MetadataExtractor::Extract(Metadata &fileMetadata, const string &uri)
     }
 
     (void)close(fd);
-    avMetadataHelper->Release();
+    RecycleMetadataHelper(avMetadataHelper);
     return ERR_SUCCESS;
 }
 } // namespace Media
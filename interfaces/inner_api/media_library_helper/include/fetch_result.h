@@ -17,6 +17,7 @@
 #define INTERFACES_INNERKITS_NATIVE_INCLUDE_FETCH_RESULT_H_
 
 #include <variant>
+#include <vector>
 #include "abs_shared_result_set.h"
 #include "file_asset.h"
 #include "media_lib_service_const.h"
@@ -54,16 +55,34 @@ public:
     std::unique_ptr<FileAsset> GetNextObject();
     std::unique_ptr<FileAsset> GetLastObject();
     std::unique_ptr<FileAsset> GetObject();
+    std::vector<std::unique_ptr<FileAsset>> GetObjectRange(int32_t offset, int32_t count);
+
+    // Projection for queries whose rows are decoded into FileAssets, every other column would be read for nothing
+    static const std::vector<std::string> &GetFileAssetColumns();
+
+    std::shared_ptr<DataShare::DataShareResultSet> GetResultSet() const;
+    // The column positions resolved for the previous result set are dropped
+    void SetResultSet(const std::shared_ptr<DataShare::DataShareResultSet> &resultset);
 
     bool isContain_;
     bool isClosed_;
     int32_t count_;
     std::string networkId_;
-    std::shared_ptr<OHOS::DataShare::DataShareResultSet> resultset_ = nullptr;
 
 private:
-    std::variant<int32_t, int64_t, std::string> GetRowValFromColumnn(std::string columnName,
-                                                                     ResultSetDataType dataType);
+    std::shared_ptr<OHOS::DataShare::DataShareResultSet> resultset_ = nullptr;
+
+    // Positions of the FileAsset columns in resultset_, one per entry of the decoding tables
+    struct ColumnIndexes {
+        bool isResolved = false;
+        std::vector<int32_t> int32Columns;
+        std::vector<int32_t> int64Columns;
+        std::vector<int32_t> stringColumns;
+    };
+
+    const ColumnIndexes &GetColumnIndexes();
+
+    ColumnIndexes columnIndexes_;
 };
 } // namespace Media
 } // namespace OHOS
@@ -33,13 +33,21 @@ const int32_t DATA_ABILITY_MODIFY_DATA_FAIL = -100000;
 const int32_t ALBUM_OPERATION_ERR = -1;
 const int32_t FILE_OPERATION_ERR = -1;
 const int32_t DEFAULT_PRIVATEALBUMTYPE = -1;
+// Every schema change takes the next unused version, bumps MEDIA_RDB_VERSION to it and registers
+// an upgrade step for it. Versions up to MEDIA_RDB_VERSION_NEW are already taken.
+const int32_t MEDIA_RDB_VERSION_INIT = 1;
+const int32_t MEDIA_RDB_VERSION_NEW = 5;
+const int32_t MEDIA_RDB_VERSION_FILES_INDEX = 6;
+const int32_t MEDIA_RDB_VERSION_ALBUM_COVER = 7;
+const int32_t MEDIA_RDB_VERSION_ALBUM_STATS = 8;
+const int32_t MEDIA_RDB_VERSION_ALBUM_STATS_TRIGGERS = 9;
 #ifdef RDB_UPGRADE_MOCK
-const int32_t MEDIA_RDB_VERSION = 2;
+const int32_t MEDIA_RDB_VERSION_UPGRADE_MOCK = 10;
+const int32_t MEDIA_RDB_VERSION = MEDIA_RDB_VERSION_UPGRADE_MOCK;
 #else
-const int32_t MEDIA_RDB_VERSION = 1;
+const int32_t MEDIA_RDB_VERSION = MEDIA_RDB_VERSION_ALBUM_STATS_TRIGGERS;
 #endif
 static const std::string MEDIA_LIBRARY_VERSION = "1.0";
-const int32_t MEDIA_RDB_VERSION_NEW = 5;
 const int32_t MEDIA_SMARTALBUM_RDB_VERSION = 1;
 const int32_t MEDIA_SMARTALBUMMAP_RDB_VERSION = 1;
 const int32_t DEVICE_OPERATION_ERR = -1;
@@ -132,6 +140,8 @@ static const std::string MEDIA_DATA_DB_ALBUM = "album";
 static const std::string MEDIA_DATA_DB_ALBUM_ID = "album_id";
 static const std::string MEDIA_DATA_DB_ALBUM_NAME = "album_name";
 static const std::string MEDIA_DATA_DB_COUNT = "count";
+static const std::string MEDIA_DATA_DB_COVER_ID = "cover_id";
+static const std::string MEDIA_DATA_DB_COVER_MEDIA_TYPE = "cover_media_type";
 
 // ringtone uri constants
 static const std::string MEDIA_DATA_DB_RINGTONE_URI = "ringtone_uri";
@@ -176,6 +186,28 @@ static const std::string CREATE_MEDIA_TABLE = "CREATE TABLE IF NOT EXISTS " + ME
                                        + MEDIA_DATA_DB_URI + " TEXT, "
                                        + MEDIA_DATA_DB_ALBUM + " TEXT)";
 
+// Indexes for the hot Files lookups: path/parent resolution in the scanner and file operations,
+// per-album listing and counting, and the media type / trash filters sorted by date
+static const std::string CREATE_FILES_DATA_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_data ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_FILE_PATH + ")";
+static const std::string CREATE_FILES_PARENT_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_parent ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_PARENT_ID + ")";
+static const std::string CREATE_FILES_BUCKET_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_bucket ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_BUCKET_ID + ", "
+                                       + MEDIA_DATA_DB_MEDIA_TYPE + ", " + MEDIA_DATA_DB_DATE_TRASHED + ", "
+                                       + MEDIA_DATA_DB_DATE_ADDED + ")";
+static const std::string CREATE_FILES_MEDIA_TYPE_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_media_type ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_MEDIA_TYPE + ", "
+                                       + MEDIA_DATA_DB_DATE_TRASHED + ", " + MEDIA_DATA_DB_DATE_ADDED + ")";
+static const std::string CREATE_FILES_RELATIVE_PATH_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_relative_path ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_RELATIVE_PATH + ")";
+static const std::string CREATE_FILES_DATE_TRASHED_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_date_trashed ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_DATE_TRASHED + ")";
+static const std::string CREATE_FILES_DATE_ADDED_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_date_added ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_DATE_ADDED + ")";
+static const std::string CREATE_FILES_DATE_MODIFIED_INDEX = "CREATE INDEX IF NOT EXISTS idx_files_date_modified ON "
+                                       + MEDIALIBRARY_TABLE + " (" + MEDIA_DATA_DB_DATE_MODIFIED + ")";
+
 static const std::string CREATE_IMAGE_VIEW = "CREATE VIEW Image AS SELECT "
                                       + MEDIA_DATA_DB_ID + ", "
                                       + MEDIA_DATA_DB_FILE_PATH + ", "
@@ -241,12 +273,47 @@ static const std::string CREATE_AUDIO_VIEW = "CREATE VIEW Audio AS SELECT "
                                       + MEDIA_DATA_DB_MEDIA_TYPE + " = 5";
 
 static const std::string FILE_TABLE = "file";
+// Per album statistics kept up to date by triggers on Files and SmartAlbumMap, so that listing albums
+// reads one row per album instead of aggregating over every file. Bucket rows are keyed by
+// (bucket_id, media_type) like the Album view, smart album rows use MEDIA_TYPE_SMARTALBUM.
+// count and size only cover files that are not trashed, total counts every member and the row is
+// dropped once it reaches zero. cover_id is the member with the latest date_added.
+const int32_t ALBUM_STATS_TYPE_BUCKET = 0;
+const int32_t ALBUM_STATS_TYPE_SMART = 1;
+static const std::string ALBUM_STATS_TABLE = "AlbumStats";
+static const std::string ALBUM_STATS_NAME = "stats";
+static const std::string ALBUM_STATS_DB_TYPE = "stats_type";
+static const std::string ALBUM_STATS_DB_ALBUM_ID = "album_id";
+static const std::string ALBUM_STATS_DB_TOTAL = "total";
+static const std::string ALBUM_STATS_DB_LATEST_DATE_ADDED = "latest_date_added";
+static const std::string CREATE_ALBUM_STATS_TABLE = "CREATE TABLE IF NOT EXISTS " + ALBUM_STATS_TABLE + " ("
+                                      + ALBUM_STATS_DB_TYPE + " INT NOT NULL, "
+                                      + ALBUM_STATS_DB_ALBUM_ID + " INT NOT NULL, "
+                                      + MEDIA_DATA_DB_MEDIA_TYPE + " INT NOT NULL, "
+                                      + MEDIA_DATA_DB_COUNT + " INT NOT NULL DEFAULT 0, "
+                                      + ALBUM_STATS_DB_TOTAL + " INT NOT NULL DEFAULT 0, "
+                                      + MEDIA_DATA_DB_SIZE + " BIGINT NOT NULL DEFAULT 0, "
+                                      + ALBUM_STATS_DB_LATEST_DATE_ADDED + " BIGINT NOT NULL DEFAULT 0, "
+                                      + MEDIA_DATA_DB_COVER_ID + " INT NOT NULL DEFAULT 0, "
+                                      + "PRIMARY KEY (" + ALBUM_STATS_DB_TYPE + ", " + ALBUM_STATS_DB_ALBUM_ID + ", "
+                                      + MEDIA_DATA_DB_MEDIA_TYPE + "))";
+
 static const std::string ABLUM_TABLE = "album";
+static const std::string COVER_TABLE = "cover";
 static const std::string ABLUM_VIEW_NAME = "Album";
+// Latest added asset of every bucket, picked in the album query itself rather than one query per album
+static const std::string ABLUM_COVER_JOIN = " LEFT JOIN (SELECT "
+                                      + MEDIA_DATA_DB_BUCKET_ID + ", "
+                                      + MEDIA_DATA_DB_ID + " AS " + MEDIA_DATA_DB_COVER_ID + ", "
+                                      + MEDIA_DATA_DB_MEDIA_TYPE + " AS " + MEDIA_DATA_DB_COVER_MEDIA_TYPE + ", "
+                                      + "MAX(" + MEDIA_DATA_DB_DATE_ADDED + ") FROM ";
+static const std::string ABLUM_COVER_JOIN_ON = " GROUP BY " + MEDIA_DATA_DB_BUCKET_ID + ") " + COVER_TABLE
+                                      + " ON " + COVER_TABLE + "." + MEDIA_DATA_DB_BUCKET_ID + " = "
+                                      + ABLUM_TABLE + "." + MEDIA_DATA_DB_ID;
+static const std::string ABLUM_COVER_COLUMNS = COVER_TABLE + "." + MEDIA_DATA_DB_COVER_ID + ", "
+                                      + COVER_TABLE + "." + MEDIA_DATA_DB_COVER_MEDIA_TYPE;
 static const std::string CREATE_ABLUM_VIEW = "CREATE VIEW " + ABLUM_VIEW_NAME
-                                      + " AS SELECT count( " + FILE_TABLE + "."
-                                      + MEDIA_DATA_DB_DATE_TRASHED + "= 0 OR NULL) AS "
-                                      + MEDIA_DATA_DB_COUNT + ", "
+                                      + " AS SELECT " + ALBUM_STATS_NAME + "." + MEDIA_DATA_DB_COUNT + ", "
                                       + ABLUM_TABLE + "." + MEDIA_DATA_DB_RELATIVE_PATH + ", "
                                       + ABLUM_TABLE + "." + MEDIA_DATA_DB_ID + " AS "
                                       + MEDIA_DATA_DB_BUCKET_ID + ", "
@@ -258,22 +325,18 @@ static const std::string CREATE_ABLUM_VIEW = "CREATE VIEW " + ABLUM_VIEW_NAME
                                       + ABLUM_TABLE + "." + MEDIA_DATA_DB_DATE_ADDED + ", "
                                       + ABLUM_TABLE + "." + MEDIA_DATA_DB_DATE_MODIFIED + ", "
                                       + ABLUM_TABLE + "." + MEDIA_DATA_DB_THUMBNAIL + ", "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_MEDIA_TYPE + ", "
-                                      + ABLUM_TABLE + "." + MEDIA_DATA_DB_SELF_ID
-                                      + " FROM Files " + FILE_TABLE + ", "
-                                      + " Files " + ABLUM_TABLE
+                                      + ALBUM_STATS_NAME + "." + MEDIA_DATA_DB_MEDIA_TYPE + ", "
+                                      + ABLUM_TABLE + "." + MEDIA_DATA_DB_SELF_ID + ", "
+                                      + ALBUM_STATS_NAME + "." + MEDIA_DATA_DB_COVER_ID + ", "
+                                      + ALBUM_STATS_NAME + "." + MEDIA_DATA_DB_MEDIA_TYPE + " AS "
+                                      + MEDIA_DATA_DB_COVER_MEDIA_TYPE
+                                      + " FROM " + ALBUM_STATS_TABLE + " " + ALBUM_STATS_NAME + ", "
+                                      + MEDIALIBRARY_TABLE + " " + ABLUM_TABLE
                                       + " WHERE "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_BUCKET_ID + " = "
-                                      + ABLUM_TABLE + "." + MEDIA_DATA_DB_ID + " AND "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_MEDIA_TYPE + " <> "
-                                      + std::to_string(MEDIA_TYPE_ALBUM) + " AND "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_MEDIA_TYPE + " <> "
-                                      + std::to_string(MEDIA_TYPE_FILE)
-                                      + " GROUP BY "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_BUCKET_ID +", "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_BUCKET_NAME + ", "
-                                      + FILE_TABLE + "." + MEDIA_DATA_DB_MEDIA_TYPE + ", "
-                                      + ABLUM_TABLE + "." + MEDIA_DATA_DB_SELF_ID;
+                                      + ALBUM_STATS_NAME + "." + ALBUM_STATS_DB_TYPE + " = "
+                                      + std::to_string(ALBUM_STATS_TYPE_BUCKET) + " AND "
+                                      + ABLUM_TABLE + "." + MEDIA_DATA_DB_ID + " = "
+                                      + ALBUM_STATS_NAME + "." + ALBUM_STATS_DB_ALBUM_ID;
 static const std::string DISTRIBUTED_ABLUM_COLUMNS = "SELECT count( " + FILE_TABLE + "."
                                                + MEDIA_DATA_DB_DATE_TRASHED + "= 0 OR NULL) AS "
                                                + MEDIA_DATA_DB_COUNT + ", "
@@ -289,7 +352,8 @@ static const std::string DISTRIBUTED_ABLUM_COLUMNS = "SELECT count( " + FILE_TAB
                                                + ABLUM_TABLE + "." + MEDIA_DATA_DB_DATE_MODIFIED + ", "
                                                + ABLUM_TABLE + "." + MEDIA_DATA_DB_THUMBNAIL + ", "
                                                + FILE_TABLE + "." + MEDIA_DATA_DB_MEDIA_TYPE + ", "
-                                               + ABLUM_TABLE + "." + MEDIA_DATA_DB_SELF_ID;
+                                               + ABLUM_TABLE + "." + MEDIA_DATA_DB_SELF_ID + ", "
+                                               + ABLUM_COVER_COLUMNS;
 static const std::string DISTRIBUTED_ABLUM_WHERE_AND_GROUPBY = " WHERE "
                                                         + FILE_TABLE + "." + MEDIA_DATA_DB_BUCKET_ID + " = "
                                                         + ABLUM_TABLE + "." + MEDIA_DATA_DB_ID + " AND "
@@ -375,23 +439,24 @@ static const std::string CATEGORY_SMARTALBUMMAP_TABLE_NAME = "categorySmartAlbum
 static const std::string SMARTABLUMASSETS_VIEW_NAME = "SmartAlbumAssets";
 static const std::string SMARTABLUMASSETS_ALBUMCAPACITY = "albumCapacity";
 static const std::string CREATE_SMARTABLUMASSETS_VIEW = "CREATE VIEW " + SMARTABLUMASSETS_VIEW_NAME
-                        + " AS SELECT COUNT(" + MEDIALIBRARY_TABLE + "."+ MEDIA_DATA_DB_DATE_TRASHED + " = 0"
-                        + " OR NULL ) AS " + SMARTABLUMASSETS_ALBUMCAPACITY + ", "
+                        + " AS SELECT IFNULL(" + ALBUM_STATS_NAME + "." + MEDIA_DATA_DB_COUNT + ", 0) AS "
+                        + SMARTABLUMASSETS_ALBUMCAPACITY + ", "
                         + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_ID + ", "
                         + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_NAME + ", "
                         + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_SELF_ID + ", "
                         + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_ALBUM_TYPE + ", "
-                        + SMARTALBUM_MAP_TABLE + "." + SMARTALBUMMAP_DB_ID
-                        + " FROM " + SMARTALBUM_TABLE +" "+SMARTALBUM_TABLE_NAME
-                        + " LEFT JOIN " + SMARTALBUM_MAP_TABLE
-                        + " ON " + SMARTALBUM_MAP_TABLE + "." + SMARTALBUMMAP_DB_ALBUM_ID + " = "
-                        + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_ID
-                        + " LEFT JOIN " + MEDIALIBRARY_TABLE
-                        + " ON " + SMARTALBUM_MAP_TABLE + "." + SMARTALBUMMAP_DB_ASSET_ID + " = "
-                        + MEDIALIBRARY_TABLE + "." + MEDIA_DATA_DB_ID
-                        + " GROUP BY IFNULL( " + SMARTALBUM_MAP_TABLE + "." + SMARTALBUMMAP_DB_ALBUM_ID + ", "
-                        + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_ID + " ), "
-                        + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_SELF_ID;
+                        + ALBUM_STATS_NAME + "." + MEDIA_DATA_DB_COVER_ID
+                        + " FROM " + SMARTALBUM_TABLE + " " + SMARTALBUM_TABLE_NAME
+                        + " LEFT JOIN " + ALBUM_STATS_TABLE + " " + ALBUM_STATS_NAME
+                        + " ON " + ALBUM_STATS_NAME + "." + ALBUM_STATS_DB_TYPE + " = "
+                        + std::to_string(ALBUM_STATS_TYPE_SMART) + " AND "
+                        + ALBUM_STATS_NAME + "." + ALBUM_STATS_DB_ALBUM_ID + " = "
+                        + SMARTALBUM_TABLE_NAME + "." + SMARTALBUM_DB_ID;
+static const std::string CREATE_SMARTALBUMMAP_ALBUM_INDEX = "CREATE INDEX IF NOT EXISTS idx_smartalbummap_album ON "
+                        + SMARTALBUM_MAP_TABLE + " (" + SMARTALBUMMAP_DB_ALBUM_ID + ")";
+static const std::string CREATE_SMARTALBUMMAP_ASSET_INDEX = "CREATE INDEX IF NOT EXISTS idx_smartalbummap_asset ON "
+                        + SMARTALBUM_MAP_TABLE + " (" + SMARTALBUMMAP_DB_ASSET_ID + ", "
+                        + SMARTALBUMMAP_DB_ALBUM_ID + ")";
 static const std::string ASSETMAP_VIEW_NAME = "AssetMap";
 static const std::string CREATE_ASSETMAP_VIEW = "CREATE VIEW " + ASSETMAP_VIEW_NAME
                         + " AS SELECT * FROM "
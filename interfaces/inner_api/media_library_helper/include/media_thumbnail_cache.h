@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2021 Huawei Device Co., Ltd.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INTERFACES_INNERKITS_NATIVE_INCLUDE_MEDIA_THUMBNAIL_CACHE_H_
+#define INTERFACES_INNERKITS_NATIVE_INCLUDE_MEDIA_THUMBNAIL_CACHE_H_
+
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "pixel_map.h"
+
+namespace OHOS {
+namespace Media {
+// Decoded bytes kept in the process, room for 128 thumbnails of 256 x 256
+static constexpr size_t THUMBNAIL_CACHE_CAPACITY = 32 * 1024 * 1024;
+
+struct ThumbnailCacheCounters {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Entries dropped to stay within the byte budget
+    uint64_t evictions = 0;
+    // Entries dropped because their uri got a new thumbnail key
+    uint64_t invalidations = 0;
+    size_t bytes = 0;
+    size_t entries = 0;
+};
+
+// Decoded thumbnails by thumbnail key and requested size, least recently used dropped first.
+// Callers get their own copy of a cached PixelMap, so the cached one is never handed out.
+class MediaThumbnailCache {
+public:
+    static MediaThumbnailCache *GetInstance();
+
+    explicit MediaThumbnailCache(size_t capacity = THUMBNAIL_CACHE_CAPACITY) : capacity_(capacity) {}
+    ~MediaThumbnailCache() = default;
+
+    // A copy of the cached thumbnail, nullptr on a miss
+    std::unique_ptr<PixelMap> Get(const std::string &key, const Size &size);
+    // Caches a copy of pixelMap, dropping the thumbnails cached for uri under an older key
+    void Put(const std::string &key, const Size &size, const std::string &uri, PixelMap &pixelMap);
+    void Clear();
+
+    ThumbnailCacheCounters GetCounters();
+    void ResetCounters();
+
+private:
+    using EntryKey = std::tuple<std::string, int32_t, int32_t>;
+    struct Entry {
+        EntryKey entryKey;
+        std::string uri;
+        std::shared_ptr<PixelMap> pixelMap;
+        size_t bytes = 0;
+    };
+
+    std::list<Entry>::iterator Erase(std::list<Entry>::iterator iter);
+
+    const size_t capacity_;
+    std::mutex lock_;
+    // Most recently used first
+    std::list<Entry> entries_;
+    std::map<EntryKey, std::list<Entry>::iterator> index_;
+    size_t bytes_ = 0;
+
+    std::atomic<uint64_t> hits_ {0};
+    std::atomic<uint64_t> misses_ {0};
+    std::atomic<uint64_t> evictions_ {0};
+    std::atomic<uint64_t> invalidations_ {0};
+};
+} // namespace Media
+} // namespace OHOS
+#endif // INTERFACES_INNERKITS_NATIVE_INCLUDE_MEDIA_THUMBNAIL_CACHE_H_
@@ -666,6 +666,28 @@ declare namespace mediaLibrary {
      * @return A Promise instance used to return the file in the format of a FileAsset instance.
      */
     getPositionObject(index: number): Promise<FileAsset>;
+    /**
+     * Obtains at most count FileAssets starting at offset in the file retrieval result.
+     * Only the requested rows are read, so large results can be shown page by page.
+     * This method uses a callback to return the files.
+     * @since 9
+     * @syscap SystemCapability.Multimedia.MediaLibrary.Core
+     * @param offset Index of the first file to obtain.
+     * @param count Maximum number of files to obtain.
+     * @param callback Callback used to return a FileAsset array, empty when offset is past the last file.
+     */
+    getObjectRange(offset: number, count: number, callback: AsyncCallback<Array<FileAsset>>): void;
+    /**
+     * Obtains at most count FileAssets starting at offset in the file retrieval result.
+     * Only the requested rows are read, so large results can be shown page by page.
+     * This method uses a promise to return the files.
+     * @since 9
+     * @syscap SystemCapability.Multimedia.MediaLibrary.Core
+     * @param offset Index of the first file to obtain.
+     * @param count Maximum number of files to obtain.
+     * @return A Promise instance used to return a FileAsset array, empty when offset is past the last file.
+     */
+    getObjectRange(offset: number, count: number): Promise<Array<FileAsset>>;
      /**
      * Obtains all FileAssets in the file retrieval result.
      * This method uses a callback to return the result. After this method is called, 
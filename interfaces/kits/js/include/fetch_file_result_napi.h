@@ -50,6 +50,7 @@ private:
     static napi_value JSGetLastObject(napi_env env, napi_callback_info info);
     static napi_value JSGetPositionObject(napi_env env, napi_callback_info info);
     static napi_value JSGetAllObject(napi_env env, napi_callback_info info);
+    static napi_value JSGetObjectRange(napi_env env, napi_callback_info info);
     static napi_value JSClose(napi_env env, napi_callback_info info);
 
     napi_env env_;
@@ -69,6 +70,7 @@ public:
     FetchFileResultNapi* objectInfo;
     bool status;
     int32_t position;
+    int32_t rangeCount;
     std::unique_ptr<FileAsset> fileAsset;
     std::vector<std::unique_ptr<FileAsset>> fileAssetArray;
 };